@@ -0,0 +1,352 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../dna/dna.h"
+#include "../dna/string_btree.h"
+#include "../wavelet_tree/bitvector.hpp"
+#include "../wavelet_tree/compr_num_buf.hpp"
+#include "../wavelet_tree/wavelet_tree.hpp"
+
+/*
+    Micro-benchmarks of core kernels on synthetic DNA of several sizes. Data is built once per
+    size in temp directory. Results are written as JSON to bench_kernels.json, if
+    --benchmark_out is not given, so runs can be compared by compare.py of google-benchmark
+*/
+
+namespace {
+
+constexpr unsigned c_seed = 0xEDA;
+
+// Random queries are taken by index & mask, so their generation is out of timed loop
+constexpr std::size_t c_num_queries = 1 << 12;
+constexpr std::size_t c_queries_mask = c_num_queries - 1;
+
+constexpr str_len_t c_pattern_len = 32;
+constexpr u8 c_wt_d = 4;
+
+using SbtT = DNA_SBT::StringBTree<DnaSymb>;
+using PtT = DNA_PT::PT<DnaSymb>;
+
+// Random DNA text with repeats (for long LCP), its SA of d = 1 and 4, SBT of d = 1 and WT over
+// reversed BWT of d = 4, as in blocked search
+class SyntheticData {
+public:
+    SyntheticData(std::size_t text_size)
+        : m_dir{std::filesystem::temp_directory_path() /
+                ("bench_kernels_" + std::to_string(getpid()) + "_" + std::to_string(text_size))} {
+        std::filesystem::create_directories(m_dir);
+
+        std::mt19937_64 gen{c_seed};
+        std::string text(text_size, 'A');
+        for (auto& symb : text) {
+            symb = "ACTG"[gen() % 4];
+        }
+        for (std::size_t i = 0; i + 200 < text_size; i += 1000) {
+            text.replace(i + 100, 60, text.substr(i, 60));
+        }
+        std::ofstream{TextPath()} << text;
+
+        BuildCompressedDnaFromTextDna(TextPath(), CompPath());
+        BuildSuffArrayFromComprDna(CompPath(), SaPath());
+        BuildSuffArrayFromComprDna(CompPath(), SaPath(c_wt_d), c_wt_d);
+
+        m_dna_file_holder = std::make_unique<ObjectFileHolder>(CompPath());
+        SbtT::Build(SbtPath(), Dna(), SaPath());
+        m_sbt = std::make_unique<SbtT>(SbtPath());
+        m_sa_file_holder = std::make_unique<ObjectFileHolder>(SaPath());
+        m_sa_d_file_holder = std::make_unique<ObjectFileHolder>(SaPath(c_wt_d));
+
+        const auto rev_bwt = RevBwt();
+        const std::size_t alph_size = std::size_t{1} << (DnaSymbBitSize * c_wt_d);
+        auto build_info = WaveletTree::PrepareBuild(rev_bwt, alph_size);
+        m_wt_buf.resize(build_info.CalcOccupiedSize());
+        new (m_wt_buf.data()) WaveletTree{rev_bwt, alph_size, build_info};
+    }
+
+    ~SyntheticData() {
+        m_sbt.reset();
+        m_dna_file_holder.reset();
+        m_sa_file_holder.reset();
+        m_sa_d_file_holder.reset();
+        std::filesystem::remove_all(m_dir);
+    }
+
+    // Data of text_size is built on first call
+    static const SyntheticData& Get(std::size_t text_size) {
+        static std::map<std::size_t, std::unique_ptr<SyntheticData>> datas;
+        auto& data = datas[text_size];
+        if (!data) {
+            data = std::make_unique<SyntheticData>(text_size);
+        }
+        return *data;
+    }
+
+    DnaDataAccessor Dna() const {
+        return {*m_dna_file_holder};
+    }
+    const ObjectFileHolder& DnaFileHolder() const noexcept {
+        return *m_dna_file_holder;
+    }
+    const str_pos_t* SuffArr(u8 d = 1) const noexcept {
+        return (const str_pos_t*)(d == 1 ? m_sa_file_holder : m_sa_d_file_holder)->cbegin();
+    }
+    SbtT& Sbt() const noexcept {
+        return *m_sbt;
+    }
+    ReverseBWTDnaSeqAccessor<c_wt_d> RevBwt() const {
+        return {DnaSeqDataAccessor<c_wt_d>{*m_dna_file_holder}, SuffArr(c_wt_d)};
+    }
+    const WaveletTree& Wt() const noexcept {
+        return *(const WaveletTree*)m_wt_buf.data();
+    }
+
+    // Substrings of text of pattern_len at random positions
+    std::vector<DnaBuffer> GenPatterns(str_len_t pattern_len) const {
+        std::mt19937_64 gen{c_seed};
+        const auto dna = Dna();
+
+        std::vector<DnaBuffer> patterns;
+        patterns.reserve(c_num_queries);
+        for (std::size_t i = 0; i < c_num_queries; ++i) {
+            const str_pos_t pos = gen() % (dna.Size() - pattern_len);
+            patterns.emplace_back(dna, pos, pos + pattern_len);
+        }
+        return patterns;
+    }
+
+private:
+    std::string TextPath() const {
+        return m_dir / "dna";
+    }
+    std::string CompPath() const {
+        return TextPath() + ".comp";
+    }
+    std::string SaPath(u8 d = 1) const {
+        return CompPath() + (d == 1 ? ".sa" : ".sa" + std::to_string(d));
+    }
+    std::string SbtPath() const {
+        return CompPath() + ".sbt";
+    }
+
+    std::filesystem::path m_dir;
+    std::unique_ptr<ObjectFileHolder> m_dna_file_holder;
+    std::unique_ptr<ObjectFileHolder> m_sa_file_holder;
+    std::unique_ptr<ObjectFileHolder> m_sa_d_file_holder;
+    std::unique_ptr<SbtT> m_sbt;
+    std::vector<u8> m_wt_buf;
+};
+
+std::vector<std::size_t> GenPositions(std::size_t size) {
+    std::mt19937_64 gen{c_seed};
+    std::vector<std::size_t> poss(c_num_queries);
+    for (auto& pos : poss) {
+        pos = gen() % size;
+    }
+    return poss;
+}
+
+void SetItems(benchmark::State& state) {
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ReadDnaSymb(benchmark::State& state) {
+    const auto& data = SyntheticData::Get(state.range(0));
+    const u8* dna_data = data.Dna().data();
+    const auto poss = GenPositions(data.Dna().Size());
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ReadDnaSymb(dna_data, poss[i++ & c_queries_mask]));
+    }
+    SetItems(state);
+}
+
+void BM_InsertDnaSymb(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    std::vector<u8> dna_data(DivUp(DnaSymbBitSize * size, 8) + sizeof(uint64_t));
+    const auto poss = GenPositions(size);
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const auto pos = poss[i++ & c_queries_mask];
+        InsertDnaSymb(dna_data.data(), pos, DnaSymb(1 + pos % 4));
+        benchmark::ClobberMemory();
+    }
+    SetItems(state);
+}
+
+template <u8 d>
+void BM_DnaSeqDataAccessor(benchmark::State& state) {
+    const auto& data = SyntheticData::Get(state.range(0));
+    DnaSeqDataAccessor<d> dna{data.DnaFileHolder()};
+    const auto poss = GenPositions(dna.Size());
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dna[poss[i++ & c_queries_mask]]);
+    }
+    SetItems(state);
+}
+
+void BM_BitVectorGetRank(benchmark::State& state) {
+    const BitVector::size_t size = state.range(0);
+    BitVectorBuffer bv_buf{size};
+    auto& bv = *new (bv_buf.Data()) BitVector{size};
+
+    std::mt19937_64 gen{c_seed};
+    for (BitVector::size_t i_word = 0; i_word < DivUp(size, 64u); ++i_word) {
+        bv.SetWord(i_word, gen());
+    }
+    bv.Reinit();
+
+    const auto poss = GenPositions(size);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bv.GetRank(poss[i++ & c_queries_mask]));
+    }
+    SetItems(state);
+}
+
+void BM_CompressedNumberBufGet(benchmark::State& state) {
+    const std::size_t size = state.range(0);
+    const u8 bit_len = 20;
+    std::vector<u8> place(CompressedNumberBuf::CalcOccupiedSize(bit_len, size));
+    auto& buf = *new (place.data()) CompressedNumberBuf{bit_len, size};
+
+    std::mt19937_64 gen{c_seed};
+    for (std::size_t pos = 0; pos < size; ++pos) {
+        buf.Set(pos, gen() & ((1u << bit_len) - 1));
+    }
+
+    const auto poss = GenPositions(size);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buf.Get(poss[i++ & c_queries_mask]));
+    }
+    SetItems(state);
+}
+
+// One leaf of SBT with suffixes evenly sampled from SA, so blind search reads whole text
+void BM_PTSearch(benchmark::State& state) {
+    const auto& data = SyntheticData::Get(state.range(0));
+    const auto dna = data.Dna();
+    const str_pos_t* suff_arr = data.SuffArr();
+
+    std::vector<u8> block(g_block_size);
+    auto* node = new (block.data()) SbtT::LeafNode;
+    const str_len_t num_str = std::min<str_len_t>(SbtT::LeafNode::num_leaves, dna.Size());
+
+    std::vector<std::pair<str_pos_t, in_blk_pos_t>> strs(num_str);
+    auto* ext_poss = node->ExtBegin();
+    for (str_len_t i = 0; i < num_str; ++i) {
+        ext_poss[i].str_pos = suff_arr[std::size_t(i) * dna.Size() / num_str];
+        strs[i] = {(str_pos_t)ext_poss[i].str_pos, node->GetPTPos((u8*)&ext_poss[i].str_pos)};
+    }
+    SbtT::EmplacePT<true>(node, dna, strs);
+
+    const auto pattern_bufs = data.GenPatterns(c_pattern_len);
+    std::vector<DnaDataAccessor> patterns;
+    for (const auto& pattern_buf : pattern_bufs) {
+        patterns.push_back(pattern_buf.GetAccessor());
+    }
+
+    const auto pt = node->GetPT();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PtT::SearchRange(patterns[i++ & c_queries_mask], pt.GetRoot(),
+                                                  0, pt.GetExtPos(), dna));
+    }
+    SetItems(state);
+}
+
+void BM_StringBTreeSearch(benchmark::State& state) {
+    const auto& data = SyntheticData::Get(state.range(0));
+    const auto dna = data.Dna();
+    auto& sbt = data.Sbt();
+
+    const auto pattern_bufs = data.GenPatterns(c_pattern_len);
+    std::vector<DnaDataAccessor> patterns;
+    for (const auto& pattern_buf : pattern_bufs) {
+        patterns.push_back(pattern_buf.GetAccessor());
+    }
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sbt.Search(patterns[i++ & c_queries_mask], dna));
+    }
+    SetItems(state);
+}
+
+// Left part of k < d symbols in short SA interval, as in blocked search
+void BM_WaveletTreeGetFirstRank(benchmark::State& state) {
+    const auto& data = SyntheticData::Get(state.range(0));
+    const auto rev_bwt = data.RevBwt();
+    const auto& wt = data.Wt();
+
+    std::mt19937_64 gen{c_seed};
+    std::vector<WaveletTree::FirstRankQuery> queries(c_num_queries);
+    for (auto& query : queries) {
+        const WaveletTree::size_t l_pos = gen() % rev_bwt.Size();
+        const WaveletTree::size_t r_pos =
+            std::min<WaveletTree::size_t>(l_pos + 1 + gen() % 64, rev_bwt.Size());
+        query = {(WaveletTree::size_t)rev_bwt[gen() % rev_bwt.Size()],
+                 u8(DnaSymbBitSize * (1 + gen() % (c_wt_d - 1))), l_pos, r_pos};
+    }
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const auto& query = queries[i++ & c_queries_mask];
+        benchmark::DoNotOptimize(
+            wt.GetFirstRank(query.val, query.signif_bit_len, query.l_pos, query.r_pos));
+    }
+    SetItems(state);
+}
+
+void TextSizes(benchmark::internal::Benchmark* bench) {
+    bench->RangeMultiplier(16)->Range(1 << 16, 1 << 24);
+}
+
+}  // namespace
+
+BENCHMARK(BM_ReadDnaSymb)->Apply(TextSizes);
+BENCHMARK(BM_InsertDnaSymb)->Apply(TextSizes);
+BENCHMARK(BM_DnaSeqDataAccessor<2>)->Apply(TextSizes);
+BENCHMARK(BM_DnaSeqDataAccessor<4>)->Apply(TextSizes);
+BENCHMARK(BM_DnaSeqDataAccessor<8>)->Apply(TextSizes);
+BENCHMARK(BM_BitVectorGetRank)->Apply(TextSizes);
+BENCHMARK(BM_CompressedNumberBufGet)->Apply(TextSizes);
+BENCHMARK(BM_PTSearch)->Apply(TextSizes);
+BENCHMARK(BM_StringBTreeSearch)->Apply(TextSizes);
+BENCHMARK(BM_WaveletTreeGetFirstRank)->Apply(TextSizes);
+
+int main(int argc, char** argv) {
+    std::vector<char*> args(argv, argv + argc);
+
+    bool has_out = false;
+    for (std::string_view arg : args) {
+        has_out |= arg.starts_with("--benchmark_out=");
+    }
+
+    std::string out_arg = "--benchmark_out=bench_kernels.json";
+    std::string format_arg = "--benchmark_out_format=json";
+    if (!has_out) {
+        args.push_back(out_arg.data());
+        args.push_back(format_arg.data());
+    }
+
+    int num_args = args.size();
+    benchmark::Initialize(&num_args, args.data());
+    if (benchmark::ReportUnrecognizedArguments(num_args, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+}
@@ -77,6 +77,36 @@ void MakeZeroTerminated(std::string_view text_path) {
     }
 }
 
+void AdviseMemory(const void* begin, uint64_t size, int advice) {
+    if (size == 0) {
+        return;
+    }
+
+    // madvise accept only page aligned address
+    const uint64_t page_size = sysconf(_SC_PAGESIZE);
+    const uint64_t addr = (uint64_t)begin;
+    const uint64_t addr_aligned = addr - addr % page_size;
+
+    if (madvise((void*)addr_aligned, size + (addr - addr_aligned), advice) == -1) {
+        perror("madvise");
+        throw std::runtime_error{"Failed to advise memory"};
+    }
+}
+
+void EvictFileCache(std::string_view path) {
+    FileDescGuard fd_guard = OpenFile(path, O_RDONLY);
+
+    // Dirty pages of just built file are not dropped
+    if (fdatasync(fd_guard.Get()) == -1) {
+        perror("fdatasync");
+        throw std::runtime_error{"Failed to sync file: " + std::string{path}};
+    }
+    if (int err = posix_fadvise(fd_guard.Get(), 0, 0, POSIX_FADV_DONTNEED); err != 0) {
+        throw std::runtime_error{"Failed to evict file from page cache: " + std::string{path} +
+                                 ", error " + std::to_string(err)};
+    }
+}
+
 FileMapperRead::FileMapperRead(std::string_view path) {
     FileDescGuard fd_guard = OpenFile(path, O_RDONLY);
     m_size = GetFileSizeAndSetToBegin(fd_guard);
@@ -90,7 +120,7 @@ FileMapperRead::~FileMapperRead() {
 
 FileMapperWrite::FileMapperWrite(std::string_view path, std::size_t size)
     : m_size{size}
-    , m_fd{OpenFile(path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR)} {
+    , m_fd{OpenFile(path, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)} {
     TruncateFile(m_fd, m_size);
     m_data = (u8*)MapFile(m_fd, m_size, PROT_WRITE, MAP_SHARED);
 }
@@ -39,6 +39,9 @@ uint64_t GetFileSizeAndSetToBegin(const FileDescGuard& fd_guard);
 uint64_t Lseek64(const FileDescGuard& fd_guard, uint64_t offset, int whence);
 void TruncateFile(const FileDescGuard& fd_guard, uint64_t new_size);
 void MakeZeroTerminated(std::string_view text_path);
+void AdviseMemory(const void* begin, uint64_t size, int advice);
+// Drops clean pages of file from page cache, pages that are mapped by some process are kept
+void EvictFileCache(std::string_view path);
 
 class FileMapperRead {
 public:
@@ -66,6 +69,7 @@ private:
     uint64_t m_size;
 };
 
+// Existing file is truncated, so mapped memory is zero filled
 class FileMapperWrite {
 public:
     FileMapperWrite(std::string_view path, std::size_t size);
@@ -1,29 +1,20 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <bit>
 
 template <typename T>
 T misalign_load(const u8* data) noexcept {
-    union {
-        uint8_t arr[sizeof(T)];
-        T val;
-    } value;
-
-    for (std::size_t i = 0; i < sizeof(T); ++i) {
-        value.arr[i] = data[i];
-    }
-
-    return value.val;
+    // One unaligned load instead of byte loop
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
 }
 
 template <typename T>
 void misalign_store(u8* dest, T value) noexcept {
-    u8* value_arr = (u8*)&value;
-
-    for (std::size_t i = 0; i < sizeof(T); ++i) {
-        dest[i] = value_arr[i];
-    }
+    std::memcpy(dest, &value, sizeof(T));
 }
 
 template <typename T, typename U>
@@ -36,6 +27,10 @@ constexpr U Log2Up(U value) noexcept {
     return 8 * sizeof(value) - std::countl_zero(value);
 }
 
-static size_t AlignPos(size_t pos) noexcept {
+inline size_t AlignPos(size_t pos) noexcept {
     return 8 * DivUp(pos, 8);
-};
+}
+
+inline size_t AlignPos(size_t pos, size_t alignment) noexcept {
+    return alignment * DivUp(pos, alignment);
+}
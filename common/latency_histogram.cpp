@@ -0,0 +1,66 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <sstream>
+
+std::size_t LatencyHistogram::GetBucket(uint64_t value) noexcept {
+    if (value < c_sub_count) {
+        return value;
+    }
+
+    // value >> shift is in [c_sub_count / 2, c_sub_count)
+    const unsigned shift = std::bit_width(value) - c_sub_bits;
+    return shift * (c_sub_count / 2) + (value >> shift);
+}
+
+uint64_t LatencyHistogram::GetBucketHighest(std::size_t bucket) noexcept {
+    if (bucket < c_sub_count) {
+        return bucket;
+    }
+
+    const unsigned shift = bucket / (c_sub_count / 2) - 1;
+    const uint64_t sub_bucket = bucket - shift * (c_sub_count / 2);
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value) noexcept {
+    ++m_counts[GetBucket(value)];
+    ++m_count;
+    m_sum += value;
+    m_max = std::max(m_max, value);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) noexcept {
+    for (std::size_t i = 0; i < c_num_buckets; ++i) {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_max = std::max(m_max, other.m_max);
+}
+
+uint64_t LatencyHistogram::GetPercentile(double percentile) const noexcept {
+    const uint64_t rank = std::max<uint64_t>(1, std::ceil(percentile / 100 * m_count));
+
+    uint64_t num_values = 0;
+    for (std::size_t i = 0; i < c_num_buckets; ++i) {
+        num_values += m_counts[i];
+        if (num_values >= rank) {
+            return std::min(GetBucketHighest(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+std::string LatencyHistogram::FormatMicros() const {
+    std::ostringstream out;
+    out << "mean: " << GetMean() / 1'000;
+    for (auto [name, percentile] : {std::pair{"p50", 50.0}, std::pair{"p90", 90.0},
+                                    std::pair{"p99", 99.0}, std::pair{"p99.9", 99.9}}) {
+        out << ", " << name << ": " << GetPercentile(percentile) / 1'000.0;
+    }
+    out << ", max: " << m_max / 1'000.0;
+    return out.str();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/*
+    HDR-style histogram of latencies in nanoseconds. Values below 2^c_sub_bits are exact, above
+    every power of two is split into 2^(c_sub_bits - 1) linear buckets, so relative error of
+    percentile is below 2^(1 - c_sub_bits) (< 1.6%) for whole range of uint64_t and memory is
+    fixed. Record is O(1), histograms of threads are merged after run
+*/
+class LatencyHistogram {
+public:
+    constexpr static unsigned c_sub_bits = 7;
+
+    void Record(uint64_t value) noexcept;
+    void Merge(const LatencyHistogram& other) noexcept;
+
+    uint64_t GetCount() const noexcept {
+        return m_count;
+    }
+    uint64_t GetMax() const noexcept {
+        return m_max;
+    }
+    double GetMean() const noexcept {
+        return m_count ? double(m_sum) / m_count : 0;
+    }
+
+    // Highest value of bucket, where percentile (0, 100] is reached, but not more then max
+    uint64_t GetPercentile(double percentile) const noexcept;
+
+    // "mean: .., p50: .., p90: .., p99: .., p99.9: .., max: .." in microseconds
+    std::string FormatMicros() const;
+
+private:
+    constexpr static uint64_t c_sub_count = uint64_t{1} << c_sub_bits;
+    constexpr static std::size_t c_num_buckets = (64 - c_sub_bits + 2) * c_sub_count / 2;
+
+    static std::size_t GetBucket(uint64_t value) noexcept;
+    static uint64_t GetBucketHighest(std::size_t bucket) noexcept;
+
+    std::array<uint64_t, c_num_buckets> m_counts{};
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_max = 0;
+};
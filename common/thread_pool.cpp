@@ -0,0 +1,102 @@
+#include "thread_pool.h"
+
+namespace {
+
+// Pool and queue of worker, that runs on current thread
+thread_local const ThreadPool* t_pool = nullptr;
+thread_local std::size_t t_i_queue = 0;
+
+}  // namespace
+
+ThreadPool::ThreadPool(unsigned num_threads)
+    : m_queues(std::max(num_threads, 1u)) {
+    m_threads.reserve(m_queues.size());
+    for (std::size_t i = 0; i < m_queues.size(); ++i) {
+        m_threads.emplace_back([this, i] { WorkerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{m_wake_mutex};
+        m_is_stopped = true;
+    }
+    m_wake_cv.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+std::size_t ThreadPool::GetWorkerIndex() noexcept {
+    return t_i_queue;
+}
+
+bool ThreadPool::IsWorker() const noexcept {
+    return t_pool == this;
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    // Task is counted before it is visible to thieves, so counter does not go below zero
+    std::size_t i_queue = 0;
+    {
+        std::lock_guard lock{m_wake_mutex};
+        i_queue = IsWorker() ? t_i_queue : m_next_queue++ % m_queues.size();
+        ++m_num_pending;
+    }
+
+    {
+        auto& queue = m_queues[i_queue];
+        std::lock_guard lock{queue.mutex};
+        queue.tasks.push_back(std::move(task));
+    }
+    m_wake_cv.notify_one();
+}
+
+bool ThreadPool::TryRun(std::size_t i_queue) {
+    for (std::size_t i = 0; i < m_queues.size(); ++i) {
+        auto& queue = m_queues[(i_queue + i) % m_queues.size()];
+
+        std::function<void()> task;
+        {
+            std::lock_guard lock{queue.mutex};
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (i == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+
+        {
+            std::lock_guard lock{m_wake_mutex};
+            --m_num_pending;
+        }
+        task();
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::WorkerLoop(std::size_t i_queue) {
+    t_pool = this;
+    t_i_queue = i_queue;
+
+    while (true) {
+        if (TryRun(i_queue)) {
+            continue;
+        }
+
+        // Pending tasks are finished before stop
+        std::unique_lock lock{m_wake_mutex};
+        m_wake_cv.wait(lock, [this] { return m_is_stopped || m_num_pending > 0; });
+        if (m_is_stopped && m_num_pending == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+    Work-stealing thread pool: every worker has its own deque of tasks. Worker takes its newest
+    task and, if its deque is empty, steals the oldest task of other workers, so uneven tasks do
+    not leave workers idle. Tasks of outside threads are spread round-robin, tasks submitted by
+    worker go to its own deque
+*/
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned num_threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned GetNumThreads() const noexcept {
+        return m_threads.size();
+    }
+
+    // Index of worker in [0, num_threads), that runs current task
+    static std::size_t GetWorkerIndex() noexcept;
+
+    // Task must not throw, exceptions are passed by ParallelFor
+    void Submit(std::function<void()> task);
+
+    // func(begin, end) for chunks of [0, size) by grain_size items, waits for all of them.
+    // Worker, that calls it, runs tasks while waiting. First exception of func is rethrown
+    template <typename FuncT>
+    void ParallelFor(std::size_t size, std::size_t grain_size, FuncT&& func);
+
+private:
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Newest task of queue i_queue or oldest task of other queues
+    bool TryRun(std::size_t i_queue);
+    bool IsWorker() const noexcept;
+    void WorkerLoop(std::size_t i_queue);
+
+    std::vector<Queue> m_queues;
+    std::vector<std::thread> m_threads;
+    std::size_t m_next_queue = 0;
+
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake_cv;
+    std::size_t m_num_pending = 0;  // Under m_wake_mutex
+    bool m_is_stopped = false;
+};
+
+template <typename FuncT>
+void ThreadPool::ParallelFor(std::size_t size, std::size_t grain_size, FuncT&& func) {
+    grain_size = std::max<std::size_t>(grain_size, 1);
+
+    // State lives until last chunk is finished, chunk releases it under mutex
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    std::size_t num_left = (size + grain_size - 1) / grain_size;
+    std::exception_ptr exc;
+
+    for (std::size_t begin = 0; begin < size; begin += grain_size) {
+        const std::size_t end = std::min(begin + grain_size, size);
+        Submit([&, begin, end] {
+            std::exception_ptr chunk_exc;
+            try {
+                func(begin, end);
+            } catch (...) {
+                chunk_exc = std::current_exception();
+            }
+
+            std::lock_guard lock{mutex};
+            if (chunk_exc && !exc) {
+                exc = chunk_exc;
+            }
+            if (--num_left == 0) {
+                done_cv.notify_all();
+            }
+        });
+    }
+
+    // Nothing to steal means that all chunks are taken and will be finished by others
+    if (IsWorker()) {
+        while (TryRun(GetWorkerIndex())) {
+            std::lock_guard lock{mutex};
+            if (num_left == 0) {
+                break;
+            }
+        }
+    }
+
+    std::unique_lock lock{mutex};
+    done_cv.wait(lock, [&] { return num_left == 0; });
+    if (exc) {
+        std::rethrow_exception(exc);
+    }
+}
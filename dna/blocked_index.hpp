@@ -0,0 +1,445 @@
+#pragma once
+
+#include "blocking_cost_model.h"
+#include "dna.h"
+#include "string_btree.h"
+#include "wavelet_tree_on_disk.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/*
+    Index of blocking d over compressed text: SA and SBT of d-blocks and, for d > 1, WT over
+    reversed BWT of d-blocks, that checks left parts of unaligned occurrences. Files of index
+    are named by NameGenerator next to text
+*/
+
+constexpr u8 c_max_block_size = BlockingCostModel::c_max_d;
+
+inline void CheckBlockSize(u8 block_size) {
+    if (block_size == 0) {
+        throw std::invalid_argument{"Block size \"d\" must be greater 0"};
+    }
+}
+
+class NameGenerator {
+public:
+    NameGenerator(std::string text_path, u8 block_size /* d */)
+        : m_compressed_text{text_path + ".comp"}
+        , m_suffix_array{m_compressed_text + ".sa"}
+        , m_string_btree{m_compressed_text + ".sbt"}
+        , m_wavelet_tree{m_compressed_text + ".wt"}
+        , m_fm_index{m_compressed_text + ".fm"}
+        , m_r_index{m_compressed_text + ".ri"}
+        , m_cost_model{m_compressed_text + ".cost"}
+        , m_documents{m_compressed_text + ".docs"}
+        , m_document_index{m_compressed_text + ".dl"} {
+        CheckBlockSize(block_size);
+        if (block_size > 1) {
+            auto block_size_ext = ".d" + std::to_string(block_size);
+            m_suffix_array += block_size_ext;
+            m_string_btree += block_size_ext;
+            m_wavelet_tree += block_size_ext;
+            m_fm_index += block_size_ext;
+            m_r_index += block_size_ext;
+            m_document_index += block_size_ext;
+        }
+    }
+
+    const std::string& GetCompressedTextPath() const noexcept {
+        return m_compressed_text;
+    }
+    const std::string& GetSuffixArrayPath() const noexcept {
+        return m_suffix_array;
+    }
+    const std::string& GetStringBTreePath() const noexcept {
+        return m_string_btree;
+    }
+    const std::string& GetWaveletTreePath() const {
+        return m_wavelet_tree;
+    }
+    const std::string& GetFMIndexPath() const noexcept {
+        return m_fm_index;
+    }
+    const std::string& GetRIndexPath() const noexcept {
+        return m_r_index;
+    }
+    // Cost model of indexes of all d
+    const std::string& GetCostModelPath() const noexcept {
+        return m_cost_model;
+    }
+    const std::string& GetDocumentsPath() const noexcept {
+        return m_documents;
+    }
+    const std::string& GetDocumentIndexPath() const noexcept {
+        return m_document_index;
+    }
+
+private:
+    std::string m_compressed_text;
+    std::string m_suffix_array;
+    std::string m_string_btree;
+    std::string m_wavelet_tree;
+    std::string m_fm_index;
+    std::string m_r_index;
+    std::string m_cost_model;
+    std::string m_documents;
+    std::string m_document_index;
+};
+
+// lambda.template operator()<d>() for d, that is known only at runtime
+template <typename LambdaT>
+void DispatchBlockSize(u8 block_size, LambdaT&& lambda) {
+    const bool is_dispatched = [&]<u8... is>(std::integer_sequence<u8, is...>) {
+        return ((block_size == is + 1 && (lambda.template operator()<is + 1>(), true)) || ...);
+    }(std::make_integer_sequence<u8, c_max_block_size>{});
+
+    if (!is_dispatched) {
+        throw std::invalid_argument{"Block size \"d\" must be in [1, " +
+                                    std::to_string(c_max_block_size) +
+                                    "]: " + std::to_string(block_size)};
+    }
+}
+
+// SA, SBT and, for d > 1, WT of blocking d. Compressed text must be built with d_max, that is
+// multiple of d. WT is built over codes of d-mers, that occur in text, instead of all 8^d numbers
+template <u8 block_size>
+void BuildBlockedIndex(const std::string& text_path) {
+    NameGenerator name_gen{text_path, block_size};
+    const auto& dna_compr_path = name_gen.GetCompressedTextPath();
+    const auto& suff_arr_path = name_gen.GetSuffixArrayPath();
+    const auto& sbt_path = name_gen.GetStringBTreePath();
+
+    BuildSuffArrayFromComprDna(dna_compr_path, suff_arr_path, block_size);
+
+    ObjectFileHolder dna_file_holder{dna_compr_path};
+    if constexpr (block_size == 1) {
+        DNA_SBT::StringBTree<DnaSymb>::Build(sbt_path, DnaDataAccessor{dna_file_holder},
+                                             suff_arr_path);
+    } else {
+        DnaSeqDataAccessor<block_size> dna{dna_file_holder};
+        DNA_SBT::StringBTree<DnaSymbSeq<block_size>>::Build(sbt_path, dna, suff_arr_path);
+
+        ObjectFileHolder suff_arr_holder{suff_arr_path};
+        ReverseBWTDnaSeqAccessor rev_num_dna{dna, (const str_pos_t*)suff_arr_holder.cbegin()};
+        const std::size_t rev_num_alph_size = std::size_t{1} << (DnaSymbBitSize * block_size);
+        CompactWaveletTreeOnDisk::Build(name_gen.GetWaveletTreePath(), rev_num_dna,
+                                        rev_num_alph_size);
+    }
+}
+
+// Warm: measured run follows untimed run over the same queries. Cold: files of index are
+// evicted from page cache before measured run, so they must not be mapped at that moment
+enum class CacheMode { Warm, Cold };
+
+// Files, that are read by BlockedSearcher of d
+inline void EvictBlockedIndexCache(const std::string& text_path, u8 block_size) {
+    const NameGenerator name_gen{text_path, block_size};
+    EvictFileCache(name_gen.GetCompressedTextPath());
+    EvictFileCache(name_gen.GetStringBTreePath());
+    if (block_size > 1) {
+        EvictFileCache(name_gen.GetWaveletTreePath());
+    }
+}
+
+template <u8 d>
+// Left pattern, right pattern padded by TERM and by DnaSymbMaxPad, number of pad symbols
+std::tuple<DnaSymbSeq<d>, DnaBuffer, DnaBuffer, std::size_t> GetLeftRightPattern(
+    const std::string& str, std::size_t k) {
+    assert(k < d);
+    assert(str.size() > d);
+
+    DnaSymbSeq<d> left_patt;
+    for (u8 i = 0; i < d; ++i) {
+        DnaSymb symb = DnaSymb::A;
+        if (i < k) {
+            auto [getted_symb, is_good] = ConvertTextDnaSymb2DnaSymb(str[k - 1 - i]);
+            if (!is_good) {
+                throw std::invalid_argument{"Incorect pattern"};
+            }
+            symb = getted_symb;
+        }
+        left_patt.Set(symb, i);
+    }
+
+    auto right_patt_str = str.substr(k);
+
+    std::size_t num_term_symb = 0;
+
+    const bool is_pattern_div_d = right_patt_str.size() % d == 0;
+    if (!is_pattern_div_d) {
+        str_len_t add_size = d - right_patt_str.size() % d;
+        right_patt_str.resize(right_patt_str.size() + add_size);
+
+        for (str_pos_t i = right_patt_str.size() - add_size; i < right_patt_str.size(); ++i) {
+            right_patt_str[i] = '\0';
+        }
+
+        num_term_symb = add_size;
+    }
+
+    DnaBuffer right_patt_buf_d1{right_patt_str};
+    if (right_patt_buf_d1.GetAccessor().Size() % d) {
+        std::cout << right_patt_buf_d1.GetAccessor().Size() << std::endl;
+        throw std::runtime_error{"Too strange"};
+    }
+
+    DnaBuffer right_patt_upper_buf_d1 = right_patt_buf_d1;
+    for (std::size_t i = right_patt_str.size() - num_term_symb; i < right_patt_str.size(); ++i) {
+        right_patt_upper_buf_d1.Set(i, DnaSymbMaxPad);
+    }
+
+    return {left_patt, right_patt_buf_d1, right_patt_upper_buf_d1, num_term_symb};
+}
+
+// Existence search of pattern by indexes of blocking d: SBT for d = 1; for d > 1 one batched
+// SBT descent of right parts of all offsets k, that reads node of level once for all k and
+// stops on first hit, and WT queries of left parts of all k by one fused descent over codes of
+// d-mers. Pattern is prepared before search, so preparation may be excluded from latency. Search
+// is const and does not write, so one searcher (its mapped text, SBT and WT) may be shared by
+// threads
+template <u8 block_size>
+class BlockedSearcher {
+public:
+    using DnaAccessorT =
+        std::conditional_t<block_size == 1, DnaDataAccessor, DnaSeqDataAccessor<block_size>>;
+    using SbtT = std::conditional_t<block_size == 1, DNA_SBT::StringBTree<DnaSymb>,
+                                    DNA_SBT::StringBTree<DnaSymbSeq<block_size>>>;
+
+    // Left pattern, right pattern, its upper bound and number of pad symbols for every k
+    using Query = std::conditional_t<
+        block_size == 1, DnaBuffer,
+        std::vector<std::tuple<DnaSymbSeq<block_size>, DnaBuffer, DnaBuffer, std::size_t>>>;
+
+    BlockedSearcher(const NameGenerator& name_gen)
+        : m_dna_file_holder{name_gen.GetCompressedTextPath()}
+        , m_dna{m_dna_file_holder}
+        , m_sbt{name_gen.GetStringBTreePath()} {
+        if constexpr (block_size > 1) {
+            m_wt_file.emplace(name_gen.GetWaveletTreePath());
+        }
+    }
+
+    static Query Prepare(const std::string& pattern_str) {
+        if constexpr (block_size == 1) {
+            return DnaBuffer{pattern_str};
+        } else {
+            Query query;
+            query.reserve(block_size);
+            for (std::size_t k = 0; k < block_size; ++k) {
+                query.emplace_back(GetLeftRightPattern<block_size>(pattern_str, k));
+            }
+            return query;
+        }
+    }
+
+    bool Contains(const Query& query) const {
+        if constexpr (block_size == 1) {
+            const auto pattern = query.GetAccessor();
+            return m_sbt.Search(pattern, m_dna).lcp == pattern.Size();
+        } else {
+            // Right patterns of all k descend SBT together. Right pattern without pad is its own
+            // upper bound, so its bounds share node searches
+            std::vector<DnaSeqDataAccessor<block_size>> right_patterns, right_patterns_upper;
+            right_patterns.reserve(block_size);
+            right_patterns_upper.reserve(block_size);
+            typename SbtT::template BatchQuery<DnaSeqDataAccessor<block_size>>
+                sbt_queries[block_size];
+            for (std::size_t k = 0; k < block_size; ++k) {
+                const auto& [left_pattern, right_patt_buf_d1, right_patt_upper_buf_d1,
+                             num_term_symb] = query[k];
+                auto right_dna_d1 = right_patt_buf_d1.GetAccessor();
+                right_patterns.emplace_back(right_dna_d1.data(), right_dna_d1.Size() / block_size);
+                right_patterns_upper.emplace_back(right_patt_upper_buf_d1.GetAccessor().data(),
+                                                  right_dna_d1.Size() / block_size);
+                sbt_queries[k] = {&right_patterns[k],
+                                  num_term_symb ? &right_patterns_upper[k] : &right_patterns[k]};
+            }
+
+            // Hit is confirmed by text: right pattern with its unaligned tail is found and, if
+            // k > 0, left pattern is before the first found suffix. Else hit is found by WT
+            auto is_hit = [&](std::size_t k, const typename SbtT::SearchResult& res) {
+                const auto& [left_pattern, right_patt_buf_d1, right_patt_upper_buf_d1,
+                             num_term_symb] = query[k];
+                const auto& right_pattern = right_patterns[k];
+                if (num_term_symb == 0) {
+                    if (res.lcp != right_pattern.Size()) {
+                        return false;
+                    }
+                } else {
+                    if (res.lcp != right_pattern.Size() - 1) {
+                        return false;
+                    }
+
+                    auto patt_tail = right_pattern[res.lcp];
+                    auto dna_tail = m_dna[res.str_pos + res.lcp];
+                    for (std::size_t i = 0; i < block_size - num_term_symb; ++i) {
+                        if (patt_tail[i] != dna_tail[i]) {
+                            return false;
+                        }
+                    }
+                }
+
+                if (k == 0) {
+                    return true;
+                }
+                if (res.str_pos == 0) {
+                    return false;
+                }
+
+                auto dna_prev = m_dna[res.str_pos - 1];
+                for (std::size_t i = 0; i < k; ++i) {
+                    if (left_pattern[i] != dna_prev[block_size - 1 - i]) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            typename SbtT::SearchResult results[block_size];
+            auto batch_res =
+                m_sbt.SearchBatch(sbt_queries, block_size, m_dna, results, is_hit);
+            if (batch_res.i_hit != block_size) {
+                return true;
+            }
+
+            CompactWaveletTree::FirstRankQuery wt_queries[block_size];
+            for (std::size_t k = 0; k < block_size; ++k) {
+                const auto left_pattern_num = DnaSeq2Number(std::get<0>(query[k]));
+                wt_queries[k] = {(CompactWaveletTree::size_t)left_pattern_num,
+                                 u8(3 /* bits */ * k), results[k].sa_pos_left,
+                                 results[k].sa_pos_right};
+            }
+
+            std::pair<CompactWaveletTree::size_t, bool> wt_res[block_size];
+            m_wt_file->Get().GetFirstRanks(wt_queries, block_size, wt_res);
+            for (std::size_t k = 0; k < block_size; ++k) {
+                if (wt_res[k].second) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+private:
+    ObjectFileHolder m_dna_file_holder;
+    DnaAccessorT m_dna;
+    SbtT m_sbt;
+    std::optional<CompactWaveletTreeOnDisk> m_wt_file;
+};
+
+// d of pattern or batch by cost model of text among indexes of d, that exist on disk and are
+// calibrated. Only cost model and names of index files are read, indexes are not opened
+class BlockSizeChooser {
+public:
+    BlockSizeChooser(const std::string& data_path, const std::vector<u8>& candidate_ds)
+        : m_cost_model{BlockingCostModel::Load(NameGenerator{data_path, 1}.GetCostModelPath())} {
+        for (u8 d : candidate_ds) {
+            if (m_cost_model.Has(d) && HasIndex(NameGenerator{data_path, d}, d)) {
+                m_ds.push_back(d);
+            }
+        }
+        if (m_ds.empty()) {
+            throw std::runtime_error{"There is no calibrated index of any d: " + data_path};
+        }
+    }
+
+    static bool HasIndex(const NameGenerator& name_gen, u8 d) {
+        return std::filesystem::exists(name_gen.GetStringBTreePath()) &&
+               (d == 1 || std::filesystem::exists(name_gen.GetWaveletTreePath()));
+    }
+
+    const std::vector<u8>& GetBlockSizes() const noexcept {
+        return m_ds;
+    }
+
+    u8 Choose(str_len_t pattern_len) const {
+        return m_cost_model.Choose(m_ds, pattern_len);
+    }
+
+    u8 Choose(const std::vector<std::string>& patterns) const {
+        std::vector<str_len_t> pattern_lens;
+        pattern_lens.reserve(patterns.size());
+        for (const auto& pattern : patterns) {
+            pattern_lens.push_back(pattern.size());
+        }
+        return m_cost_model.Choose(m_ds, pattern_lens);
+    }
+
+private:
+    BlockingCostModel m_cost_model;
+    std::vector<u8> m_ds;
+};
+
+// Front-end over indexes of several d: index of d is opened if its files exist and cost model
+// has d. Pattern or whole batch is searched by d with lowest expected latency
+template <u8... ds>
+class MultiBlockedSearcher {
+public:
+    MultiBlockedSearcher(const std::string& data_path)
+        : m_chooser{data_path, {ds...}} {
+        (Open<ds>(data_path), ...);
+    }
+
+    const std::vector<u8>& GetBlockSizes() const noexcept {
+        return m_chooser.GetBlockSizes();
+    }
+
+    u8 ChooseBlockSize(str_len_t pattern_len) const {
+        return m_chooser.Choose(pattern_len);
+    }
+
+    u8 ChooseBlockSize(const std::vector<std::string>& patterns) const {
+        return m_chooser.Choose(patterns);
+    }
+
+    bool Contains(const std::string& pattern) const {
+        bool is_found = false;
+        Dispatch(ChooseBlockSize(pattern.size()), [&](const auto& searcher) {
+            is_found = searcher.Contains(searcher.Prepare(pattern));
+        });
+        return is_found;
+    }
+
+    // Number of found patterns, all patterns are searched by one d
+    std::size_t Contains(const std::vector<std::string>& patterns) const {
+        std::size_t num_found = 0;
+        Dispatch(ChooseBlockSize(patterns), [&](const auto& searcher) {
+            for (const auto& pattern : patterns) {
+                num_found += searcher.Contains(searcher.Prepare(pattern));
+            }
+        });
+        return num_found;
+    }
+
+private:
+    template <u8 d>
+    void Open(const std::string& data_path) {
+        const auto& chosen_ds = m_chooser.GetBlockSizes();
+        if (std::find(chosen_ds.begin(), chosen_ds.end(), d) != chosen_ds.end()) {
+            std::get<std::optional<BlockedSearcher<d>>>(m_searchers).emplace(
+                NameGenerator{data_path, d});
+        }
+    }
+
+    // func(searcher) with searcher of d
+    template <typename FuncT>
+    void Dispatch(u8 d, FuncT&& func) const {
+        auto search = [&]<u8 block_size> {
+            func(*std::get<std::optional<BlockedSearcher<block_size>>>(m_searchers));
+        };
+        ((d == ds ? (search.template operator()<ds>(), true) : false) || ...);
+    }
+
+private:
+    BlockSizeChooser m_chooser;
+    std::tuple<std::optional<BlockedSearcher<ds>>...> m_searchers;
+};
@@ -0,0 +1,122 @@
+#include "blocking_cost_model.h"
+
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+BlockingCostModel BlockingCostModel::Fit(const std::vector<Sample>& samples) {
+    struct Sums {
+        double n = 0, x = 0, y = 0, xx = 0, xy = 0;
+    };
+    std::array<Sums, c_max_d + 1> sums{};
+
+    for (const auto& [d, pattern_len, latency] : samples) {
+        if (d < 1 || d > c_max_d) {
+            throw std::invalid_argument{"Incorrect d of sample: " + std::to_string(d)};
+        }
+
+        auto& s = sums[d];
+        s.n += 1;
+        s.x += pattern_len;
+        s.y += latency;
+        s.xx += double(pattern_len) * pattern_len;
+        s.xy += pattern_len * latency;
+    }
+
+    BlockingCostModel model;
+    for (u8 d = 1; d <= c_max_d; ++d) {
+        const auto& s = sums[d];
+        if (s.n == 0) {
+            continue;
+        }
+
+        // One pattern length gives constant latency
+        auto& coefs = model.m_coefs[d];
+        const double det = s.n * s.xx - s.x * s.x;
+        coefs.b = det > 0 ? (s.n * s.xy - s.x * s.y) / det : 0;
+        coefs.a = (s.y - coefs.b * s.x) / s.n;
+        coefs.is_fitted = true;
+    }
+
+    return model;
+}
+
+BlockingCostModel BlockingCostModel::Load(std::string_view cost_model_path) {
+    std::ifstream file{std::string{cost_model_path}};
+    if (!file) {
+        throw std::runtime_error{"Failed to open cost model: " + std::string{cost_model_path}};
+    }
+
+    BlockingCostModel model;
+    unsigned d = 0;
+    double a = 0, b = 0;
+    while (file >> d >> a >> b) {
+        if (d < 1 || d > c_max_d) {
+            throw std::runtime_error{"Incorrect d in cost model: " + std::to_string(d)};
+        }
+        model.m_coefs[d] = {a, b, true};
+    }
+
+    if (!file.eof()) {
+        throw std::runtime_error{"Incorrect format of cost model: " +
+                                 std::string{cost_model_path}};
+    }
+
+    return model;
+}
+
+void BlockingCostModel::Save(std::string_view cost_model_path) const {
+    std::ofstream file{std::string{cost_model_path}};
+    file.precision(std::numeric_limits<double>::max_digits10);
+    for (u8 d = 1; d <= c_max_d; ++d) {
+        if (Has(d)) {
+            file << (unsigned)d << ' ' << m_coefs[d].a << ' ' << m_coefs[d].b << '\n';
+        }
+    }
+
+    if (!file) {
+        throw std::runtime_error{"Failed to write cost model: " + std::string{cost_model_path}};
+    }
+}
+
+u8 BlockingCostModel::Choose(const std::vector<u8>& ds, str_len_t pattern_len) const {
+    return Choose(ds, &pattern_len, 1);
+}
+
+u8 BlockingCostModel::Choose(const std::vector<u8>& ds,
+                             const std::vector<str_len_t>& pattern_lens) const {
+    return Choose(ds, pattern_lens.data(), pattern_lens.size());
+}
+
+u8 BlockingCostModel::Choose(const std::vector<u8>& ds, const str_len_t* pattern_lens,
+                             std::size_t num_patterns) const {
+    u8 best_d = 0;
+    double best_cost = std::numeric_limits<double>::infinity();
+    for (u8 d : ds) {
+        if (!Has(d)) {
+            continue;
+        }
+
+        double cost = 0;
+        for (std::size_t i = 0; i < num_patterns; ++i) {
+            const str_len_t pattern_len = pattern_lens[i];
+            if (!IsApplicable(d, pattern_len)) {
+                cost = std::numeric_limits<double>::infinity();
+                break;
+            }
+            cost += Estimate(d, pattern_len);
+        }
+
+        if (cost < best_cost) {
+            best_d = d;
+            best_cost = cost;
+        }
+    }
+
+    if (best_d == 0) {
+        throw std::invalid_argument{"No calibrated d is applicable to patterns"};
+    }
+
+    return best_d;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "dna.h"
+
+#include <array>
+#include <string_view>
+#include <vector>
+
+/*
+    Latency of query by indexes of blocking d is linear by pattern length: a_d + b_d * len.
+    Coefficients are fitted by least squares over calibration samples of benchmark and
+    stored as text "d a b" per line next to index.
+
+    Pattern of length len is searched by index of d only if len > d (d = 1 for any length)
+*/
+class BlockingCostModel {
+public:
+    constexpr static u8 c_max_d = 8;
+
+    struct Sample {
+        u8 d;
+        str_len_t pattern_len;
+        double latency;
+    };
+
+    BlockingCostModel() = default;
+
+    static BlockingCostModel Fit(const std::vector<Sample>& samples);
+
+    static BlockingCostModel Load(std::string_view cost_model_path);
+    void Save(std::string_view cost_model_path) const;
+
+    bool Has(u8 d) const noexcept {
+        return d >= 1 && d <= c_max_d && m_coefs[d].is_fitted;
+    }
+
+    static bool IsApplicable(u8 d, str_len_t pattern_len) noexcept {
+        return d == 1 || pattern_len > d;
+    }
+
+    double Estimate(u8 d, str_len_t pattern_len) const noexcept {
+        return m_coefs[d].a + m_coefs[d].b * pattern_len;
+    }
+
+    // d of ds with lowest expected latency of pattern or of whole batch, ds must have d
+    // applicable to every pattern, else throw
+    u8 Choose(const std::vector<u8>& ds, str_len_t pattern_len) const;
+    u8 Choose(const std::vector<u8>& ds, const std::vector<str_len_t>& pattern_lens) const;
+
+private:
+    // Sum of latencies of pattern_lens[0, num_patterns) is minimized
+    u8 Choose(const std::vector<u8>& ds, const str_len_t* pattern_lens,
+              std::size_t num_patterns) const;
+
+    struct Coefs {
+        double a = 0;
+        double b = 0;
+        bool is_fitted = false;
+    };
+
+    std::array<Coefs, c_max_d + 1> m_coefs;
+};
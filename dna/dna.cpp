@@ -90,6 +90,8 @@ const char* DNASymb2String(DnaSymb dna_symb) {
             return "G";
         case DnaSymb::TERM:
             return "\\0";
+        case DnaSymb::SEP:
+            return "#";
         default:
             return "UNKNOWN";
     }
@@ -103,8 +105,9 @@ ObjectFileHolder::ObjectFileHolder(std::string_view compressed_dna_path)
     : m_file_map{compressed_dna_path}
     , m_size{*(const uint64_t*)m_file_map.begin()} {}
 
-ObjectFileHolder BuildCompressedDnaFromTextDna(std::string_view text_dna_path,
-                                               std::string_view compressed_dna_path, uint d_max) {
+static ObjectFileHolder BuildCompressedDnaImpl(std::string_view text_dna_path,
+                                               std::string_view compressed_dna_path, uint d_max,
+                                               std::vector<str_pos_t>* doc_begins) {
     if (d_max < 1) {
         throw std::runtime_error{"d_max must be >= 1"};
     }
@@ -117,6 +120,10 @@ ObjectFileHolder BuildCompressedDnaFromTextDna(std::string_view text_dna_path,
     u8* const dna_begin = mapper_comp_dna.begin() + ObjectFileHolder::c_header_size;
     uint64_t dna_pos = 0;
 
+    if (doc_begins != nullptr) {
+        doc_begins->assign(1, 0);
+    }
+
     bool is_header = false;
     for (u8 symb : mapper_text_dna) {
         if (is_header) {
@@ -127,6 +134,12 @@ ObjectFileHolder BuildCompressedDnaFromTextDna(std::string_view text_dna_path,
 
         if (symb == '>') {
             is_header = true;
+
+            // Header of the first record begins the first document
+            if (doc_begins != nullptr && dna_pos != 0) {
+                InsertDnaSymb(dna_begin, dna_pos++, DnaSymb::SEP);
+                doc_begins->push_back(dna_pos);
+            }
         } else {
             if (auto [dna_symb, is_dna_symb] = ConvertTextDnaSymb2DnaSymb(symb); is_dna_symb) {
                 InsertDnaSymb(dna_begin, dna_pos++, dna_symb);
@@ -134,7 +147,7 @@ ObjectFileHolder BuildCompressedDnaFromTextDna(std::string_view text_dna_path,
         }
     }
 
-    if (ReadDnaSymb(dna_begin, dna_pos - 1) != DnaSymb::TERM) {
+    if (dna_pos == 0 || ReadDnaSymb(dna_begin, dna_pos - 1) != DnaSymb::TERM) {
         InsertDnaSymb(dna_begin, dna_pos++, DnaSymb::TERM);
     }
 
@@ -150,6 +163,27 @@ ObjectFileHolder BuildCompressedDnaFromTextDna(std::string_view text_dna_path,
     return {compressed_dna_path};
 }
 
+ObjectFileHolder BuildCompressedDnaFromTextDna(std::string_view text_dna_path,
+                                               std::string_view compressed_dna_path, uint d_max) {
+    return BuildCompressedDnaImpl(text_dna_path, compressed_dna_path, d_max, nullptr);
+}
+
+ObjectFileHolder BuildCompressedDocsDnaFromTextDna(std::string_view text_dna_path,
+                                                   std::string_view compressed_dna_path,
+                                                   std::string_view docs_path, uint d_max) {
+    std::vector<str_pos_t> doc_begins;
+    auto dna_file_holder =
+        BuildCompressedDnaImpl(text_dna_path, compressed_dna_path, d_max, &doc_begins);
+
+    FileMapperWrite docs_mapper{docs_path, ObjectFileHolder::c_header_size +
+                                               doc_begins.size() * sizeof(str_pos_t)};
+    *(uint64_t*)docs_mapper.begin() = doc_begins.size();
+    std::copy(doc_begins.begin(), doc_begins.end(),
+              (str_pos_t*)(docs_mapper.begin() + ObjectFileHolder::c_header_size));
+
+    return dna_file_holder;
+}
+
 DnaDataAccessor::DnaDataAccessor(const u8* dna_data_begin, uint64_t num_dna)
     : m_dna_data_begin{dna_data_begin}
     , m_num_dna{num_dna} {}
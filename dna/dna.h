@@ -57,6 +57,12 @@ ObjectFileHolder BuildCompressedDnaFromTextDna(std::string_view text_dna_path,
                                                std::string_view compressed_dna_path,
                                                uint d_max = 1);
 
+// Generalized text: every FASTA record is document, that is ended by DnaSymb::SEP.
+// Begins of documents are stored in docs_path as object file of str_pos_t
+ObjectFileHolder BuildCompressedDocsDnaFromTextDna(std::string_view text_dna_path,
+                                                   std::string_view compressed_dna_path,
+                                                   std::string_view docs_path, uint d_max = 1);
+
 ObjectFileHolder BuildSuffArrayFromComprDna(std::string_view compressed_dna_path,
                                                  std::string_view suff_arr_path, uint d = 1);
 
@@ -92,6 +98,10 @@ public:
         return {m_dna_buf.data(), m_num_dna};
     }
 
+    void Set(str_pos_t pos, DnaSymb dna_symb) noexcept {
+        InsertDnaSymb(m_dna_buf.data(), pos, dna_symb);
+    }
+
 private:
     std::vector<uint8_t> m_dna_buf;
     uint64_t m_num_dna;
@@ -171,3 +181,36 @@ private:
     DnaSeqDataAccessor<d> m_dna;
     const str_pos_t* m_suff_arr;
 };
+
+// BWT of text$ as numbers: $ is end of text, that is less then any symbol (as in SA of
+// BuildSuffArrayFromComprDna), so it is 0 and DnaSymb are shifted by 1. Row 0 is suffix $,
+// row i + 1 is suffix SA[i]
+class BWTDnaAccessor {
+public:
+    constexpr static std::size_t c_alph_size = (std::size_t)DnaSymb::SEP + 2;
+
+    BWTDnaAccessor(const DnaDataAccessor& dna, const str_pos_t* suff_arr)
+        : m_dna{dna}
+        , m_suff_arr{suff_arr} {}
+
+    std::size_t operator[](str_pos_t row) const noexcept {
+        if (row == 0) {
+            return ToNumber(m_dna[m_dna.Size() - 1]);
+        }
+
+        const str_pos_t pos = m_suff_arr[row - 1];
+        return pos ? ToNumber(m_dna[pos - 1]) : 0;
+    }
+
+    str_len_t Size() const noexcept {
+        return m_dna.Size() + 1;
+    }
+
+    static std::size_t ToNumber(DnaSymb symb) noexcept {
+        return (std::size_t)symb + 1;
+    }
+
+private:
+    DnaDataAccessor m_dna;
+    const str_pos_t* m_suff_arr;
+};
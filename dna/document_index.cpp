@@ -0,0 +1,166 @@
+#include "document_index.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+DocumentIndex::DocumentIndex(std::string doc_index_path)
+    : m_file{doc_index_path} {
+    if (m_file.Size() < sizeof(Header) || m_file.Size() != CalcOccupiedSize(GetHeader())) {
+        throw std::runtime_error{"Incorrect size of document index: " + doc_index_path};
+    }
+}
+
+DocumentIndex DocumentIndex::Build(std::string doc_index_path, std::string_view suff_arr_path,
+                                   std::string_view docs_path, uint d) {
+    if (d < 1) {
+        throw std::runtime_error{"d must be >= 1"};
+    }
+
+    ObjectFileHolder suff_arr_holder{suff_arr_path};
+    const str_pos_t* suff_arr = (const str_pos_t*)suff_arr_holder.cbegin();
+    const str_len_t num_rows = suff_arr_holder.Size();
+
+    ObjectFileHolder docs_holder{docs_path};
+    const str_pos_t* doc_begins = (const str_pos_t*)docs_holder.cbegin();
+    const doc_id_t num_docs = docs_holder.Size();
+    if (num_docs == 0) {
+        throw std::runtime_error{"Number of documents must be greater 0"};
+    }
+
+    Header header{};
+    header.num_rows = num_rows;
+    header.num_docs = num_docs;
+    header.num_blocks = DivUp(num_rows, c_rmq_block_size);
+    header.num_levels = Log2Up(header.num_blocks);
+
+    FileMapperWrite doc_index_file{doc_index_path, CalcOccupiedSize(header)};
+    u8* dest = doc_index_file.begin();
+    *(Header*)dest = header;
+
+    doc_id_t* doc_arr = (doc_id_t*)(dest + sizeof(Header));
+    str_pos_t* prev_arr = (str_pos_t*)(doc_arr + num_rows);
+    str_pos_t* sparse_table = prev_arr + num_rows;
+
+    // DA and PREV
+    std::vector<str_pos_t> last_pos(num_docs);
+    for (str_pos_t i = 0; i < num_rows; ++i) {
+        const uint64_t text_pos = (uint64_t)d * suff_arr[i];
+        const auto* doc_it = std::upper_bound(doc_begins, doc_begins + num_docs, text_pos);
+        const doc_id_t doc = doc_it - doc_begins - 1;
+
+        doc_arr[i] = doc;
+        prev_arr[i] = last_pos[doc];
+        last_pos[doc] = i + 1;
+    }
+
+    // Sparse table, level 0 - minimum inside block
+    const uint64_t num_blocks = header.num_blocks;
+    for (uint64_t i_blk = 0; i_blk < num_blocks; ++i_blk) {
+        str_pos_t pos_begin = i_blk * c_rmq_block_size;
+        str_pos_t pos_end = std::min<uint64_t>(pos_begin + c_rmq_block_size, num_rows);
+
+        str_pos_t min_pos = pos_begin;
+        for (str_pos_t pos = pos_begin + 1; pos < pos_end; ++pos) {
+            if (prev_arr[pos] < prev_arr[min_pos]) {
+                min_pos = pos;
+            }
+        }
+        sparse_table[i_blk] = min_pos;
+    }
+
+    for (uint64_t i_lvl = 1; i_lvl < header.num_levels; ++i_lvl) {
+        const str_pos_t* prev_lvl = sparse_table + (i_lvl - 1) * num_blocks;
+        str_pos_t* lvl = sparse_table + i_lvl * num_blocks;
+
+        const uint64_t half = 1ull << (i_lvl - 1);
+        for (uint64_t i_blk = 0; i_blk < num_blocks; ++i_blk) {
+            str_pos_t min_pos = prev_lvl[i_blk];
+            if (i_blk + half < num_blocks) {
+                str_pos_t rhs_pos = prev_lvl[i_blk + half];
+                if (prev_arr[rhs_pos] < prev_arr[min_pos]) {
+                    min_pos = rhs_pos;
+                }
+            }
+            lvl[i_blk] = min_pos;
+        }
+    }
+
+    return {doc_index_path};
+}
+
+str_pos_t DocumentIndex::GetMinPrevPosScan(str_pos_t sa_pos_left,
+                                           str_pos_t sa_pos_right) const noexcept {
+    const str_pos_t* prev_arr = GetPrevArray();
+
+    str_pos_t min_pos = sa_pos_left;
+    for (str_pos_t pos = sa_pos_left + 1; pos < sa_pos_right; ++pos) {
+        if (prev_arr[pos] < prev_arr[min_pos]) {
+            min_pos = pos;
+        }
+    }
+    return min_pos;
+}
+
+str_pos_t DocumentIndex::GetMinPrevPos(str_pos_t sa_pos_left,
+                                       str_pos_t sa_pos_right) const noexcept {
+    const str_pos_t* prev_arr = GetPrevArray();
+    auto min_of = [prev_arr](str_pos_t lhs_pos, str_pos_t rhs_pos) {
+        return prev_arr[rhs_pos] < prev_arr[lhs_pos] ? rhs_pos : lhs_pos;
+    };
+
+    const uint64_t i_blk_left = sa_pos_left / c_rmq_block_size;
+    const uint64_t i_blk_right = (sa_pos_right - 1) / c_rmq_block_size;
+    if (i_blk_left == i_blk_right) {
+        return GetMinPrevPosScan(sa_pos_left, sa_pos_right);
+    }
+
+    str_pos_t min_pos = min_of(
+        GetMinPrevPosScan(sa_pos_left, (i_blk_left + 1) * c_rmq_block_size),
+        GetMinPrevPosScan(i_blk_right * c_rmq_block_size, sa_pos_right));
+
+    // Full blocks between
+    const uint64_t num_full_blk = i_blk_right - i_blk_left - 1;
+    if (num_full_blk) {
+        const uint64_t i_lvl = Log2Up(num_full_blk) - 1;
+        const str_pos_t* lvl = GetSparseTableLevel(i_lvl);
+
+        min_pos = min_of(min_pos, lvl[i_blk_left + 1]);
+        min_pos = min_of(min_pos, lvl[i_blk_right - (1ull << i_lvl)]);
+    }
+
+    return min_pos;
+}
+
+std::vector<doc_id_t> DocumentIndex::ListDocuments(str_pos_t sa_pos_left,
+                                                   str_pos_t sa_pos_right) const {
+    std::vector<doc_id_t> docs;
+    if (sa_pos_left >= sa_pos_right) {
+        return docs;
+    }
+
+    const doc_id_t* doc_arr = GetDocArray();
+    const str_pos_t* prev_arr = GetPrevArray();
+
+    // Document is new, if it previous position is before sa_pos_left
+    std::vector<std::pair<str_pos_t, str_pos_t>> ranges{{sa_pos_left, sa_pos_right}};
+    while (!ranges.empty()) {
+        auto [left, right] = ranges.back();
+        ranges.pop_back();
+
+        const str_pos_t min_pos = GetMinPrevPos(left, right);
+        if (prev_arr[min_pos] > sa_pos_left) {
+            continue;
+        }
+
+        docs.push_back(doc_arr[min_pos]);
+
+        if (min_pos + 1 < right) {
+            ranges.emplace_back(min_pos + 1, right);
+        }
+        if (left < min_pos) {
+            ranges.emplace_back(left, min_pos);
+        }
+    }
+
+    return docs;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../common/file_manip.h"
+#include "dna.h"
+
+#include <string>
+#include <vector>
+
+/*
+    Document listing for generalized text (Muthukrishnan):
+    DA[i]   - document of suffix SA[i]
+    PREV[i] - 1 + max j < i with DA[j] == DA[i], 0 if there is no such j
+
+    Document DA[i] appear first time in [l, r) at i, if PREV[i] <= l. Position of minimum
+    of PREV in [l, r) is found by RMQ, so every reported document cost O(1) RMQ queries.
+
+    RMQ: sparse table over minimums of blocks and scan inside of partial blocks
+*/
+class DocumentIndex {
+public:
+    constexpr static str_len_t c_rmq_block_size = 256;
+
+    DocumentIndex(std::string doc_index_path);
+
+    // docs_path - begins of documents from BuildCompressedDocsDnaFromTextDna
+    static DocumentIndex Build(std::string doc_index_path, std::string_view suff_arr_path,
+                               std::string_view docs_path, uint d = 1);
+
+    doc_id_t NumDocs() const noexcept {
+        return GetHeader().num_docs;
+    }
+
+    str_len_t Size() const noexcept {
+        return GetHeader().num_rows;
+    }
+
+    doc_id_t GetDocument(str_pos_t sa_pos) const noexcept {
+        return GetDocArray()[sa_pos];
+    }
+
+    // Distinct documents of SA interval [sa_pos_left, sa_pos_right) in unspecified order.
+    // Cost O(number of documents), not O(number of occurrences)
+    std::vector<doc_id_t> ListDocuments(str_pos_t sa_pos_left, str_pos_t sa_pos_right) const;
+
+private:
+    PACKED_STRUCT Header {
+        uint64_t num_rows;
+        uint64_t num_docs;
+        uint64_t num_blocks;
+        uint64_t num_levels;
+    };
+
+    static uint64_t CalcOccupiedSize(const Header& header) noexcept {
+        return sizeof(Header) +
+               (2 * header.num_rows + header.num_levels * header.num_blocks) * sizeof(str_pos_t);
+    }
+
+    const Header& GetHeader() const noexcept {
+        return *(const Header*)m_file.begin();
+    }
+
+    const doc_id_t* GetDocArray() const noexcept {
+        return (const doc_id_t*)(m_file.begin() + sizeof(Header));
+    }
+
+    const str_pos_t* GetPrevArray() const noexcept {
+        return (const str_pos_t*)(GetDocArray() + GetHeader().num_rows);
+    }
+
+    // Position of minimum PREV in blocks [i_blk, i_blk + 2^i_lvl)
+    const str_pos_t* GetSparseTableLevel(uint64_t i_lvl) const noexcept {
+        return GetPrevArray() + GetHeader().num_rows + i_lvl * GetHeader().num_blocks;
+    }
+
+    str_pos_t GetMinPrevPos(str_pos_t sa_pos_left, str_pos_t sa_pos_right) const noexcept;
+    str_pos_t GetMinPrevPosScan(str_pos_t sa_pos_left, str_pos_t sa_pos_right) const noexcept;
+
+private:
+    FileMapperRead m_file;
+};
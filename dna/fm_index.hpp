@@ -0,0 +1,225 @@
+#pragma once
+
+#include "../common/file_manip.h"
+#include "../wavelet_tree/wavelet_tree.hpp"
+#include "dna.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/*
+    FM-index of text$ (see BWTDnaAccessor): backward search by wavelet tree of BWT and C array
+    gives rows of pattern, row - 1 is position in SA. Locate walks LF to row with sampled SA
+    value: SA is sampled at text positions multiple of sample rate and at $, so walk is shorter
+    then sample rate. Sampled rows are marked in bit vector, samples are in order of rows.
+
+    Layout: FMIndex, samples, bit vector of sampled rows, wavelet tree of BWT
+*/
+template <typename WaveletTreeT>
+class alignas(8) BasicFMIndex {
+public:
+    using size_t = uint32_t;
+
+    constexpr static size_t c_default_sample_rate = 32;
+
+    class BuildInfo {
+    public:
+        BuildInfo(typename WaveletTreeT::BuildInfo wt_build_info, size_t sample_rate,
+                  size_t marks_pos, size_t wt_pos)
+            : m_wt_build_info{std::move(wt_build_info)}
+            , m_sample_rate{sample_rate}
+            , m_marks_pos{marks_pos}
+            , m_wt_pos{wt_pos} {}
+
+        size_t CalcOccupiedSize() const noexcept {
+            return m_wt_pos + m_wt_build_info.CalcOccupiedSize();
+        }
+
+        const typename WaveletTreeT::BuildInfo& GetWaveletTreeBuildInfo() const noexcept {
+            return m_wt_build_info;
+        }
+
+        size_t GetSampleRate() const noexcept {
+            return m_sample_rate;
+        }
+
+        size_t GetMarksPos() const noexcept {
+            return m_marks_pos;
+        }
+
+        size_t GetWaveletTreePos() const noexcept {
+            return m_wt_pos;
+        }
+
+    private:
+        typename WaveletTreeT::BuildInfo m_wt_build_info;
+        size_t m_sample_rate;
+        size_t m_marks_pos;
+        size_t m_wt_pos;
+    };
+
+    static BuildInfo PrepareBuild(const DnaDataAccessor& dna, const str_pos_t* suff_arr,
+                                  size_t sample_rate = c_default_sample_rate) {
+        if (sample_rate == 0) {
+            throw std::invalid_argument{"Sample rate of FM-index must be greater 0"};
+        }
+
+        const BWTDnaAccessor bwt{dna, suff_arr};
+        auto wt_build_info = WaveletTreeT::PrepareBuild(bwt, BWTDnaAccessor::c_alph_size);
+
+        // Bit vector and wavelet tree are aligned by cache line
+        const size_t num_samples = DivUp(dna.Size(), sample_rate) + 1;
+        const size_t marks_pos =
+            AlignPos(sizeof(BasicFMIndex) + num_samples * sizeof(str_pos_t), 64);
+        const size_t wt_pos =
+            AlignPos(marks_pos + BitVectorInterleaved::CalcOccupiedSize(bwt.Size()), 64);
+
+        return {std::move(wt_build_info), sample_rate, marks_pos, wt_pos};
+    }
+
+    BasicFMIndex(const DnaDataAccessor& dna, const str_pos_t* suff_arr,
+                 const BuildInfo& build_info)
+        : m_size{(size_t)dna.Size()}
+        , m_sample_rate{build_info.GetSampleRate()}
+        , m_marks_pos{build_info.GetMarksPos()}
+        , m_wt_pos{build_info.GetWaveletTreePos()} {
+        const BWTDnaAccessor bwt{dna, suff_arr};
+        const auto& wt_build_info = build_info.GetWaveletTreeBuildInfo();
+        new ((u8*)this + m_wt_pos) WaveletTreeT{bwt, BWTDnaAccessor::c_alph_size, wt_build_info};
+
+        // Number of symbols less then symbol
+        const auto& symb_freq = wt_build_info.GetSymbFreq();
+        m_c[0] = 0;
+        for (size_t symb = 0; symb < BWTDnaAccessor::c_alph_size; ++symb) {
+            m_c[symb + 1] = m_c[symb] + symb_freq[symb];
+        }
+
+        auto& marks = *new ((u8*)this + m_marks_pos) BitVectorInterleaved{bwt.Size()};
+        str_pos_t* samples = GetSamples();
+
+        size_t i_sample = 0;
+        samples[i_sample++] = m_size;
+        marks.Set(0, true);
+        for (size_t row = 1; row < bwt.Size(); ++row) {
+            const str_pos_t pos = suff_arr[row - 1];
+            if (pos % m_sample_rate == 0) {
+                samples[i_sample++] = pos;
+                marks.Set(row, true);
+            }
+        }
+        marks.Reinit();
+    }
+
+    // SA interval [left, right) of suffixes with prefix pattern, SA is not touched
+    std::pair<str_pos_t, str_pos_t> SearchRange(const DnaDataAccessor& pattern) const {
+        if (pattern.Size() == 0) {
+            return {0, m_size};
+        }
+
+        const auto& wt = GetWaveletTree();
+
+        size_t l_row = 0, r_row = m_size + 1;
+        for (auto i = pattern.Size(); i-- && l_row < r_row;) {
+            const size_t symb = BWTDnaAccessor::ToNumber(pattern[i]);
+            l_row = m_c[symb] + wt.GetRank(symb, l_row);
+            r_row = m_c[symb] + wt.GetRank(symb, r_row);
+        }
+
+        // Rows of not empty pattern are after row of $
+        return {l_row - 1, std::max(l_row, r_row) - 1};
+    }
+
+    str_len_t Count(const DnaDataAccessor& pattern) const {
+        auto [sa_pos_left, sa_pos_right] = SearchRange(pattern);
+        return sa_pos_right - sa_pos_left;
+    }
+
+    // Text position of suffix SA[sa_pos]
+    str_pos_t Locate(str_pos_t sa_pos) const {
+        const auto& wt = GetWaveletTree();
+        const auto& marks = GetMarks();
+
+        size_t row = sa_pos + 1;
+        str_pos_t num_steps = 0;
+        for (; !marks.Get(row); ++num_steps) {
+            const auto [symb, rank] = wt.GetSymbRank(row);
+            row = m_c[symb] + rank;
+        }
+
+        return GetSamples()[marks.GetRank(row)] + num_steps;
+    }
+
+    // Text positions of all occurrences in order of SA
+    std::vector<str_pos_t> Locate(const DnaDataAccessor& pattern) const {
+        auto [sa_pos_left, sa_pos_right] = SearchRange(pattern);
+
+        std::vector<str_pos_t> poss;
+        poss.reserve(sa_pos_right - sa_pos_left);
+        for (str_pos_t sa_pos = sa_pos_left; sa_pos < sa_pos_right; ++sa_pos) {
+            poss.push_back(Locate(sa_pos));
+        }
+
+        return poss;
+    }
+
+private:
+    str_pos_t* GetSamples() noexcept {
+        return (str_pos_t*)(this + 1);
+    }
+    const str_pos_t* GetSamples() const noexcept {
+        return (const str_pos_t*)(this + 1);
+    }
+
+    const BitVectorInterleaved& GetMarks() const noexcept {
+        return *(const BitVectorInterleaved*)((const u8*)this + m_marks_pos);
+    }
+
+    const WaveletTreeT& GetWaveletTree() const noexcept {
+        return *(const WaveletTreeT*)((const u8*)this + m_wt_pos);
+    }
+
+private:
+    size_t m_size;
+    size_t m_sample_rate;
+    size_t m_marks_pos;
+    size_t m_wt_pos;
+    size_t m_c[BWTDnaAccessor::c_alph_size + 1];
+};
+
+// FM-index in file, it is in memory after pages are cached
+template <typename WaveletTreeT>
+class BasicFMIndexOnDisk {
+public:
+    using FMIndexT = BasicFMIndex<WaveletTreeT>;
+
+    BasicFMIndexOnDisk(std::string fm_path)
+        : m_fm{fm_path} {}
+
+    const FMIndexT& Get() const noexcept {
+        return *(const FMIndexT*)m_fm.begin();
+    }
+
+    static BasicFMIndexOnDisk Build(
+        std::string fm_path, const DnaDataAccessor& dna, std::string suff_arr_path,
+        typename FMIndexT::size_t sample_rate = FMIndexT::c_default_sample_rate) {
+        {
+            ObjectFileHolder suff_arr_holder{suff_arr_path};
+            const str_pos_t* suff_arr = (const str_pos_t*)suff_arr_holder.cbegin();
+
+            auto build_info = FMIndexT::PrepareBuild(dna, suff_arr, sample_rate);
+
+            // Structure is built directly in mapped file
+            FileMapperWrite file{fm_path, build_info.CalcOccupiedSize()};
+            new (file.begin()) FMIndexT{dna, suff_arr, build_info};
+        }
+
+        return {fm_path};
+    }
+
+private:
+    FileMapperRead m_fm;
+};
+
+using FMIndex = BasicFMIndex<WaveletTree>;
+using FMIndexOnDisk = BasicFMIndexOnDisk<WaveletTree>;
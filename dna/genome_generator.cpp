@@ -0,0 +1,176 @@
+#include "genome_generator.h"
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+GenomeGenerator::GenomeGenerator(const GenomeGenParams& params)
+    : m_params{params}
+    , m_gen{params.seed} {
+    if (params.markov_order > c_max_markov_order) {
+        throw std::invalid_argument{"Markov order must be <= " +
+                                    std::to_string(c_max_markov_order)};
+    }
+    if (params.gc_content < 0 || params.gc_content > 1) {
+        throw std::invalid_argument{"GC content must be in [0, 1]"};
+    }
+    if (params.divergence < 0 || params.divergence > 1) {
+        throw std::invalid_argument{"Divergence must be in [0, 1]"};
+    }
+    if (params.tandem_rate < 0 || params.interspersed_rate < 0 || params.n_run_rate < 0 ||
+        params.tandem_rate + params.interspersed_rate + params.n_run_rate > 1) {
+        throw std::invalid_argument{"Rates of events must be >= 0 with sum <= 1"};
+    }
+
+    // GC content is the same in every context, only shares of C in GC and A in AT vary
+    const uint64_t num_contexts = uint64_t{1} << (2 * params.markov_order);
+    m_context_mask = num_contexts - 1;
+    m_markov_thresholds.resize(num_contexts);
+    for (auto& thresholds : m_markov_thresholds) {
+        const double a_share = 0.4 + 0.2 * Uniform();
+        const double c_share = 0.4 + 0.2 * Uniform();
+
+        const double p_a = (1 - params.gc_content) * a_share;
+        const double p_c = params.gc_content * c_share;
+        const double p_g = params.gc_content * (1 - c_share);
+
+        double cum = 0;
+        std::size_t i = 0;
+        for (double p : {p_a, p_c, p_g}) {
+            cum += p;
+            thresholds[i++] = (uint32_t)std::min(cum * 0x1.0p32, 0xFFFF'FFFF.0p0);
+        }
+    }
+
+    m_families.reserve(c_num_families);
+    for (uint i = 0; i < c_num_families; ++i) {
+        m_families.push_back(GenMarkovSeq(300 + Below(6'000)));
+    }
+}
+
+uint64_t GenomeGenerator::GenGap(double rate) noexcept {
+    if (rate <= 0) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    if (rate >= 1) {
+        return 0;
+    }
+
+    const double gap = std::floor(std::log1p(-Uniform()) / std::log1p(-rate));
+    return gap < 0x1.0p63 ? (uint64_t)gap : std::numeric_limits<uint64_t>::max();
+}
+
+u8 GenomeGenerator::GenMarkov(uint64_t context, uint32_t random) const noexcept {
+    const auto& thresholds = m_markov_thresholds[context];
+
+    u8 code = 0;
+    while (code < thresholds.size() && random >= thresholds[code]) {
+        ++code;
+    }
+    return code;
+}
+
+std::string GenomeGenerator::GenMarkovSeq(std::size_t len) {
+    std::string seq(len, 0);
+    uint64_t context = m_context;
+    for (auto& code : seq) {
+        code = GenMarkov(context, m_gen() >> 32);
+        context = ((context << 2) | code) & m_context_mask;
+    }
+    return seq;
+}
+
+std::string GenomeGenerator::Mutate(std::string_view seq) {
+    std::string copy{seq};
+    for (uint64_t pos = GenGap(m_params.divergence); pos < copy.size();
+         pos += 1 + GenGap(m_params.divergence)) {
+        copy[pos] = (copy[pos] + 1 + Below(3)) % 4;
+    }
+    return copy;
+}
+
+std::string GenomeGenerator::GenTandem() {
+    // Microsatellite of unit 1-6 or minisatellite of unit 7-100, up to about 1000 symbols
+    const std::size_t unit_len = Uniform() < 0.5 ? 1 + Below(6) : 7 + Below(94);
+    const std::size_t num_copies = 2 + Below(std::max<std::size_t>(1'000 / unit_len, 2));
+
+    const auto unit = GenMarkovSeq(unit_len);
+    std::string seq;
+    seq.reserve(unit_len * num_copies);
+    for (std::size_t i = 0; i < num_copies; ++i) {
+        seq += unit;
+    }
+    return Mutate(seq);
+}
+
+std::string GenomeGenerator::GenInterspersed() {
+    // Family of lower index is more frequent. Half of copies are truncated at 5' end
+    const auto& family = m_families[Below(Below(c_num_families) + 1)];
+    const std::size_t begin = Uniform() < 0.5 ? 0 : Below(family.size());
+
+    std::string seq = family.substr(begin);
+    if (Uniform() < 0.5) {
+        std::reverse(seq.begin(), seq.end());
+        for (auto& code : seq) {
+            code = 3 - code;
+        }
+    }
+    return Mutate(seq);
+}
+
+void GenerateGenomeFasta(std::string_view fasta_path, const GenomeGenParams& params,
+                         std::size_t line_len) {
+    std::ofstream file{std::string{fasta_path}};
+    file << ">synthetic genome, seed " << params.seed << ", size " << params.size << '\n';
+
+    std::string line;
+    line.reserve(line_len);
+    GenomeGenerator{params}.Generate([&](char symb) {
+        line += symb;
+        if (line.size() == line_len) {
+            file << line << '\n';
+            line.clear();
+        }
+    });
+    if (!line.empty()) {
+        file << line << '\n';
+    }
+
+    if (!file) {
+        throw std::runtime_error{"Failed to write genome: " + std::string{fasta_path}};
+    }
+}
+
+ObjectFileHolder GenerateGenomeComp(std::string_view compressed_dna_path,
+                                    const GenomeGenParams& params, uint d_max) {
+    if (d_max < 1) {
+        throw std::runtime_error{"d_max must be >= 1"};
+    }
+
+    {
+        FileMapperWrite mapper_comp_dna{
+            compressed_dna_path,
+            ObjectFileHolder::c_header_size +
+                DivUp(DnaSymbBitSize * (params.size + 1 + d_max), 8u) + sizeof(uint64_t)};
+
+        u8* const dna_begin = mapper_comp_dna.begin() + ObjectFileHolder::c_header_size;
+        uint64_t dna_pos = 0;
+        GenomeGenerator{params}.Generate([&](char symb) {
+            if (auto [dna_symb, is_dna_symb] = ConvertTextDnaSymb2DnaSymb(symb); is_dna_symb) {
+                InsertDnaSymb(dna_begin, dna_pos++, dna_symb);
+            }
+        });
+        InsertDnaSymb(dna_begin, dna_pos++, DnaSymb::TERM);
+
+        *(uint64_t*)mapper_comp_dna.begin() = dna_pos;
+
+        // Size as of BuildCompressedDnaFromTextDna
+        const uint64_t dna_pos_with_d = d_max * DivUp(dna_pos, d_max);
+        const uint64_t num_bits =
+            8 * ObjectFileHolder::c_header_size + DnaSymbBitSize * dna_pos_with_d;
+        mapper_comp_dna.Truncate(DivUp(num_bits, 8u));
+    }
+
+    return {compressed_dna_path};
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "dna.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    Synthetic genome of fixed seed: background is Markov chain of order k over ACGT with
+    given GC content, in which events are inserted with rates per symbol of background:
+    - tandem repeat: copies of short unit (micro- and minisatellites);
+    - interspersed repeat: copy of fragment of one of repeat families (transposons), few
+      families are much more frequent, copy is reverse complement with probability 1/2;
+    - N-run: unknown symbols, as gaps of assembly.
+    Copies of repeats are mutated with divergence, so repeats give long, but not infinite LCP.
+
+    Only std::mt19937_64 is used for randomness (not std distributions), so output is the same
+    on every platform
+*/
+struct GenomeGenParams {
+    uint64_t size = 1 << 20;  // Symbols of genome, N included
+    uint markov_order = 3;
+    double gc_content = 0.41;
+    double tandem_rate = 1e-4;
+    double interspersed_rate = 1e-4;
+    double n_run_rate = 1e-6;
+    double divergence = 0.02;  // Probability of mutation of every symbol of repeat copy
+    uint64_t seed = 0xEDA;
+};
+
+class GenomeGenerator {
+public:
+    constexpr static uint c_max_markov_order = 10;
+    constexpr static uint c_num_families = 64;
+
+    GenomeGenerator(const GenomeGenParams& params);
+
+    // sink(symb) for every symbol of genome: 'A', 'C', 'G', 'T' or 'N'
+    template <typename SinkT>
+    void Generate(SinkT sink);
+
+private:
+    // Symbol codes are indexes of "ACGT", so complement is 3 - code
+    constexpr static std::string_view c_symbs = "ACGT";
+
+    double Uniform() noexcept {
+        return (m_gen() >> 11) * 0x1.0p-53;
+    }
+    uint64_t Below(uint64_t bound) noexcept {
+        return m_gen() % bound;
+    }
+
+    // Number of failures before first success of trials with probability rate, so trials are
+    // skipped instead of random number per trial
+    uint64_t GenGap(double rate) noexcept;
+
+    // Next symbol of Markov chain after context of last symbols by 32-bit random. Sequences of
+    // repeats are strings of symbol codes
+    u8 GenMarkov(uint64_t context, uint32_t random) const noexcept;
+    std::string GenMarkovSeq(std::size_t len);
+
+    // Copy of seq with mutations
+    std::string Mutate(std::string_view seq);
+
+    std::string GenTandem();
+    std::string GenInterspersed();
+
+    GenomeGenParams m_params;
+    std::mt19937_64 m_gen;
+
+    // Cumulative probabilities of A, C, G per context of markov_order last symbols
+    std::vector<std::array<uint32_t, 3>> m_markov_thresholds;
+    uint64_t m_context = 0;
+    uint64_t m_context_mask = 0;
+
+    std::vector<std::string> m_families;
+};
+
+template <typename SinkT>
+void GenomeGenerator::Generate(SinkT sink) {
+    const double tandem_bound = m_params.tandem_rate;
+    const double interspersed_bound = tandem_bound + m_params.interspersed_rate;
+    const double event_rate = interspersed_bound + m_params.n_run_rate;
+
+    auto emit = [&](u8 code) {
+        sink(c_symbs[code]);
+        m_context = ((m_context << 2) | code) & m_context_mask;
+    };
+
+    auto emit_seq = [&](const std::string& seq, uint64_t pos) {
+        const uint64_t len = std::min<uint64_t>(seq.size(), m_params.size - pos);
+        for (uint64_t i = 0; i < len; ++i) {
+            emit(seq[i]);
+        }
+        return len;
+    };
+
+    uint64_t pos = 0;
+    while (pos < m_params.size) {
+        // Background until next event, two symbols per random number
+        const uint64_t num_background = std::min(GenGap(event_rate), m_params.size - pos);
+        for (uint64_t i = 0; i < num_background; i += 2) {
+            const uint64_t random = m_gen();
+            emit(GenMarkov(m_context, random >> 32));
+            if (i + 1 < num_background) {
+                emit(GenMarkov(m_context, (uint32_t)random));
+            }
+        }
+
+        pos += num_background;
+        if (pos == m_params.size) {
+            break;
+        }
+
+        const double event = event_rate * Uniform();
+        if (event < tandem_bound) {
+            pos += emit_seq(GenTandem(), pos);
+        } else if (event < interspersed_bound) {
+            pos += emit_seq(GenInterspersed(), pos);
+        } else {
+            const uint64_t len = std::min<uint64_t>(100 + Below(10'000), m_params.size - pos);
+            for (uint64_t i = 0; i < len; ++i) {
+                sink('N');
+            }
+            pos += len;
+        }
+    }
+}
+
+// FASTA of one record with lines of line_len symbols
+void GenerateGenomeFasta(std::string_view fasta_path, const GenomeGenParams& params,
+                         std::size_t line_len = 60);
+
+// Compressed DNA as of BuildCompressedDnaFromTextDna from FASTA of the same params: N-runs are
+// skipped, because alphabet of DnaSymb has no N
+ObjectFileHolder GenerateGenomeComp(std::string_view compressed_dna_path,
+                                    const GenomeGenParams& params, uint d_max = 1);
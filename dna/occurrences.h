@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../common/file_manip.h"
+#include "dna.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+// Text positions of SA interval [sa_pos_left, sa_pos_right). Positions are streamed from
+// mapped SA with readahead (MADV_WILLNEED) of next chunk of the range only, ranges up to one
+// chunk are read without advice. Sorted mode materialize all positions
+class OccurrenceRange {
+public:
+    constexpr static str_len_t c_readahead_size = 16 * g_block_size / sizeof(str_pos_t);
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = str_pos_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const str_pos_t*;
+        using reference = str_pos_t;
+
+        Iterator() = default;
+        Iterator(const str_pos_t* cur, const str_pos_t* end, bool is_readahead)
+            : m_cur{cur}
+            , m_end{end}
+            , m_advised_end{is_readahead ? cur : end} {
+            // Current and next chunks
+            Readahead();
+            Readahead();
+        }
+
+        str_pos_t operator*() const noexcept {
+            return *m_cur;
+        }
+
+        Iterator& operator++() {
+            ++m_cur;
+            if (m_advised_end - m_cur == c_readahead_size) {
+                Readahead();
+            }
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator prev = *this;
+            ++*this;
+            return prev;
+        }
+
+        bool operator==(const Iterator& rhs) const noexcept {
+            return m_cur == rhs.m_cur;
+        }
+
+    private:
+        void Readahead() {
+            if (m_advised_end != m_end) {
+                auto size = std::min<uint64_t>(c_readahead_size, m_end - m_advised_end);
+                AdviseMemory(m_advised_end, size * sizeof(str_pos_t), MADV_WILLNEED);
+                m_advised_end += size;
+            }
+        }
+
+        const str_pos_t* m_cur = nullptr;
+        const str_pos_t* m_end = nullptr;
+        const str_pos_t* m_advised_end = nullptr;
+    };
+
+    OccurrenceRange(const str_pos_t* suff_arr, str_pos_t sa_pos_left, str_pos_t sa_pos_right,
+                    bool is_sorted = false)
+        : m_begin{suff_arr + sa_pos_left}
+        , m_end{suff_arr + std::max(sa_pos_left, sa_pos_right)} {
+        if (is_sorted) {
+            m_sorted.assign(m_begin, m_end);
+            std::sort(m_sorted.begin(), m_sorted.end());
+        }
+    }
+
+    str_len_t Size() const noexcept {
+        return m_end - m_begin;
+    }
+
+    bool IsSorted() const noexcept {
+        return !m_sorted.empty();
+    }
+
+    // Range is walked in single pass
+    Iterator begin() const {
+        if (IsSorted()) {
+            return {m_sorted.data(), m_sorted.data() + m_sorted.size(), false};
+        }
+
+        return {m_begin, m_end, Size() > c_readahead_size};
+    }
+
+    Iterator end() const noexcept {
+        if (IsSorted()) {
+            auto* end = m_sorted.data() + m_sorted.size();
+            return {end, end, false};
+        }
+        return {m_end, m_end, false};
+    }
+
+private:
+    const str_pos_t* m_begin;
+    const str_pos_t* m_end;
+    std::vector<str_pos_t> m_sorted;
+};
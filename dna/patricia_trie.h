@@ -10,6 +10,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <string>
+#include <type_traits>
 #include <map>
 #include <fstream>
 
@@ -21,6 +22,69 @@ namespace DNA_PT {
     greater then some number, but less 2^sizeof(node_pos_t)
 */
 
+// Lower: first string >= pattern
+// Upper: first string, whose prefix of pattern size > pattern
+enum class Bound : u8 { Lower, Upper };
+
+// CharT in 3-bit symbols: DnaSymb or DnaSymbSeq<N>
+template <typename CharT>
+constexpr inline uint c_char_num_symb = 1;
+template <u8 N>
+constexpr inline uint c_char_num_symb<DnaSymbSeq<N>> = N;
+
+template <typename CharT>
+CharT ReadPackedChar(const u8* data, uint64_t index) noexcept {
+    if constexpr (std::is_same_v<CharT, DnaSymb>) {
+        return ReadDnaSymb(data, index);
+    } else {
+        CharT seq;
+        for (u8 i = 0; i < c_char_num_symb<CharT>; ++i) {
+            seq.Set(ReadDnaSymb(data, index * c_char_num_symb<CharT> + i), i);
+        }
+        return seq;
+    }
+}
+
+template <typename CharT>
+void WritePackedChar(u8* data, uint64_t index, CharT symb) noexcept {
+    if constexpr (std::is_same_v<CharT, DnaSymb>) {
+        InsertDnaSymb(data, index, symb);
+    } else {
+        for (u8 i = 0; i < c_char_num_symb<CharT>; ++i) {
+            InsertDnaSymb(data, index * c_char_num_symb<CharT> + i, symb[i]);
+        }
+    }
+}
+
+/*
+    Symbols [offset, offset + len) of every string of SBT node, so LCP with pattern is
+    found without random access to text. String is addressed by position of its ext item.
+    Default - empty cache.
+*/
+template <typename CharT>
+struct KeyCacheView {
+    const u8* data = nullptr;
+    str_len_t offset = 0;
+    uint len = 0;
+    uint str_size = 0;  // Bytes per string
+    uint ext_item_size = sizeof(str_pos_t);
+    uint ext_item_num_str = 1;
+
+    bool Contains(str_len_t symb_pos) const noexcept {
+        return symb_pos >= offset && symb_pos - offset < len;
+    }
+
+    CharT Get(in_blk_pos_t rel_ext_pos, str_len_t symb_pos) const noexcept {
+        const uint i_str = rel_ext_pos / ext_item_size * ext_item_num_str +
+                           rel_ext_pos % ext_item_size / sizeof(str_pos_t);
+        return GetByIndex(i_str, symb_pos);
+    }
+
+    CharT GetByIndex(uint i_str, str_len_t symb_pos) const noexcept {
+        return ReadPackedChar<CharT>(data + i_str * str_size, symb_pos - offset);
+    }
+};
+
 template <typename CharT>
 class PT {
 public:
@@ -54,14 +118,27 @@ public:
         str_len_t lcp;
     };
 
-    template <typename AccessorT>
+    // Ext positions of lower and upper bounds after one blind descent
+    struct SearchRangeResult final {
+        in_blk_pos_t ext_node_pos_left;
+        in_blk_pos_t ext_node_pos_right;
+        str_len_t lcp;
+        bool is_text_read;  // Key cache was not enough
+    };
+
+    template <Bound BoundV = Bound::Lower, typename AccessorT>
     static SearchResult Search(const AccessorT& pattern, const InnerNode* root, str_len_t last_lcp,
-                               in_blk_pos_t ext_pos_begin, const AccessorT& dna_text);
+                               in_blk_pos_t ext_pos_begin, const AccessorT& dna_text,
+                               const KeyCacheView<CharT>& key_cache = {}) {
+        auto res = SearchRange(pattern, root, last_lcp, ext_pos_begin, dna_text, key_cache);
+        return {BoundV == Bound::Lower ? res.ext_node_pos_left : res.ext_node_pos_right, res.lcp};
+    }
 
     template <typename AccessorT>
-    static std::pair<in_blk_pos_t, bool> RSearch(const AccessorT& pattern, const InnerNode* root,
-                                                 str_len_t last_lcp, in_blk_pos_t ext_pos_begin,
-                                                 const AccessorT& dna_text);
+    static SearchRangeResult SearchRange(const AccessorT& pattern, const InnerNode* root,
+                                         str_len_t last_lcp, in_blk_pos_t ext_pos_begin,
+                                         const AccessorT& dna_text,
+                                         const KeyCacheView<CharT>& key_cache = {});
 
     static const Branch* LowerBound(const Branch* begin, const Branch* end, CharT symb) noexcept {
         return std::lower_bound(begin, end, symb, [](const Branch& lhs, CharT cur_symb) {
@@ -431,9 +508,12 @@ void PT<CharT>::BuildAndEmplacePT(const AccessorT& dna,
 
 template <typename CharT>
 template <typename AccessorT>
-typename PT<CharT>::SearchResult PT<CharT>::Search(const AccessorT& pattern, const InnerNode* root,
-                                                   str_len_t last_lcp, in_blk_pos_t ext_pos_begin,
-                                                   const AccessorT& dna) {
+typename PT<CharT>::SearchRangeResult PT<CharT>::SearchRange(const AccessorT& pattern,
+                                                             const InnerNode* root,
+                                                             str_len_t last_lcp,
+                                                             in_blk_pos_t ext_pos_begin,
+                                                             const AccessorT& dna,
+                                                             const KeyCacheView<CharT>& key_cache) {
     const InnerNode* node = root;
     in_blk_pos_t ext_pos = 0;
 
@@ -466,11 +546,22 @@ typename PT<CharT>::SearchResult PT<CharT>::Search(const AccessorT& pattern, con
 
     str_pos_t str_pos = misalign_load<str_pos_t>((const u8*)root + ext_pos);
 
+    // Symbol of blind string, i < size of string
+    bool is_text_read = false;
+    const in_blk_pos_t blind_rel_ext_pos = ext_pos - ext_pos_begin;
+    auto get_str_symb = [&](str_len_t i) -> CharT {
+        if (key_cache.Contains(i)) {
+            return key_cache.Get(blind_rel_ext_pos, i);
+        }
+        is_text_read = true;
+        return dna[str_pos + i];
+    };
+
     // Find lcp
     str_len_t lcp = last_lcp;
     str_len_t max_lcp = std::min<str_len_t>(pattern.Size(), dna.StrSize(str_pos));
     for (; lcp < max_lcp; ++lcp) {
-        if (pattern[lcp] != dna[str_pos + lcp]) {
+        if (pattern[lcp] != get_str_symb(lcp)) {
             break;
         }
     }
@@ -499,15 +590,20 @@ typename PT<CharT>::SearchResult PT<CharT>::Search(const AccessorT& pattern, con
         node = pt.GetNode(branch->node_pos);
     }
 
-    // Second phase
+    // Second phase, bounds differ only if pattern is prefix of strings
+    const bool is_pattern_end = lcp == pattern.Size();
+    in_blk_pos_t ext_pos_right = 0;
     if (hit_node_pos < ext_pos_begin) {  // Hit node is not leaf
         CharT pat_symb = lcp < pattern.Size() ? pattern[lcp] : CharT{};
-        CharT text_symb = dna[str_pos + lcp];
         node = pt.GetNode(hit_node_pos);
         const Branch* branchs_begin = node->GetBranchs();
         const Branch* branchs_end = branchs_begin + node->num_branch;
 
-        if (lcp == node->len) {
+        if (is_pattern_end) {
+            // Every string of subtree has pattern as prefix
+            ext_pos = pt.GetLeftmostExt(node);
+            ext_pos_right = pt.GetRightmostExt(node) + sizeof(str_pos);
+        } else if (lcp == node->len) {
             if (pat_symb < branchs_begin->symb) {
                 ext_pos = pt.GetLeftmostExt(node);
             } else if ((branchs_end - 1)->symb < pat_symb) {
@@ -517,18 +613,22 @@ typename PT<CharT>::SearchResult PT<CharT>::Search(const AccessorT& pattern, con
                 ext_pos = pt.GetLeftmostExt(branch);
             }
         } else {  // lcp < node->len
-            if (pat_symb < text_symb) {
+            if (pat_symb < get_str_symb(lcp)) {
                 ext_pos = pt.GetLeftmostExt(node);
             } else {
                 ext_pos = pt.GetRightmostExt(node) + sizeof(str_pos);
             }
         }
     } else {  // Hit node is leaf
-        if (lcp == dna.StrSize(str_pos)) {
+        if (is_pattern_end) {
             ext_pos = hit_node_pos;
+            ext_pos_right = hit_node_pos + sizeof(str_pos);
+        } else if (lcp == dna.StrSize(str_pos)) {
+            // String is prefix of pattern
+            ext_pos = hit_node_pos + sizeof(str_pos);
         } else {
             CharT pat_symb = pattern[lcp];
-            CharT dna_symb = dna[str_pos + lcp];
+            CharT dna_symb = get_str_symb(lcp);
             assert(pat_symb != dna_symb);
             if (pat_symb < dna_symb) {
                 ext_pos = hit_node_pos;
@@ -539,71 +639,14 @@ typename PT<CharT>::SearchResult PT<CharT>::Search(const AccessorT& pattern, con
         }
     }
 
-    return SearchResult{.ext_node_pos = ext_pos, .lcp = lcp};
-}
-
-// Return: ext_pos and is_rightmost for r from [l, r]
-template <typename CharT>
-template <typename AccessorT>
-std::pair<in_blk_pos_t, bool> PT<CharT>::RSearch(const AccessorT& pattern, const InnerNode* root,
-                                                 str_len_t last_lcp, in_blk_pos_t ext_pos_begin,
-                                                 const AccessorT& dna) {
-    const InnerNode* node = root;
-    in_blk_pos_t ext_pos = 0;
-
-    PT<CharT>::Wrapper pt{root, ext_pos_begin};
-
-    std::vector<const InnerNode*> path;
-
-    str_len_t cur_len = 0;
-    while (true) {
-        if (pattern.Size() <= cur_len) {
-            node = path.back();
-            path.pop_back();
-
-            while (true) {
-                const Branch* branchs_begin = node->GetBranchs();
-                const Branch* branchs_end = branchs_begin + node->num_branch;
-                const Branch* branch = LowerBound(branchs_begin, branchs_end, pattern[node->len]);
-
-                assert(branch != branchs_end);
-                if (branch + 1 == branchs_end) {
-                    if (path.empty()) {
-                        return {0, true};
-                    }
-
-                    node = path.back();
-                    path.pop_back();
-                } else {
-                    ext_pos = pt.GetLeftmostExt(branch + 1);
-                    return {ext_pos, false};
-                }
-            }
-        }
-
-        path.push_back(node);
-
-        CharT cur_symb = pattern[node->len];
-
-        const Branch* branchs_begin = node->GetBranchs();
-        const Branch* branchs_end = branchs_begin + node->num_branch;
-        const Branch* branch = LowerBound(branchs_begin, branchs_end, cur_symb);
-
-        if (branch != branchs_end) {
-            bool is_inner_node_pos = branch->node_pos < ext_pos_begin;
-            if (is_inner_node_pos) {
-                node = pt.GetNode(branch->node_pos);
-                cur_len = node->len;
-            } else {
-                str_pos_t str_pos = misalign_load<str_pos_t>((const u8*)root + ext_pos);
-                cur_len = dna.StrSize(str_pos);
-            }
-        } else {
-            return {0, true};
-        }
+    if (!is_pattern_end) {
+        ext_pos_right = ext_pos;
     }
 
-    assert(0);
+    return SearchRangeResult{.ext_node_pos_left = ext_pos,
+                             .ext_node_pos_right = ext_pos_right,
+                             .lcp = lcp,
+                             .is_text_read = is_text_read};
 }
 
 }  // namespace DNA_PT
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../common/thread_pool.h"
+#include "blocked_index.hpp"
+
+#include <string>
+#include <vector>
+
+/*
+    Batches of queries on thread pool over one shared BlockedSearcher of d: mapped text, SBT and
+    WT are opened once and read by all workers. Batch is split into chunks of grain_size
+    queries, idle workers steal chunks of busy ones, so chunks of slow queries (e.g. misses of
+    d > 1, that check WT) do not leave cores idle
+*/
+template <u8 block_size>
+class QueryExecutor {
+public:
+    using SearcherT = BlockedSearcher<block_size>;
+    using Query = typename SearcherT::Query;
+
+    constexpr static std::size_t c_default_grain_size = 64;
+
+    QueryExecutor(const NameGenerator& name_gen, ThreadPool& pool,
+                  std::size_t grain_size = c_default_grain_size)
+        : m_searcher{name_gen}
+        , m_pool{pool}
+        , m_grain_size{grain_size} {}
+
+    const SearcherT& GetSearcher() const noexcept {
+        return m_searcher;
+    }
+
+    // Found flag of every query
+    std::vector<u8> Contains(const std::vector<Query>& queries) const {
+        std::vector<u8> is_found(queries.size());
+        m_pool.ParallelFor(queries.size(), m_grain_size, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                is_found[i] = m_searcher.Contains(queries[i]);
+            }
+        });
+        return is_found;
+    }
+
+    // Patterns are prepared in chunks too
+    std::vector<u8> Contains(const std::vector<std::string>& patterns) const {
+        std::vector<u8> is_found(patterns.size());
+        m_pool.ParallelFor(patterns.size(), m_grain_size, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                is_found[i] = m_searcher.Contains(SearcherT::Prepare(patterns[i]));
+            }
+        });
+        return is_found;
+    }
+
+private:
+    const SearcherT m_searcher;
+    ThreadPool& m_pool;
+    std::size_t m_grain_size;
+};
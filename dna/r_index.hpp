@@ -0,0 +1,396 @@
+#pragma once
+
+#include "../common/file_manip.h"
+#include "../wavelet_tree/wavelet_tree.hpp"
+#include "dna.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/*
+    Runs of BWT of text$ (see BWTDnaAccessor), rows are read from SA and text in one pass.
+    Run heads are number accessor for wavelet tree.
+
+    SA is sampled at boundaries of runs only: SA at last row of every run (toehold of backward
+    search) and pairs {SA[s], SA[s - 1]} for first row s of every run (samples of phi)
+*/
+class RunLengthBWT {
+public:
+    using size_t = uint32_t;
+
+    struct PhiSample {
+        size_t pos;       // SA of first row of run
+        size_t prev_pos;  // SA of previous row
+    };
+
+    RunLengthBWT(const DnaDataAccessor& dna, const str_pos_t* suff_arr) {
+        const BWTDnaAccessor bwt{dna, suff_arr};
+        const size_t num_rows = bwt.Size();
+
+        // SA of row, row 0 is suffix $
+        auto get_pos = [&](size_t row) -> size_t {
+            return row ? suff_arr[row - 1] : dna.Size();
+        };
+
+        for (size_t row = 0; row < num_rows; ++row) {
+            const auto symb = bwt[row];
+            if (row && symb == m_heads.back()) {
+                continue;
+            }
+
+            if (row) {
+                m_run_end_samples.push_back(get_pos(row - 1));
+                m_phi_samples.push_back({get_pos(row), get_pos(row - 1)});
+            }
+            m_heads.push_back(symb);
+            m_run_starts.push_back(row);
+        }
+        m_run_end_samples.push_back(get_pos(num_rows - 1));
+        m_run_starts.push_back(num_rows);
+
+        std::sort(m_phi_samples.begin(), m_phi_samples.end(),
+                  [](const PhiSample& lhs, const PhiSample& rhs) { return lhs.pos < rhs.pos; });
+    }
+
+    // Symbol of run
+    std::size_t operator[](size_t i_run) const noexcept {
+        return m_heads[i_run];
+    }
+
+    // Number of runs
+    size_t Size() const noexcept {
+        return m_heads.size();
+    }
+
+    // First rows of runs and number of rows at the end
+    const std::vector<size_t>& GetRunStarts() const noexcept {
+        return m_run_starts;
+    }
+
+    const std::vector<size_t>& GetRunEndSamples() const noexcept {
+        return m_run_end_samples;
+    }
+
+    // Sorted by pos
+    const std::vector<PhiSample>& GetPhiSamples() const noexcept {
+        return m_phi_samples;
+    }
+
+private:
+    std::vector<u8> m_heads;
+    std::vector<size_t> m_run_starts;
+    std::vector<size_t> m_run_end_samples;
+    std::vector<PhiSample> m_phi_samples;
+};
+
+/*
+    r-index: FM-index over run-length BWT, space is O(r) for r runs instead of O(n).
+    Rank of symbol in BWT is rank of symbol in run heads (wavelet tree) and cumulative
+    length of runs of symbol. Backward search keeps SA of last row of interval, that gives
+    first occurrence, other occurrences are walked by phi: SA[i] -> SA[i - 1], it is
+    phi(p) = prev_pos + p - pos for phi sample with greatest pos not greater then p.
+
+    Layout: RIndex, run starts, cumulative lengths, run end samples, phi samples, wavelet tree
+*/
+template <typename WaveletTreeT>
+class alignas(8) BasicRIndex {
+public:
+    using size_t = uint32_t;
+    using PhiSample = RunLengthBWT::PhiSample;
+
+    constexpr static std::size_t c_alph_size = BWTDnaAccessor::c_alph_size;
+
+    class BuildInfo {
+    public:
+        BuildInfo(RunLengthBWT rlbwt, typename WaveletTreeT::BuildInfo wt_build_info,
+                  size_t cum_len_pos, size_t run_end_samples_pos, size_t phi_samples_pos,
+                  size_t wt_pos)
+            : m_rlbwt{std::move(rlbwt)}
+            , m_wt_build_info{std::move(wt_build_info)}
+            , m_cum_len_pos{cum_len_pos}
+            , m_run_end_samples_pos{run_end_samples_pos}
+            , m_phi_samples_pos{phi_samples_pos}
+            , m_wt_pos{wt_pos} {}
+
+        size_t CalcOccupiedSize() const noexcept {
+            return m_wt_pos + m_wt_build_info.CalcOccupiedSize();
+        }
+
+        const RunLengthBWT& GetRunLengthBWT() const noexcept {
+            return m_rlbwt;
+        }
+
+        const typename WaveletTreeT::BuildInfo& GetWaveletTreeBuildInfo() const noexcept {
+            return m_wt_build_info;
+        }
+
+        size_t GetCumLenPos() const noexcept {
+            return m_cum_len_pos;
+        }
+
+        size_t GetRunEndSamplesPos() const noexcept {
+            return m_run_end_samples_pos;
+        }
+
+        size_t GetPhiSamplesPos() const noexcept {
+            return m_phi_samples_pos;
+        }
+
+        size_t GetWaveletTreePos() const noexcept {
+            return m_wt_pos;
+        }
+
+    private:
+        RunLengthBWT m_rlbwt;
+        typename WaveletTreeT::BuildInfo m_wt_build_info;
+        size_t m_cum_len_pos;
+        size_t m_run_end_samples_pos;
+        size_t m_phi_samples_pos;
+        size_t m_wt_pos;
+    };
+
+    static BuildInfo PrepareBuild(const DnaDataAccessor& dna, const str_pos_t* suff_arr) {
+        RunLengthBWT rlbwt{dna, suff_arr};
+        const size_t num_runs = rlbwt.Size();
+
+        // Select is needed only for runs of symbol, table is O(r)
+        auto wt_build_info = WaveletTreeT::PrepareBuild(rlbwt, c_alph_size, true);
+
+        // Cumulative lengths: number of runs + 1 for every symbol
+        const size_t cum_len_pos = sizeof(BasicRIndex) + (num_runs + 1) * sizeof(size_t);
+        const size_t run_end_samples_pos =
+            cum_len_pos + (num_runs + c_alph_size) * sizeof(size_t);
+        const size_t phi_samples_pos = run_end_samples_pos + num_runs * sizeof(size_t);
+        const size_t wt_pos =
+            AlignPos(phi_samples_pos + (num_runs - 1) * sizeof(PhiSample), 64);
+
+        return {std::move(rlbwt), std::move(wt_build_info), cum_len_pos, run_end_samples_pos,
+                phi_samples_pos, wt_pos};
+    }
+
+    BasicRIndex(const BuildInfo& build_info)
+        : m_num_rows{build_info.GetRunLengthBWT().GetRunStarts().back()}
+        , m_num_runs{build_info.GetRunLengthBWT().Size()}
+        , m_cum_len_pos{build_info.GetCumLenPos()}
+        , m_run_end_samples_pos{build_info.GetRunEndSamplesPos()}
+        , m_phi_samples_pos{build_info.GetPhiSamplesPos()}
+        , m_wt_pos{build_info.GetWaveletTreePos()} {
+        const auto& rlbwt = build_info.GetRunLengthBWT();
+        const auto& wt_build_info = build_info.GetWaveletTreeBuildInfo();
+        new ((u8*)this + m_wt_pos) WaveletTreeT{rlbwt, c_alph_size, wt_build_info};
+
+        const auto& run_starts = rlbwt.GetRunStarts();
+        std::copy(run_starts.begin(), run_starts.end(), GetRunStarts());
+
+        const auto& run_end_samples = rlbwt.GetRunEndSamples();
+        std::copy(run_end_samples.begin(), run_end_samples.end(), GetRunEndSamples());
+
+        const auto& phi_samples = rlbwt.GetPhiSamples();
+        std::copy(phi_samples.begin(), phi_samples.end(), GetPhiSamples());
+
+        // Number of runs of symbol gives begin of its lengths
+        const auto& symb_freq = wt_build_info.GetSymbFreq();
+        m_cum_len_begin[0] = 0;
+        for (size_t symb = 0; symb < c_alph_size; ++symb) {
+            m_cum_len_begin[symb + 1] = m_cum_len_begin[symb] + symb_freq[symb] + 1;
+        }
+
+        size_t* cum_len = GetCumLen();
+        std::vector<size_t> num_symb_runs(c_alph_size);
+        std::vector<size_t> num_symb_rows(c_alph_size);
+        for (size_t symb = 0; symb < c_alph_size; ++symb) {
+            cum_len[m_cum_len_begin[symb]] = 0;
+        }
+        for (size_t i_run = 0; i_run < m_num_runs; ++i_run) {
+            const auto symb = rlbwt[i_run];
+            num_symb_rows[symb] += run_starts[i_run + 1] - run_starts[i_run];
+            cum_len[m_cum_len_begin[symb] + ++num_symb_runs[symb]] = num_symb_rows[symb];
+        }
+
+        m_c[0] = 0;
+        for (size_t symb = 0; symb < c_alph_size; ++symb) {
+            m_c[symb + 1] = m_c[symb] + num_symb_rows[symb];
+        }
+    }
+
+    size_t GetNumRuns() const noexcept {
+        return m_num_runs;
+    }
+
+    // SA interval [left, right) of suffixes with prefix pattern and SA of right - 1
+    struct SearchResult {
+        str_pos_t sa_pos_left;
+        str_pos_t sa_pos_right;
+        str_pos_t last_pos;
+    };
+
+    SearchResult Search(const DnaDataAccessor& pattern) const {
+        const auto& wt = GetWaveletTree();
+
+        // Interval of rows and SA of its last row
+        size_t l_row = 0, r_row = m_num_rows;
+        size_t last_pos = GetRunEndSamples()[m_num_runs - 1];
+        if (pattern.Size() == 0) {
+            return {0, m_num_rows - 1, last_pos};
+        }
+
+        for (auto i = pattern.Size(); i-- && l_row < r_row;) {
+            const size_t symb = BWTDnaAccessor::ToNumber(pattern[i]);
+
+            // Symbol of last row continues toehold, else it is end of last run of symbol
+            const size_t i_run = FindRun(r_row - 1);
+            const auto [head, head_rank] = wt.GetSymbRank(i_run);
+            const size_t r_rank = GetRank(symb, r_row - 1, i_run, head, head_rank);
+            if (head == symb) {
+                --last_pos;
+            } else if (const size_t num_symb_runs = wt.GetRank(symb, i_run)) {
+                last_pos = GetRunEndSamples()[wt.Select(symb, num_symb_runs - 1)] - 1;
+            }
+
+            l_row = m_c[symb] + GetRank(symb, l_row);
+            r_row = m_c[symb] + r_rank + (head == symb);
+        }
+
+        if (l_row >= r_row) {
+            return {0, 0, 0};
+        }
+
+        // Rows of not empty pattern are after row of $
+        return {l_row - 1, r_row - 1, last_pos};
+    }
+
+    str_len_t Count(const DnaDataAccessor& pattern) const {
+        auto res = Search(pattern);
+        return res.sa_pos_right - res.sa_pos_left;
+    }
+
+    // Text positions of all occurrences in reverse order of SA
+    std::vector<str_pos_t> Locate(const DnaDataAccessor& pattern) const {
+        auto [sa_pos_left, sa_pos_right, pos] = Search(pattern);
+
+        std::vector<str_pos_t> poss;
+        poss.reserve(sa_pos_right - sa_pos_left);
+        for (str_pos_t sa_pos = sa_pos_right; sa_pos-- > sa_pos_left;) {
+            poss.push_back(pos);
+            if (sa_pos > sa_pos_left) {
+                pos = Phi(pos);
+            }
+        }
+
+        return poss;
+    }
+
+private:
+    // Run of row
+    size_t FindRun(size_t row) const noexcept {
+        const size_t* run_starts = GetRunStarts();
+        return std::upper_bound(run_starts, run_starts + m_num_runs, row) - run_starts - 1;
+    }
+
+    // Number of symb in rows [0, row)
+    size_t GetRank(size_t symb, size_t row) const {
+        if (row == 0) {
+            return 0;
+        }
+
+        const size_t i_run = FindRun(row - 1);
+        const auto [head, head_rank] = GetWaveletTree().GetSymbRank(i_run);
+        return GetRank(symb, row - 1, i_run, head, head_rank) + (head == symb);
+    }
+
+    // Number of symb in rows [0, row), run of row is known
+    size_t GetRank(size_t symb, size_t row, size_t i_run, size_t head, size_t head_rank) const {
+        const size_t num_symb_runs =
+            head == symb ? head_rank : GetWaveletTree().GetRank(symb, i_run);
+        const size_t rank = GetCumLen()[m_cum_len_begin[symb] + num_symb_runs];
+        return head == symb ? rank + row - GetRunStarts()[i_run] : rank;
+    }
+
+    // SA[i] -> SA[i - 1]
+    size_t Phi(size_t pos) const noexcept {
+        const PhiSample* phi_samples = GetPhiSamples();
+        const PhiSample* it =
+            std::upper_bound(phi_samples, phi_samples + m_num_runs - 1, pos,
+                             [](size_t pos, const PhiSample& sample) { return pos < sample.pos; });
+        --it;
+        return it->prev_pos + pos - it->pos;
+    }
+
+    size_t* GetRunStarts() noexcept {
+        return (size_t*)(this + 1);
+    }
+    const size_t* GetRunStarts() const noexcept {
+        return (const size_t*)(this + 1);
+    }
+
+    size_t* GetCumLen() noexcept {
+        return (size_t*)((u8*)this + m_cum_len_pos);
+    }
+    const size_t* GetCumLen() const noexcept {
+        return (const size_t*)((const u8*)this + m_cum_len_pos);
+    }
+
+    size_t* GetRunEndSamples() noexcept {
+        return (size_t*)((u8*)this + m_run_end_samples_pos);
+    }
+    const size_t* GetRunEndSamples() const noexcept {
+        return (const size_t*)((const u8*)this + m_run_end_samples_pos);
+    }
+
+    PhiSample* GetPhiSamples() noexcept {
+        return (PhiSample*)((u8*)this + m_phi_samples_pos);
+    }
+    const PhiSample* GetPhiSamples() const noexcept {
+        return (const PhiSample*)((const u8*)this + m_phi_samples_pos);
+    }
+
+    const WaveletTreeT& GetWaveletTree() const noexcept {
+        return *(const WaveletTreeT*)((const u8*)this + m_wt_pos);
+    }
+
+private:
+    size_t m_num_rows;
+    size_t m_num_runs;
+    size_t m_cum_len_pos;
+    size_t m_run_end_samples_pos;
+    size_t m_phi_samples_pos;
+    size_t m_wt_pos;
+    size_t m_c[c_alph_size + 1];
+    size_t m_cum_len_begin[c_alph_size + 1];
+};
+
+// r-index in file
+template <typename WaveletTreeT>
+class BasicRIndexOnDisk {
+public:
+    using RIndexT = BasicRIndex<WaveletTreeT>;
+
+    BasicRIndexOnDisk(std::string r_index_path)
+        : m_r_index{r_index_path} {}
+
+    const RIndexT& Get() const noexcept {
+        return *(const RIndexT*)m_r_index.begin();
+    }
+
+    static BasicRIndexOnDisk Build(std::string r_index_path, const DnaDataAccessor& dna,
+                                   std::string suff_arr_path) {
+        {
+            ObjectFileHolder suff_arr_holder{suff_arr_path};
+            const str_pos_t* suff_arr = (const str_pos_t*)suff_arr_holder.cbegin();
+
+            auto build_info = RIndexT::PrepareBuild(dna, suff_arr);
+
+            FileMapperWrite file{r_index_path, build_info.CalcOccupiedSize()};
+            new (file.begin()) RIndexT{build_info};
+        }
+
+        return {r_index_path};
+    }
+
+private:
+    FileMapperRead m_r_index;
+};
+
+using RIndex = BasicRIndex<WaveletTree>;
+using RIndexOnDisk = BasicRIndexOnDisk<WaveletTree>;
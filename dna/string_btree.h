@@ -1,8 +1,13 @@
 #pragma once
 
 #include "patricia_trie.h"
+#include "succinct_patricia_trie.h"
+#include "occurrences.h"
 
+#include <algorithm>
+#include <cassert>
 #include <limits>
+#include <type_traits>
 
 constexpr inline bool SBT_BUILD_LOG = true;
 
@@ -44,10 +49,25 @@ PACKED_STRUCT NodeBase {
     }
 };
 
-template <typename CharT>
+// KeyCacheLen - number of CharT of every string stored in node after common prefix of node,
+// so most of comparisons are done without random access to text.
+// PtFormatV - layout of PT in node: Succinct PT takes few bytes per string, so node has more
+// strings (children) and tree is lower, but search in node is linear scan
+template <typename CharT, uint KeyCacheLen = 0,
+          DNA_PT::Format PtFormatV = DNA_PT::Format::Pointer>
 class StringBTree {
     using PT_T = DNA_PT::PT<CharT>;
     using PtWrapperT = typename PT_T::Wrapper;
+    using SuccinctPT_T = DNA_PT::SuccinctPT<CharT>;
+    using KeyCacheViewT = DNA_PT::KeyCacheView<CharT>;
+
+    constexpr static bool c_is_succinct = PtFormatV == DNA_PT::Format::Succinct;
+
+    constexpr static uint c_key_cache_str_size =
+        DivUp(KeyCacheLen * DNA_PT::c_char_num_symb<CharT> * DnaSymbBitSize, 8u);
+    // Offset and strings of 2 extra leaves, node layout without cache is not changed
+    constexpr static uint c_key_cache_reserved_size =
+        KeyCacheLen ? sizeof(str_len_t) + 4 * c_key_cache_str_size : 0;
 
     template <bool IsLeafV, uint NumLeaf>  // one pair of L and R is 2 leaves
     struct NodeSectionsSize {
@@ -55,7 +75,8 @@ class StringBTree {
 
         constexpr static uint PT = PT_T::CalcMaxSize(NumLeaf);
         constexpr static uint Ext = NumLeaf / ExtItem<IsLeafV>::num_str * sizeof(ExtItem<IsLeafV>);
-        constexpr static uint common = PT + Ext;
+        constexpr static uint KeyCache = NumLeaf * c_key_cache_str_size;
+        constexpr static uint common = PT + Ext + KeyCache;
     };
 
     template <bool IsLeafV>
@@ -69,11 +90,15 @@ public:
         Node() noexcept
             : NodeBase{IsLeafV ? Type::Leaf : Type::Inner} {}
 
-        constexpr static uint num_leaves =
-            CalcPTNumLeaf<IsLeafV>(g_block_size - sizeof(NodeBase) - 30);
+        constexpr static uint num_leaves = CalcPTNumLeaf<IsLeafV>(
+            g_block_size - sizeof(NodeBase) - 30 - c_key_cache_reserved_size);
         std::array<uint8_t, NodeSectionsSize<IsLeafV, num_leaves + 2>::PT> PT;
         std::array<uint8_t, NodeSectionsSize<IsLeafV, num_leaves + 2>::Ext> Ext;
 
+        // Strings in order of Ext
+        str_len_t key_cache_offset;
+        std::array<uint8_t, NodeSectionsSize<IsLeafV, num_leaves + 2>::KeyCache> KeyCache;
+
         using ExtItemT = ExtItem<IsLeafV>;
 
         ExtItemT* ExtBegin() noexcept {
@@ -88,23 +113,113 @@ public:
             return (const u8*)&Ext - (const u8*)&PT;
         }
 
+        in_blk_pos_t GetPTPos(const void* addr) const noexcept {
+            return (const u8*)addr - (const u8*)&PT;
+        }
+
+        u8* KeyCacheBegin() noexcept {
+            return KeyCache.data();
+        }
+
         typename PT_T::Wrapper GetPT() const noexcept {
             return {(const u8*)&PT, GetExtPosBegin()};
         }
+
+        KeyCacheViewT GetKeyCache() const noexcept {
+            return {KeyCache.data(),       key_cache_offset,  KeyCacheLen,
+                    c_key_cache_str_size, sizeof(ExtItemT), ExtItemT::num_str};
+        }
+    };
+
+    // Ext items, key cache and succinct PT of num_str strings one after another
+    template <bool IsLeafV>
+    PACKED_STRUCT SuccinctNode : public NodeBase {
+        SuccinctNode() noexcept
+            : NodeBase{IsLeafV ? Type::Leaf : Type::Inner} {}
+
+        in_blk_pos_t num_str;
+        str_len_t key_cache_offset;
+        std::array<uint8_t, g_block_size - sizeof(NodeBase) - sizeof(in_blk_pos_t) -
+                                sizeof(str_len_t)>
+            data;
+
+        using ExtItemT = ExtItem<IsLeafV>;
+
+        uint NumExt() const noexcept {
+            return num_str / ExtItemT::num_str;
+        }
+
+        ExtItemT* ExtBegin() noexcept {
+            return (ExtItemT*)data.data();
+        }
+
+        const ExtItemT* ExtBegin() const noexcept {
+            return (const ExtItemT*)data.data();
+        }
+
+        in_blk_pos_t GetPTPos(const void* addr) const noexcept {
+            return (const u8*)addr - data.data();
+        }
+
+        u8* KeyCacheBegin() noexcept {
+            return data.data() + NumExt() * sizeof(ExtItemT);
+        }
+
+        const u8* KeyCacheBegin() const noexcept {
+            return data.data() + NumExt() * sizeof(ExtItemT);
+        }
+
+        u8* PTBegin() noexcept {
+            return KeyCacheBegin() + num_str * c_key_cache_str_size;
+        }
+
+        const u8* PTBegin() const noexcept {
+            return KeyCacheBegin() + num_str * c_key_cache_str_size;
+        }
+
+        str_pos_t GetStr(uint i_str) const noexcept {
+            if constexpr (IsLeafV) {
+                return ExtBegin()[i_str].str_pos;
+            } else {
+                const ExtItemT* ext_item = ExtBegin() + i_str / 2;
+                return i_str % 2 ? ext_item->right_str_pos : ext_item->left_str_pos;
+            }
+        }
+
+        KeyCacheViewT GetKeyCache() const noexcept {
+            return {KeyCacheBegin(), key_cache_offset, KeyCacheLen, c_key_cache_str_size};
+        }
     };
 
-    using InnerNode = Node<false>;
-    using LeafNode = Node<true>;
+    template <bool IsLeafV>
+    using NodeT = std::conditional_t<c_is_succinct, SuccinctNode<IsLeafV>, Node<IsLeafV>>;
+
+    using InnerNode = NodeT<false>;
+    using LeafNode = NodeT<true>;
 
     static_assert(sizeof(InnerNode) <= g_block_size);
     static_assert(sizeof(LeafNode) <= g_block_size);
 
-    typename PT_T::Wrapper GetPT(const NodeBase* node_base) noexcept {
+    typename PT_T::Wrapper GetPT(const NodeBase* node_base) const noexcept {
         return node_base->IsInner() ? ((const InnerNode*)node_base)->GetPT()
                                     : ((const LeafNode*)node_base)->GetPT();
     }
 
-    void DumpExt(const NodeBase* node_base);
+    KeyCacheViewT GetKeyCache(const NodeBase* node_base) const noexcept {
+        return node_base->IsInner() ? ((const InnerNode*)node_base)->GetKeyCache()
+                                    : ((const LeafNode*)node_base)->GetKeyCache();
+    }
+
+    // PT and key cache of strings of node, strs - strings and positions of them in PT
+    template <bool IsLeafV, typename AccessorT>
+    static void EmplacePT(NodeT<IsLeafV>* node, const AccessorT& dna_data,
+                          const std::vector<std::pair<str_pos_t, in_blk_pos_t>>& strs);
+
+    template <bool IsLeafV, typename AccessorT>
+    static void BuildKeyCache(NodeT<IsLeafV>* node, const AccessorT& dna_data,
+                              const std::vector<std::pair<str_pos_t, in_blk_pos_t>>& strs);
+
+    void DumpExt(const NodeBase* node_base) const;
 
 public:
     StringBTree(std::string sbt_path);
@@ -113,76 +228,233 @@ public:
     static StringBTree Build(std::string sbt_dest_path, const AccessorT& dna_data,
                              std::string dna_data_sa_path);
 
-    // dna pos, left sa pos, right sa pos, is find
+    // Blocks touched by query: nodes of SBT and random reads of text
+    struct SearchStats {
+        uint num_node_reads;
+        uint num_text_reads;
+    };
+
+    struct SearchResult final {
+        str_pos_t str_pos;  // First suffix, that is not less then pattern
+        str_pos_t sa_pos_left;
+        str_pos_t sa_pos_right;
+        str_len_t lcp;  // Equal to pattern size, if pattern is found
+        SearchStats stats;
+    };
+
+    // Both bounds in one descent without heap allocations: while paths of bounds are common,
+    // every node is visited once
+    template <typename AccessorT>
+    SearchResult Search(const AccessorT& pattern, const AccessorT& dna_data) const {
+        return Search(pattern, pattern, dna_data);
+    }
+
+    // Lower bound of pattern_lower and upper bound of pattern_upper, e.g. unaligned pattern
+    // with tail padded by minimal and maximal symbols
+    template <typename AccessorT>
+    SearchResult Search(const AccessorT& pattern_lower, const AccessorT& pattern_upper,
+                        const AccessorT& dna_data) const;
+
+    // Position in SA of first suffix, that is not less (Lower) or greater (Upper) then pattern
+    template <DNA_PT::Bound BoundV, typename AccessorT>
+    str_pos_t SearchBound(const AccessorT& pattern, const AccessorT& dna_data) const;
+
+    // Queries of one SearchBatch, d of blocked search is up to 8
+    constexpr static std::size_t c_max_batch_queries = 16;
+
+    // Bounds of query of SearchBatch: if upper is the same object as lower, common path of
+    // bounds is searched once, as by Search
     template <typename AccessorT>
-    std::tuple<str_pos_t, str_pos_t, str_pos_t, str_len_t> Search(const AccessorT& pattern,
-                                                                  const AccessorT& dna_data);
+    struct BatchQuery {
+        const AccessorT* pattern_lower;
+        const AccessorT* pattern_upper;
+    };
 
-    void Dump() {
+    struct BatchSearchResult {
+        std::size_t i_hit;  // num_queries, if there is no hit
+        SearchStats stats;  // Of all queries, node of level is counted once
+    };
+
+    // Bounds of all queries descend together level by level: distinct nodes of level are
+    // prefetched and read once for all cursors in them, node is searched by every pattern in it.
+    // is_hit(i_query, result) is called as soon as bounds of query are found, and batch stops
+    // on first hit: results of queries, that are not finished, are undefined
+    template <typename AccessorT, typename IsHitT>
+    BatchSearchResult SearchBatch(const BatchQuery<AccessorT>* queries, std::size_t num_queries,
+                                  const AccessorT& dna_data, SearchResult* results,
+                                  IsHitT is_hit) const;
+
+    // SA interval [left, right) of suffixes with prefix pattern, SA is not touched
+    template <typename AccessorT>
+    std::pair<str_pos_t, str_pos_t> SearchRange(const AccessorT& pattern,
+                                                const AccessorT& dna_data) const {
+        auto res = Search(pattern, dna_data);
+        return {res.sa_pos_left, res.sa_pos_right};
+    }
+
+    template <typename AccessorT>
+    str_len_t Count(const AccessorT& pattern, const AccessorT& dna_data) const {
+        auto [sa_pos_left, sa_pos_right] = SearchRange(pattern, dna_data);
+        return sa_pos_right - sa_pos_left;
+    }
+
+    // Stream of text positions of all occurrences, suff_arr - begin of SA from .sa file
+    template <typename AccessorT>
+    OccurrenceRange Locate(const AccessorT& pattern, const AccessorT& dna_data,
+                           const str_pos_t* suff_arr, bool is_sorted = false) const {
+        auto [sa_pos_left, sa_pos_right] = SearchRange(pattern, dna_data);
+        return {suff_arr, sa_pos_left, sa_pos_right, is_sorted};
+    }
+
+    void Dump() const {
         DumpImpl((const NodeBase*)m_root, 0);
     }
 
 private:
-    static blk_pos_t CalcCommonNumBlock(str_len_t num_string);
+    // Number of strings of every leaf, then number of children of every node of inner layers
+    template <typename AccessorT>
+    static std::vector<std::vector<str_len_t>> SplitLayers(const AccessorT& dna_data,
+                                                           const str_pos_t* suff_arr,
+                                                           str_len_t num_strings);
+
+    // Split lay on: [left] [left] [left] ... [right] [right], right >= left
+    static std::vector<str_len_t> SplitEven(str_len_t num_items, str_len_t max_node_size);
+
+    // Node is filled while items fit in block, calc_size(i) - size of item alone and size of
+    // link with previous item of node
+    template <typename CalcSizeT>
+    static std::vector<str_len_t> SplitGreedy(str_len_t num_items, CalcSizeT calc_size);
 
-    void DumpImpl(const NodeBase* node_base, int depth);
+    void DumpImpl(const NodeBase* node_base, int depth) const;
     const NodeBase* GetNodeBase(blk_pos_t blk_pos) const noexcept {
         return (const NodeBase*)((const u8*)m_btree.GetData().data() + blk_pos * g_block_size);
     }
-    str_pos_t GetSAPos(const NodeBase* node, in_blk_pos_t ext_pos);
 
-    const NodeBase* GetLeftmost(const NodeBase* sbt_node_base) {
-        using ExtItemT = typename InnerNode::ExtItemT;
+    // Index of string in order of Ext, after R of child is L of next child
+    uint GetStrIndex(const NodeBase* node, in_blk_pos_t ext_pos) const;
 
-        while (sbt_node_base->IsInner()) {
-            PtWrapperT pt = GetPT(sbt_node_base);
-            const auto* pt_root = pt.GetRoot();
+    // Descent state of one bound
+    struct Cursor {
+        const NodeBase* node = nullptr;  // nullptr, if sa_pos is found
+        str_len_t lcp = 0;
+        str_pos_t sa_pos = 0;
+        str_pos_t str_pos = 0;
+    };
 
-            const auto ext_begin = pt.GetExtPos();
-            auto ext_item = misalign_load<ExtItemT>((const u8*)pt_root + ext_begin);
+    // Bounds in cursor node as indexes of strings
+    using NodeSearchResult = typename SuccinctPT_T::SearchRangeResult;
 
-            sbt_node_base = GetNodeBase(ext_item.child);
-        }
+    template <typename AccessorT>
+    NodeSearchResult SearchNode(const AccessorT& pattern, const Cursor& cursor,
+                                const AccessorT& dna_data) const;
 
-        return sbt_node_base;
-    }
+    // Go to child by result of PT search in cursor node or finish cursor
+    void Advance(Cursor& cursor, uint i_str, str_len_t lcp, str_len_t text_size,
+                 SearchStats& stats) const;
 
 private:
     FileMapperRead m_btree;
     const u8* m_root;
 
     // Cache
-    str_pos_t m_leftmost_str;
     str_pos_t m_rightmost_str;
-    const LeafNode* m_leftmost_leaf;
+    uint m_root_num_ext;
 };
 
-template <typename CharT>
-blk_pos_t StringBTree<CharT>::CalcCommonNumBlock(str_len_t num_string) {
-    // Spec case
-    if (num_string <= LeafNode::num_leaves) {
-        return 1;  // Need only root node as LeafNode
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+std::vector<str_len_t> StringBTree<CharT, KeyCacheLen, PtFormatV>::SplitEven(
+    str_len_t num_items, str_len_t max_node_size) {
+    const str_len_t num_node = DivUp(num_items, max_node_size);
+    const str_len_t node_size_left = num_items / num_node;
+    const str_len_t num_right = num_items - node_size_left * num_node;
+
+    std::vector<str_len_t> node_sizes(num_node, node_size_left);
+    std::fill(node_sizes.end() - num_right, node_sizes.end(), node_size_left + 1);
+    return node_sizes;
+}
+
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+template <typename CalcSizeT>
+std::vector<str_len_t> StringBTree<CharT, KeyCacheLen, PtFormatV>::SplitGreedy(
+    str_len_t num_items, CalcSizeT calc_size) {
+    constexpr uint c_capacity =
+        sizeof(SuccinctNode<true>::data) - SuccinctPT_T::c_max_directory_size;
+
+    std::vector<str_len_t> node_sizes;
+    uint node_size = 0;
+    for (str_len_t i = 0; i < num_items; ++i) {
+        auto [item_size, link_size] = calc_size(i);
+        if (!node_sizes.empty() && node_size + item_size + link_size <= c_capacity) {
+            node_size += item_size + link_size;
+            ++node_sizes.back();
+        } else {
+            node_size = item_size;
+            node_sizes.push_back(1);
+        }
     }
 
-    uint64_t num_blocks = DivUp(num_string, LeafNode::num_leaves);
-    uint64_t num_blocks_last_layer = num_blocks;
-    while (num_blocks_last_layer != 1) {
-        num_blocks_last_layer = DivUp(num_blocks_last_layer, InnerNode::num_leaves / 2);
-        num_blocks += num_blocks_last_layer;
+    return node_sizes;
+}
+
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+template <typename AccessorT>
+std::vector<std::vector<str_len_t>> StringBTree<CharT, KeyCacheLen, PtFormatV>::SplitLayers(
+    const AccessorT& dna_data, const str_pos_t* suff_arr, str_len_t num_strings) {
+    std::vector<std::vector<str_len_t>> layers;
+
+    if constexpr (!c_is_succinct) {
+        layers.push_back(SplitEven(num_strings, LeafNode::num_leaves));
+        while (layers.back().size() > 1) {
+            layers.push_back(SplitEven(layers.back().size(), InnerNode::num_leaves / 2));
+        }
+        return layers;
     }
 
-    if (num_blocks > std::numeric_limits<blk_pos_t>::max()) {
-        throw std::runtime_error("Number blocks more then MAX_BLK_POS");
+    auto calc_entry_size = [&dna_data](str_pos_t left_str, str_pos_t right_str) {
+        return SuccinctPT_T::CalcEntrySize(
+            SuccinctPT_T::MakeEntry(dna_data, left_str, right_str));
+    };
+
+    layers.push_back(SplitGreedy(num_strings, [&](str_len_t i_str) {
+        const uint link_size =
+            i_str ? calc_entry_size(suff_arr[i_str - 1], suff_arr[i_str]) : 0;
+        return std::pair<uint, uint>{sizeof(ExtItem<true>) + c_key_cache_str_size, link_size};
+    }));
+
+    // L and R of nodes of last layer
+    std::vector<std::pair<str_pos_t, str_pos_t>> bounds;
+    str_pos_t i_str_begin = 0;
+    for (str_len_t node_num_str : layers.back()) {
+        bounds.emplace_back(suff_arr[i_str_begin], suff_arr[i_str_begin + node_num_str - 1]);
+        i_str_begin += node_num_str;
+    }
+
+    while (layers.back().size() > 1) {
+        layers.push_back(SplitGreedy(bounds.size(), [&](str_len_t i_child) {
+            auto [left_str, right_str] = bounds[i_child];
+            const uint item_size = sizeof(ExtItem<false>) + 2 * c_key_cache_str_size +
+                                   calc_entry_size(left_str, right_str);
+            const uint link_size =
+                i_child ? calc_entry_size(bounds[i_child - 1].second, left_str) : 0;
+            return std::pair<uint, uint>{item_size, link_size};
+        }));
+
+        std::size_t i_child = 0;
+        for (std::size_t i_node = 0; i_node < layers.back().size(); ++i_node) {
+            const str_len_t num_child = layers.back()[i_node];
+            bounds[i_node] = {bounds[i_child].first, bounds[i_child + num_child - 1].second};
+            i_child += num_child;
+        }
+        bounds.resize(layers.back().size());
     }
 
-    return num_blocks;
+    return layers;
 }
 
-template <typename CharT>
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
 template <typename AccessorT>
-StringBTree<CharT> StringBTree<CharT>::StringBTree::Build(std::string sbt_dest_path,
-                                                          const AccessorT& dna_data,
-                                                          std::string dna_data_sa_path) {
+StringBTree<CharT, KeyCacheLen, PtFormatV> StringBTree<CharT, KeyCacheLen, PtFormatV>::Build(
+    std::string sbt_dest_path, const AccessorT& dna_data, std::string dna_data_sa_path) {
     ObjectFileHolder suff_arr_holder{dna_data_sa_path};
     const str_pos_t* suff_arr = (const str_pos_t*)suff_arr_holder.cbegin();
     const str_len_t suff_arr_size = suff_arr_holder.Size();
@@ -191,47 +463,50 @@ StringBTree<CharT> StringBTree<CharT>::StringBTree::Build(std::string sbt_dest_p
         throw std::runtime_error("Invalid size text and suffix array");
     }
 
-    const blk_pos_t num_blocks = CalcCommonNumBlock(suff_arr_size);
-    FileMapperWrite sbt_file{sbt_dest_path, (uint64_t)num_blocks * g_block_size};
+    const auto layers = SplitLayers(dna_data, suff_arr, suff_arr_size);
+
+    uint64_t num_blocks = 0;
+    for (const auto& layer : layers) {
+        num_blocks += layer.size();
+    }
+
+    if (num_blocks > std::numeric_limits<blk_pos_t>::max()) {
+        throw std::runtime_error("Number blocks more then MAX_BLK_POS");
+    }
+
+    FileMapperWrite sbt_file{sbt_dest_path, num_blocks * g_block_size};
     auto [dest_data, dest_size] = sbt_file.GetData();
     // std::cout << "SBT file size: " << dest_size << std::endl;
 
     // Build leaves level
-    const str_len_t num_strings = suff_arr_size;
-
     u8* cur_dest = dest_data;
-    const blk_pos_t num_leaf_node = DivUp(num_strings, LeafNode::num_leaves);
-
-    // Split lay on: [left] [left] [left] ... [right] [right], right >= left
-    str_len_t node_num_str_left = num_strings / num_leaf_node;
-    str_len_t node_num_str_right = node_num_str_left + 1;
-    str_len_t num_right = num_strings - node_num_str_left * num_leaf_node;
+    const auto& leaf_sizes = layers.front();
+    const blk_pos_t num_leaf_node = leaf_sizes.size();
 
     str_pos_t i_str_begin = 0;
     std::vector<typename InnerNode::ExtItemT> exts(num_leaf_node);
+    std::vector<str_pos_t> exts_left_size(num_leaf_node);  // First SA row of child subtree
     str_pos_t suff_arr_left_size_prev = 0;
     for (blk_pos_t i_node_leaf = 0; i_node_leaf < num_leaf_node; ++i_node_leaf) {
         LeafNode* node = new (cur_dest) LeafNode;
         cur_dest = (u8*)node + g_block_size;
 
-        str_len_t node_num_str =
-            i_node_leaf < (num_leaf_node - num_right) ? node_num_str_left : node_num_str_right;
+        const str_len_t node_num_str = leaf_sizes[i_node_leaf];
 
         std::vector<std::pair<str_pos_t, in_blk_pos_t>> strs(node_num_str);
 
         typename LeafNode::ExtItemT* ext_poss = node->ExtBegin();
-        u8* addr_begin = (u8*)&node->PT;
 
         str_pos_t i_str_end = i_str_begin + node_num_str;
         for (str_len_t i_str = i_str_begin; i_str < i_str_end; ++i_str) {
             str_pos_t i = i_str - i_str_begin;
             ext_poss[i].str_pos = suff_arr[i_str];
-            strs[i] = {(str_pos_t)ext_poss[i].str_pos, (u8*)&ext_poss[i].str_pos - addr_begin};
+            strs[i] = {(str_pos_t)ext_poss[i].str_pos, node->GetPTPos((u8*)&ext_poss[i].str_pos)};
         }
 
         i_str_begin += node_num_str;
 
-        PT_T::BuildAndEmplacePT(dna_data, strs, addr_begin, sizeof(node->PT));
+        EmplacePT<true>(node, dna_data, strs);
 
         node->suff_arr_left_size = suff_arr_left_size_prev;
         suff_arr_left_size_prev += node_num_str;
@@ -239,10 +514,11 @@ StringBTree<CharT> StringBTree<CharT>::StringBTree::Build(std::string sbt_dest_p
         if (num_leaf_node > 1) {
             exts[i_node_leaf] = {ext_poss[0].str_pos, ext_poss[node_num_str - 1].str_pos,
                                  i_node_leaf};
+            exts_left_size[i_node_leaf] = node->suff_arr_left_size;
         }
 
         if constexpr (SBT_BUILD_LOG) {
-            if (i_node_leaf % (10 * num_leaf_node / 100) == 0) {
+            if (i_node_leaf % std::max<blk_pos_t>(1, num_leaf_node / 10) == 0) {
                 double proc = 100 * double(i_node_leaf) / num_leaf_node;
                 std::cout << i_node_leaf << " / " << num_leaf_node << " -> " << proc << "%\n";
             }
@@ -253,19 +529,14 @@ StringBTree<CharT> StringBTree<CharT>::StringBTree::Build(std::string sbt_dest_p
         return {sbt_dest_path};
     }
 
-    str_pos_t prev_layer_num_node = num_leaf_node;
-
     if constexpr (SBT_BUILD_LOG) {
         std::cout << "Start build inner layers\n";
     }
 
-    while (true) {
+    for (std::size_t i_layer = 1; i_layer < layers.size(); ++i_layer) {
         // Build inner layer
-
-        str_pos_t layer_num_node = DivUp(prev_layer_num_node, InnerNode::num_leaves / 2);
-        str_len_t num_child_left = prev_layer_num_node / layer_num_node;
-        str_len_t num_child_right = num_child_left + 1;
-        str_len_t num_right = prev_layer_num_node - num_child_left * layer_num_node;
+        const auto& child_nums = layers[i_layer];
+        const blk_pos_t layer_num_node = child_nums.size();
 
         auto ext_it = exts.cbegin();
         blk_pos_t layer_blk_pos_begin = exts.back().child + 1;
@@ -273,28 +544,30 @@ StringBTree<CharT> StringBTree<CharT>::StringBTree::Build(std::string sbt_dest_p
             InnerNode* node = new (cur_dest) InnerNode;
             cur_dest = (u8*)node + g_block_size;
 
-            str_len_t num_child =
-                i_node < (layer_num_node - num_right) ? num_child_left : num_child_right;
+            const str_len_t num_child = child_nums[i_node];
 
             std::vector<std::pair<str_pos_t, in_blk_pos_t>> strs(2 * num_child);
 
             typename InnerNode::ExtItemT* ext_poss = node->ExtBegin();
-            u8* addr_begin = (u8*)&node->PT;
+
+            // So bound on L of child is known without descent to leaf
+            node->suff_arr_left_size = exts_left_size[ext_it - exts.cbegin()];
 
             for (str_len_t i_child = 0; i_child < num_child; ++i_child) {
                 auto& ext_pos = ext_poss[i_child] = *ext_it++;
 
                 strs[2 * i_child + 0] = {(str_pos_t)ext_pos.left_str_pos,
-                                         (u8*)&ext_pos.left_str_pos - addr_begin};
+                                         node->GetPTPos((u8*)&ext_pos.left_str_pos)};
                 strs[2 * i_child + 1] = {(str_pos_t)ext_pos.right_str_pos,
-                                         (u8*)&ext_pos.right_str_pos - addr_begin};
+                                         node->GetPTPos((u8*)&ext_pos.right_str_pos)};
             }
 
-            PT_T::BuildAndEmplacePT(dna_data, strs, addr_begin, sizeof(node->PT));
+            EmplacePT<false>(node, dna_data, strs);
 
             if (layer_num_node > 1) {  // Is not root
                 exts[i_node] = {ext_poss[0].left_str_pos, ext_poss[num_child - 1].right_str_pos,
                                 layer_blk_pos_begin + i_node};
+                exts_left_size[i_node] = node->suff_arr_left_size;
             }
         }
 
@@ -303,19 +576,15 @@ StringBTree<CharT> StringBTree<CharT>::StringBTree::Build(std::string sbt_dest_p
             throw std::runtime_error{"Incorrect construct SBT"};
         }
 
-        if (layer_num_node == 1) {  // Is root
-            break;
-        }
-
         exts.resize(layer_num_node);
-        prev_layer_num_node = layer_num_node;
+        exts_left_size.resize(layer_num_node);
     }
 
     return {sbt_dest_path};
 }
 
-template <typename CharT>
-StringBTree<CharT>::StringBTree(std::string sbt_path)
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+StringBTree<CharT, KeyCacheLen, PtFormatV>::StringBTree(std::string sbt_path)
     : m_btree{sbt_path} {
     auto sv_btree = m_btree.GetData();
     const auto btree_num_blocks = sv_btree.size() / g_block_size;
@@ -333,23 +602,29 @@ StringBTree<CharT>::StringBTree(std::string sbt_path)
     }
 
     const NodeBase* root_node_base = (const NodeBase*)m_root;
-    PtWrapperT pt = GetPT(root_node_base);
-
-    m_leftmost_str = pt.GetLeftmostStr();
-    m_rightmost_str = pt.GetRightmostStr();
+    if constexpr (c_is_succinct) {
+        auto init = [this](const auto* root) {
+            m_rightmost_str = root->GetStr(root->num_str - 1);
+            m_root_num_ext = root->NumExt();
+        };
+
+        if (root_node_base->IsInner()) {
+            init((const InnerNode*)root_node_base);
+        } else {
+            init((const LeafNode*)root_node_base);
+        }
+    } else {
+        PtWrapperT pt = GetPT(root_node_base);
+        const in_blk_pos_t rightmost_ext_pos = pt.GetRightmostExt(pt.GetRoot());
 
-    // Init leftmost leaf
-    const NodeBase* node_base = (const NodeBase*)m_root;
-    while (node_base->IsInner()) {
-        const InnerNode* inn_node = (const InnerNode*)node_base;
-        blk_pos_t leftmost_child_pos = inn_node->ExtBegin()->child;
-        node_base = GetNodeBase(leftmost_child_pos);
+        m_rightmost_str = pt.GetStr(rightmost_ext_pos);
+        m_root_num_ext = GetStrIndex(root_node_base, rightmost_ext_pos) / 2 + 1;
     }
-    m_leftmost_leaf = (const LeafNode*)node_base;
 }
 
-template <typename CharT>
-void StringBTree<CharT>::DumpImpl(const NodeBase* node_base, int depth) {
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+void StringBTree<CharT, KeyCacheLen, PtFormatV>::DumpImpl(const NodeBase* node_base,
+                                                          int depth) const {
     for (int i = 0; i < depth; i++) {
         std::cout << "  ";
     }
@@ -363,33 +638,33 @@ void StringBTree<CharT>::DumpImpl(const NodeBase* node_base, int depth) {
 
     if (node_base->type == NodeBase::Type::Inner) {
         const auto* sbt_node = (const InnerNode*)node_base;
-        const auto* pt_root = (const typename PT_T::InnerNode*)&sbt_node->PT;
 
         uint num_ext = 0;
-        const typename PT_T::InnerNode* pt_node = pt_root;
-        while (true) {
-            const auto* branchs = (const typename PT_T::Branch*)(pt_node + 1);
-            typename PT_T::Branch branch = branchs[pt_node->num_branch - 1];
-            if (branch.node_pos >= sbt_node->GetExtPosBegin()) {
-                num_ext = branch.node_pos + sizeof(str_pos_t) + sizeof(blk_pos_t) -
-                          sbt_node->GetExtPosBegin();
-
-                if (num_ext % sizeof(ExtItem<false>)) {
-                    throw std::runtime_error{"Incorrect ext pos"};
+        if constexpr (c_is_succinct) {
+            num_ext = sbt_node->NumExt();
+        } else {
+            const auto* pt_root = (const typename PT_T::InnerNode*)&sbt_node->PT;
+            const typename PT_T::InnerNode* pt_node = pt_root;
+            while (true) {
+                const auto* branchs = (const typename PT_T::Branch*)(pt_node + 1);
+                typename PT_T::Branch branch = branchs[pt_node->num_branch - 1];
+                if (branch.node_pos >= sbt_node->GetExtPosBegin()) {
+                    num_ext = branch.node_pos + sizeof(str_pos_t) + sizeof(blk_pos_t) -
+                              sbt_node->GetExtPosBegin();
+
+                    if (num_ext % sizeof(ExtItem<false>)) {
+                        throw std::runtime_error{"Incorrect ext pos"};
+                    }
+
+                    num_ext /= sizeof(ExtItem<false>);
+                    break;
                 }
 
-                num_ext /= sizeof(ExtItem<false>);
-                break;
+                pt_node = (const typename PT_T::InnerNode*)((const u8*)pt_root + branch.node_pos);
             }
-
-            pt_node = (const typename PT_T::InnerNode*)((const u8*)pt_root + branch.node_pos);
-        }
-
-        if (num_ext % 2) {
-            throw std::runtime_error{"In inner node number leaf not even!"};
         }
 
-        const auto* ext_begin = (const ExtItem<false>*)&sbt_node->Ext;
+        const auto* ext_begin = sbt_node->ExtBegin();
         for (uint i_ext = 0; i_ext < num_ext; ++i_ext) {
             const auto* ext = (ext_begin + i_ext);
             const u8* data_begin = (const u8*)m_btree.GetData().data();
@@ -400,161 +675,283 @@ void StringBTree<CharT>::DumpImpl(const NodeBase* node_base, int depth) {
     }
 }
 
-template <typename CharT>
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+uint StringBTree<CharT, KeyCacheLen, PtFormatV>::GetStrIndex(const NodeBase* node,
+                                                             in_blk_pos_t ext_pos) const {
+    const in_blk_pos_t rel_ext_pos = ext_pos - GetPT(node).GetExtPos();
+    if (node->IsLeaf()) {
+        return rel_ext_pos / sizeof(ExtItem<true>);
+    }
+
+    const uint local_i_str = rel_ext_pos % sizeof(ExtItem<false>) / sizeof(str_pos_t);
+    return rel_ext_pos / sizeof(ExtItem<false>) * 2 + std::min(local_i_str, 2u);
+}
+
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
 template <typename AccessorT>
-std::tuple<str_pos_t, str_pos_t, str_pos_t, str_len_t> StringBTree<CharT>::Search(
-    const AccessorT& pattern, const AccessorT& dna) {
-    {
-        // pattern <= m_leftmost_str
-        str_len_t len = std::min(pattern.Size(), dna.StrSize(m_leftmost_str));
-        str_pos_t i = 0;
-        for (; i < len; ++i) {
-            CharT patt_symb = pattern[i];
-            CharT left_symb = dna[m_leftmost_str + i];
-            if (patt_symb != left_symb) {
-                if (patt_symb < left_symb) {
-                    return {m_leftmost_str, 0, 0, true};
-                }
-                break;
-            }
-        }
-        if (i == pattern.Size()) {
-            return {m_leftmost_str, 0, 0, true};
-        }
+typename StringBTree<CharT, KeyCacheLen, PtFormatV>::NodeSearchResult
+StringBTree<CharT, KeyCacheLen, PtFormatV>::SearchNode(const AccessorT& pattern,
+                                                       const Cursor& cursor,
+                                                       const AccessorT& dna) const {
+    if constexpr (c_is_succinct) {
+        auto search = [&](const auto* node) {
+            auto get_str = [node](uint i_str) {
+                return node->GetStr(i_str);
+            };
+            return SuccinctPT_T::SearchRange(pattern, node->PTBegin(), node->num_str, get_str,
+                                             cursor.lcp, dna, node->GetKeyCache());
+        };
+
+        return cursor.node->IsInner() ? search((const InnerNode*)cursor.node)
+                                      : search((const LeafNode*)cursor.node);
+    } else {
+        PtWrapperT pt = GetPT(cursor.node);
+        auto res = PT_T::SearchRange(pattern, pt.GetRoot(), cursor.lcp, pt.GetExtPos(), dna,
+                                     GetKeyCache(cursor.node));
+        return {GetStrIndex(cursor.node, res.ext_node_pos_left),
+                GetStrIndex(cursor.node, res.ext_node_pos_right), res.lcp, res.is_text_read};
     }
+}
 
-    {
-        // pattern > m_rightmost_str
-        str_len_t len = std::min(pattern.Size(), dna.StrSize(m_rightmost_str));
-        str_pos_t i = 0;
-        for (; i < len; ++i) {
-            CharT patt_symb = pattern[i];
-            CharT right_symb = dna[m_rightmost_str + i];
-            if (patt_symb != right_symb) {
-                if (patt_symb > right_symb) {
-                    str_pos_t sa_pos = dna.Size() - 1;
-                    return {m_rightmost_str, sa_pos, sa_pos + 1, true};
-                }
-                break;
-            }
-        }
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+void StringBTree<CharT, KeyCacheLen, PtFormatV>::Advance(Cursor& cursor, uint i_str,
+                                                         str_len_t lcp, str_len_t text_size,
+                                                         SearchStats& stats) const {
+    cursor.lcp = lcp;
+
+    if (cursor.node->IsLeaf()) {
+        // Position after last string of leaf is begin of next leaf
+        const auto* ext_begin = ((const LeafNode*)cursor.node)->ExtBegin();
+        cursor.sa_pos = cursor.node->suff_arr_left_size + i_str;
+        cursor.str_pos = cursor.sa_pos == text_size ? m_rightmost_str : ext_begin[i_str].str_pos;
+        cursor.node = nullptr;
+        return;
     }
 
-    bool is_right_finded = false;
+    // After R of last child, it is possible only in root
+    if ((const u8*)cursor.node == m_root && i_str / 2 == m_root_num_ext) {
+        cursor = {nullptr, lcp, text_size, m_rightmost_str};
+        return;
+    }
 
-    auto correct_ext_pos = [](in_blk_pos_t& ext_pos, in_blk_pos_t ext_begin) {
-        using ExtItemT = typename InnerNode::ExtItemT;
-        in_blk_pos_t local_ext_pos = (ext_pos - ext_begin) % sizeof(ExtItemT);
-        if (local_ext_pos > sizeof(str_pos_t)) {
-            ext_pos += sizeof(ExtItemT) - local_ext_pos;
-            local_ext_pos = 0;
-        }
+    const auto* ext_item = ((const InnerNode*)cursor.node)->ExtBegin() + i_str / 2;
+    const NodeBase* child = GetNodeBase(ext_item->child);
+    if (i_str % 2 == 0) {
+        // L: bound is the first string of child
+        cursor = {nullptr, lcp, child->suff_arr_left_size, ext_item->left_str_pos};
+        ++stats.num_node_reads;
+    } else {
+        // R
+        cursor.node = child;
+    }
+}
 
-        return local_ext_pos;
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+template <typename AccessorT>
+typename StringBTree<CharT, KeyCacheLen, PtFormatV>::SearchResult
+StringBTree<CharT, KeyCacheLen, PtFormatV>::Search(const AccessorT& pattern_lower,
+                                                   const AccessorT& pattern_upper,
+                                                   const AccessorT& dna) const {
+    const bool is_same_pattern = &pattern_lower == &pattern_upper;
+
+    SearchStats stats{};
+    auto search_node = [&](const AccessorT& pattern, const Cursor& cursor) {
+        auto res = SearchNode(pattern, cursor, dna);
+        stats.num_text_reads += res.is_text_read;
+        return res;
     };
 
-    str_pos_t str_pos = 0;
-    str_len_t cur_lcp = 0;
-    in_blk_pos_t ext_pos_res = 0;
-    in_blk_pos_t ext_pos_right_res = 0;
-    const NodeBase* sbt_node_base = (const NodeBase*)m_root;
-    const NodeBase* sbt_node_base_right = nullptr;
-    while (true) {
-        PtWrapperT pt = GetPT(sbt_node_base);
-
-        const auto* pt_root = pt.GetRoot();
-        const auto ext_begin = pt.GetExtPos();
-
-        auto [ext_pos, lcp] = PT_T::Search(pattern, pt_root, cur_lcp, ext_begin, dna);
-        cur_lcp = lcp;
-
-        /*
-            /^^\       /======\       /^^\
-            & -------- | TODO | -------- &
-            \__/       \======/       \__/
-             ##                        ##
-             ::                        ::
-             ''                        ''
-
-            Fix find sa_pos_right when search is unalign ---v
-        */
-
-        if (!is_right_finded && lcp + 1 >= pattern.Size()) {
-            is_right_finded = lcp == pattern.Size();
-
-            auto [right_ext_pos, is_rightmost] =
-                PT_T::RSearch(pattern, pt_root, lcp, ext_begin, dna);
-            if (is_rightmost) {
-                ext_pos_right_res = 0;  // Spec value
+    Cursor lower{(const NodeBase*)m_root};
+    Cursor upper{(const NodeBase*)m_root};
+    while (lower.node || upper.node) {
+        if (lower.node == upper.node) {
+            // Common path, node is read once
+            ++stats.num_node_reads;
+            if (is_same_pattern) {
+                auto res = search_node(pattern_lower, lower);
+                Advance(lower, res.i_str_left, res.lcp, dna.Size(), stats);
+                Advance(upper, res.i_str_right, res.lcp, dna.Size(), stats);
             } else {
-                ext_pos_right_res = right_ext_pos;
-                sbt_node_base_right = sbt_node_base;
+                auto res_lower = search_node(pattern_lower, lower);
+                auto res_upper = search_node(pattern_upper, upper);
+                Advance(lower, res_lower.i_str_left, res_lower.lcp, dna.Size(), stats);
+                Advance(upper, res_upper.i_str_right, res_upper.lcp, dna.Size(), stats);
             }
+            continue;
         }
 
-        if (sbt_node_base->IsInner()) {
-            in_blk_pos_t local_ext_pos = correct_ext_pos(ext_pos, ext_begin);
-
-            using ExtItemT = typename InnerNode::ExtItemT;
-            auto ext_item = misalign_load<ExtItemT>((const u8*)pt_root + ext_pos - local_ext_pos);
-            if (local_ext_pos == 0) {
-                // L
-                str_pos = pt.GetStr(ext_pos);
+        if (lower.node) {
+            ++stats.num_node_reads;
+            auto res = search_node(pattern_lower, lower);
+            Advance(lower, res.i_str_left, res.lcp, dna.Size(), stats);
+        }
 
-                sbt_node_base = GetNodeBase(ext_item.child);
-                sbt_node_base = GetLeftmost(sbt_node_base);
-                ext_pos_res = GetPT(sbt_node_base).GetExtPos();
-                break;
-            } else if (local_ext_pos == sizeof(str_pos_t)) {
-                // R
-                sbt_node_base = GetNodeBase(ext_item.child);
-            } else {
-                throw std::runtime_error{"Internal error"};
-            }
-        } else {
-            str_pos = pt.GetStr(ext_pos);
-            ext_pos_res = ext_pos;
-            break;
+        if (upper.node) {
+            ++stats.num_node_reads;
+            auto res = search_node(pattern_upper, upper);
+            Advance(upper, res.i_str_right, res.lcp, dna.Size(), stats);
         }
     }
 
-    str_pos_t sa_pos = GetSAPos(sbt_node_base, ext_pos_res);
+    return {lower.str_pos, lower.sa_pos, upper.sa_pos, lower.lcp, stats};
+}
 
-    str_pos_t sa_pos_right = 0;
-    if (ext_pos_right_res) {
-        sbt_node_base = sbt_node_base_right;
-        in_blk_pos_t ext_pos = ext_pos_right_res;
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+template <typename AccessorT, typename IsHitT>
+typename StringBTree<CharT, KeyCacheLen, PtFormatV>::BatchSearchResult
+StringBTree<CharT, KeyCacheLen, PtFormatV>::SearchBatch(const BatchQuery<AccessorT>* queries,
+                                                        std::size_t num_queries,
+                                                        const AccessorT& dna,
+                                                        SearchResult* results,
+                                                        IsHitT is_hit) const {
+    assert(num_queries <= c_max_batch_queries);
+
+    SearchStats stats{};
+    auto search_node = [&](const AccessorT& pattern, const Cursor& cursor) {
+        auto res = SearchNode(pattern, cursor, dna);
+        stats.num_text_reads += res.is_text_read;
+        return res;
+    };
 
-        if (sbt_node_base->IsInner()) {
-            using ExtItemT = typename InnerNode::ExtItemT;
+    Cursor lowers[c_max_batch_queries];
+    Cursor uppers[c_max_batch_queries];
+    bool is_finished[c_max_batch_queries] = {};
+    for (std::size_t i = 0; i < num_queries; ++i) {
+        lowers[i] = uppers[i] = {(const NodeBase*)m_root};
+    }
 
-            PtWrapperT pt = GetPT(sbt_node_base);
-            const auto* pt_root = pt.GetRoot();
+    // All cursors are on the same level, every step is one level down
+    const NodeBase* nodes[2 * c_max_batch_queries];
+    for (std::size_t num_finished = 0; num_finished < num_queries;) {
+        std::size_t num_nodes = 0;
+        for (std::size_t i = 0; i < num_queries; ++i) {
+            for (const NodeBase* node : {lowers[i].node, uppers[i].node}) {
+                if (node && std::find(nodes, nodes + num_nodes, node) == nodes + num_nodes) {
+                    __builtin_prefetch(node);
+                    nodes[num_nodes++] = node;
+                }
+            }
+        }
+        stats.num_node_reads += num_nodes;
+
+        for (std::size_t i = 0; i < num_queries; ++i) {
+            Cursor& lower = lowers[i];
+            Cursor& upper = uppers[i];
+            const AccessorT& pattern_lower = *queries[i].pattern_lower;
+            const AccessorT& pattern_upper = *queries[i].pattern_upper;
+
+            if (lower.node && lower.node == upper.node && &pattern_lower == &pattern_upper) {
+                auto res = search_node(pattern_lower, lower);
+                Advance(lower, res.i_str_left, res.lcp, dna.Size(), stats);
+                Advance(upper, res.i_str_right, res.lcp, dna.Size(), stats);
+            } else {
+                if (lower.node) {
+                    auto res = search_node(pattern_lower, lower);
+                    Advance(lower, res.i_str_left, res.lcp, dna.Size(), stats);
+                }
+                if (upper.node) {
+                    auto res = search_node(pattern_upper, upper);
+                    Advance(upper, res.i_str_right, res.lcp, dna.Size(), stats);
+                }
+            }
 
-            const auto ext_begin = pt.GetExtPos();
-            in_blk_pos_t local_ext_pos = correct_ext_pos(ext_pos, ext_begin);
+            // Hit is checked at once, so rest of level is not searched
+            if (is_finished[i] || lower.node || upper.node) {
+                continue;
+            }
 
-            auto ext_item = misalign_load<ExtItemT>((const u8*)pt_root + ext_pos - local_ext_pos);
-            sbt_node_base = GetNodeBase(ext_item.child);
-            sbt_node_base = GetLeftmost(sbt_node_base);
+            is_finished[i] = true;
+            ++num_finished;
 
-            ext_pos_right_res = GetPT(sbt_node_base).GetExtPos();
+            results[i] = {lower.str_pos, lower.sa_pos, upper.sa_pos, lower.lcp, {}};
+            if (is_hit(i, results[i])) {
+                return {i, stats};
+            }
         }
+    }
+
+    return {num_queries, stats};
+}
 
-        sa_pos_right = GetSAPos(sbt_node_base, ext_pos_right_res);
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+template <DNA_PT::Bound BoundV, typename AccessorT>
+str_pos_t StringBTree<CharT, KeyCacheLen, PtFormatV>::SearchBound(const AccessorT& pattern,
+                                                                  const AccessorT& dna) const {
+    SearchStats stats{};
+    Cursor cursor{(const NodeBase*)m_root};
+    while (cursor.node) {
+        auto res = SearchNode(pattern, cursor, dna);
+        Advance(cursor, BoundV == DNA_PT::Bound::Lower ? res.i_str_left : res.i_str_right,
+                res.lcp, dna.Size(), stats);
+    }
+
+    return cursor.sa_pos;
+}
+
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+template <bool IsLeafV, typename AccessorT>
+void StringBTree<CharT, KeyCacheLen, PtFormatV>::EmplacePT(
+    NodeT<IsLeafV>* node, const AccessorT& dna_data,
+    const std::vector<std::pair<str_pos_t, in_blk_pos_t>>& strs) {
+    if constexpr (c_is_succinct) {
+        node->num_str = strs.size();
+
+        u8* dest = node->PTBegin();
+        const u8* dest_end = node->data.data() + node->data.size();
+        SuccinctPT_T::BuildAndEmplacePT(dna_data, strs, dest, dest_end - dest);
     } else {
-        sa_pos_right = std::min<str_len_t>(sa_pos + 1, dna.Size() - 1);
+        PT_T::BuildAndEmplacePT(dna_data, strs, (u8*)&node->PT, sizeof(node->PT));
     }
 
-    return {str_pos, sa_pos, sa_pos_right, cur_lcp};
+    BuildKeyCache<IsLeafV>(node, dna_data, strs);
+}
+
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+template <bool IsLeafV, typename AccessorT>
+void StringBTree<CharT, KeyCacheLen, PtFormatV>::BuildKeyCache(
+    NodeT<IsLeafV>* node, const AccessorT& dna_data,
+    const std::vector<std::pair<str_pos_t, in_blk_pos_t>>& strs) {
+    if constexpr (KeyCacheLen == 0) {
+        return;
+    }
+
+    // Strings are sorted, so common prefix of node is LCP of first and last strings
+    const str_pos_t first_str = strs.front().first;
+    const str_pos_t last_str = strs.back().first;
+    const str_len_t max_offset =
+        std::min<str_len_t>(dna_data.StrSize(first_str), dna_data.StrSize(last_str));
+
+    str_len_t offset = 0;
+    while (offset < max_offset && dna_data[first_str + offset] == dna_data[last_str + offset]) {
+        ++offset;
+    }
+    node->key_cache_offset = offset;
+
+    for (std::size_t i_str = 0; i_str < strs.size(); ++i_str) {
+        const str_pos_t str_pos = strs[i_str].first;
+        u8* str_cache = node->KeyCacheBegin() + i_str * c_key_cache_str_size;
+        for (uint i = 0; i < KeyCacheLen; ++i) {
+            const str_len_t symb_pos = offset + i;
+            CharT symb = CharT{};
+            if (symb_pos < dna_data.StrSize(str_pos)) {
+                symb = dna_data[str_pos + symb_pos];
+            }
+            DNA_PT::WritePackedChar(str_cache, i, symb);
+        }
+    }
 }
 
-template <typename CharT>
-void StringBTree<CharT>::DumpExt(const NodeBase* node_base) {
+template <typename CharT, uint KeyCacheLen, DNA_PT::Format PtFormatV>
+void StringBTree<CharT, KeyCacheLen, PtFormatV>::DumpExt(const NodeBase* node_base) const {
     if (node_base->type == NodeBase::Type::Inner) {
         const InnerNode* node = (const InnerNode*)node_base;
         const auto* ext_begin = node->ExtBegin();
-        const auto* ext_end = (const ExtItem<false>*)(&node->Ext + 1);
+        const auto* ext_end = ext_begin;
+        if constexpr (c_is_succinct) {
+            ext_end += node->NumExt();
+        } else {
+            ext_end = (const ExtItem<false>*)(&node->Ext + 1);
+        }
         for (auto ext_it = ext_begin; ext_it < ext_end; ++ext_it) {
             if (ext_it != ext_begin) {
                 std::cout << ", ";
@@ -564,7 +961,12 @@ void StringBTree<CharT>::DumpExt(const NodeBase* node_base) {
     } else {
         const LeafNode* node = (const LeafNode*)node_base;
         const auto* ext_begin = node->ExtBegin();
-        const auto* ext_end = (const ExtItem<true>*)(&node->Ext + 1);
+        const auto* ext_end = ext_begin;
+        if constexpr (c_is_succinct) {
+            ext_end += node->NumExt();
+        } else {
+            ext_end = (const ExtItem<true>*)(&node->Ext + 1);
+        }
         for (auto ext_it = ext_begin; ext_it < ext_end; ++ext_it) {
             if (ext_it != ext_begin) {
                 std::cout << ", ";
@@ -574,17 +976,4 @@ void StringBTree<CharT>::DumpExt(const NodeBase* node_base) {
     }
 }
 
-template <typename CharT>
-str_pos_t StringBTree<CharT>::GetSAPos(const NodeBase* node, in_blk_pos_t ext_pos) {
-    assert(node->IsLeaf());
-
-    const auto global_sa_pos = node->suff_arr_left_size;
-
-    const LeafNode* leaf_node = (const LeafNode*)node;
-    const auto local_sa_pos =
-        (ext_pos - leaf_node->GetExtPosBegin()) / sizeof(LeafNode::ExtItemT::str_pos);
-
-    return global_sa_pos + local_sa_pos;
-}
-
 }  // namespace DNA_SBT
@@ -0,0 +1,327 @@
+#pragma once
+
+#include "patricia_trie.h"
+
+#include <limits>
+
+namespace DNA_PT {
+
+// Layout of PT inside SBT node
+enum class Format : u8 { Pointer, Succinct };
+
+/*
+    Succinct PT of sorted strings s_0 <= ... <= s_{n-1} of SBT node: for every i in [1, n)
+    entry with lcp_i = lcp(s_{i-1}, s_i) as varint and branch symbols s_{i-1}[lcp_i], s_i[lcp_i]
+    packed in 3-bit symbols (CharT{} after end of string). It is the same trie without pointers:
+    node of depth l is maximal run of strings with lcp_i >= l, its branches are split by entries
+    with lcp_i == l. Varint is lcp_i + 1, 0 - equal strings (L == R of SBT child).
+
+    Entries are grouped by c_chunk_size, directory of chunks before entries keeps begin and
+    lower bound of lcp of every chunk, so subtree of branch is skipped by chunks.
+
+    Search is two scans inside of block: blind descent, that skips subtrees of branches not
+    matching pattern, and search of subtree of hit node.
+*/
+template <typename CharT>
+class SuccinctPT {
+public:
+    constexpr static uint c_symb_pair_size =
+        DivUp(2 * c_char_num_symb<CharT> * DnaSymbBitSize, 8u);
+    constexpr static uint c_chunk_size = 32;
+    constexpr static u8 c_max_chunk_lcp = 255;
+
+    PACKED_STRUCT Chunk {
+        in_blk_pos_t entries_pos;  // From begin of entries
+        u8 min_lcp;                // Lower bound of lcp of entries, 255 - all lcp >= 255
+    };
+
+    // Enough for any number of entries in block
+    constexpr static uint c_max_directory_size =
+        DivUp(g_block_size / (1 + c_symb_pair_size), c_chunk_size) * sizeof(Chunk);
+
+    struct Entry {
+        str_len_t lcp;
+        CharT left_symb;
+        CharT right_symb;
+        bool is_duplicate;
+    };
+
+    struct SearchRangeResult {
+        uint i_str_left;   // Lower bound, number of strings less then pattern
+        uint i_str_right;  // Upper bound
+        str_len_t lcp;
+        bool is_text_read;
+    };
+
+    static uint CalcEntrySize(const Entry& entry) noexcept {
+        uint size = 1;
+        for (uint64_t value = GetVarintValue(entry); value >= 0x80; value >>= 7) {
+            ++size;
+        }
+        return size + c_symb_pair_size;
+    }
+
+    static uint CalcNumChunk(uint num_str) noexcept {
+        return DivUp(num_str - 1, c_chunk_size);
+    }
+
+    template <typename AccessorT>
+    static Entry MakeEntry(const AccessorT& dna, str_pos_t left_str, str_pos_t right_str);
+
+    // strs - sorted strings, positions in PT are not used
+    template <typename AccessorT>
+    static void BuildAndEmplacePT(const AccessorT& dna,
+                                  const std::vector<std::pair<str_pos_t, in_blk_pos_t>>& strs,
+                                  u8* dest, size_t dest_size);
+
+    // get_str(i) - position in text of i-th string
+    template <typename AccessorT, typename GetStrT>
+    static SearchRangeResult SearchRange(const AccessorT& pattern, const u8* pt, uint num_str,
+                                         GetStrT get_str, str_len_t last_lcp,
+                                         const AccessorT& dna_text,
+                                         const KeyCacheView<CharT>& key_cache = {});
+
+private:
+    static uint64_t GetVarintValue(const Entry& entry) noexcept {
+        return entry.is_duplicate ? 0 : uint64_t(entry.lcp) + 1;
+    }
+
+    // Exact minimum of lcp of chunk, that is read from entries if min_lcp is saturated
+    static str_len_t GetChunkMinLcp(const Chunk* chunks, const u8* entries_begin, uint i_chunk,
+                                    uint num_str) noexcept {
+        if (chunks[i_chunk].min_lcp < c_max_chunk_lcp) {
+            return chunks[i_chunk].min_lcp;
+        }
+
+        str_len_t min_lcp = std::numeric_limits<str_len_t>::max();
+        const u8* it = entries_begin + chunks[i_chunk].entries_pos;
+        const uint i_end = std::min((i_chunk + 1) * c_chunk_size + 1, num_str);
+        for (uint i = i_chunk * c_chunk_size + 1; i < i_end; ++i, it += c_symb_pair_size) {
+            min_lcp = std::min(min_lcp, ReadLcp(it));
+        }
+        return min_lcp;
+    }
+
+    // Entry without symbols, equal strings have infinite lcp
+    static str_len_t ReadLcp(const u8*& it) noexcept {
+        uint64_t value = *it++;
+        if (value & 0x80) {
+            value &= 0x7F;
+            for (uint shift = 7;; shift += 7) {
+                const u8 byte = *it++;
+                value |= uint64_t(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    break;
+                }
+            }
+        }
+
+        return value ? value - 1 : std::numeric_limits<str_len_t>::max();
+    }
+};
+
+template <typename CharT>
+template <typename AccessorT>
+typename SuccinctPT<CharT>::Entry SuccinctPT<CharT>::MakeEntry(const AccessorT& dna,
+                                                               str_pos_t left_str,
+                                                               str_pos_t right_str) {
+    if (left_str == right_str) {
+        return {0, CharT{}, CharT{}, true};
+    }
+
+    const str_len_t left_size = dna.StrSize(left_str);
+    const str_len_t right_size = dna.StrSize(right_str);
+    const str_len_t max_lcp = std::min(left_size, right_size);
+
+    str_len_t lcp = 0;
+    while (lcp < max_lcp && dna[left_str + lcp] == dna[right_str + lcp]) {
+        ++lcp;
+    }
+
+    Entry entry{lcp, CharT{}, CharT{}, false};
+    if (lcp < left_size) {
+        entry.left_symb = dna[left_str + lcp];
+    }
+    if (lcp < right_size) {
+        entry.right_symb = dna[right_str + lcp];
+    }
+    assert(entry.left_symb < entry.right_symb);
+
+    return entry;
+}
+
+template <typename CharT>
+template <typename AccessorT>
+void SuccinctPT<CharT>::BuildAndEmplacePT(
+    const AccessorT& dna, const std::vector<std::pair<str_pos_t, in_blk_pos_t>>& strs, u8* dest,
+    size_t dest_size) {
+    const uint num_chunk = CalcNumChunk(strs.size());
+    Chunk* chunks = (Chunk*)dest;
+    u8* entries_begin = dest + num_chunk * sizeof(Chunk);
+    const u8* dest_end = dest + dest_size;
+
+    u8* it = entries_begin;
+    for (std::size_t i_str = 1; i_str < strs.size(); ++i_str) {
+        const Entry entry = MakeEntry(dna, strs[i_str - 1].first, strs[i_str].first);
+        if (it + CalcEntrySize(entry) > dest_end) {
+            throw std::runtime_error{"Succinct PT does not fit in node"};
+        }
+
+        Chunk& chunk = chunks[(i_str - 1) / c_chunk_size];
+        const u8 lcp = entry.is_duplicate ? c_max_chunk_lcp
+                                          : std::min<str_len_t>(entry.lcp, c_max_chunk_lcp);
+        if ((i_str - 1) % c_chunk_size == 0) {
+            chunk = {in_blk_pos_t(it - entries_begin), lcp};
+        }
+        chunk.min_lcp = std::min(chunk.min_lcp, lcp);
+
+        uint64_t value = GetVarintValue(entry);
+        for (; value >= 0x80; value >>= 7) {
+            *it++ = u8(value) | 0x80;
+        }
+        *it++ = u8(value);
+
+        std::fill(it, it + c_symb_pair_size, 0);
+        WritePackedChar(it, 0, entry.left_symb);
+        WritePackedChar(it, 1, entry.right_symb);
+        it += c_symb_pair_size;
+    }
+}
+
+template <typename CharT>
+template <typename AccessorT, typename GetStrT>
+typename SuccinctPT<CharT>::SearchRangeResult SuccinctPT<CharT>::SearchRange(
+    const AccessorT& pattern, const u8* pt, uint num_str, GetStrT get_str, str_len_t last_lcp,
+    const AccessorT& dna, const KeyCacheView<CharT>& key_cache) {
+    constexpr str_len_t c_inf_lcp = std::numeric_limits<str_len_t>::max();
+
+    const uint num_chunk = CalcNumChunk(num_str);
+    const Chunk* chunks = (const Chunk*)pt;
+    const u8* entries_begin = pt + num_chunk * sizeof(Chunk);
+
+    auto get_pattern_symb = [&](str_len_t i) {
+        return i < pattern.Size() ? pattern[i] : CharT{};
+    };
+
+    // Blind descent: candidate agrees with pattern on every passed branch. Branch of depth
+    // more then min_lcp is inside of subtree, that is skipped after mismatch at min_lcp
+    uint i_blind = 0;
+    str_len_t min_lcp = c_inf_lcp;
+    for (uint i_chunk = 0; i_chunk < num_chunk; ++i_chunk) {
+        if (chunks[i_chunk].min_lcp > min_lcp) {
+            continue;
+        }
+
+        const u8* it = entries_begin + chunks[i_chunk].entries_pos;
+        const uint i_end = std::min((i_chunk + 1) * c_chunk_size + 1, num_str);
+        for (uint i = i_chunk * c_chunk_size + 1; i < i_end; ++i, it += c_symb_pair_size) {
+            const str_len_t lcp = ReadLcp(it);
+            if (lcp == c_inf_lcp || lcp > min_lcp) {
+                continue;
+            }
+
+            if (get_pattern_symb(lcp) == ReadPackedChar<CharT>(it, 1)) {
+                i_blind = i;
+                min_lcp = c_inf_lcp;
+            } else {
+                min_lcp = lcp;
+            }
+        }
+    }
+
+    const str_pos_t str_pos = get_str(i_blind);
+
+    bool is_text_read = false;
+    auto get_str_symb = [&](str_len_t i) -> CharT {
+        if (key_cache.Contains(i)) {
+            return key_cache.GetByIndex(i_blind, i);
+        }
+        is_text_read = true;
+        return dna[str_pos + i];
+    };
+
+    // Find lcp
+    str_len_t lcp = last_lcp;
+    const str_len_t str_size = dna.StrSize(str_pos);
+    const str_len_t max_lcp = std::min<str_len_t>(pattern.Size(), str_size);
+    for (; lcp < max_lcp; ++lcp) {
+        if (pattern[lcp] != get_str_symb(lcp)) {
+            break;
+        }
+    }
+
+    // Subtree of hit node: strings [i_begin, i_end) around blind string with lcp_i >= lcp.
+    // Its branches are split by entries with lcp_i == lcp, symbols of branches are increased
+    const bool is_pattern_end = lcp == pattern.Size();
+    const CharT pat_symb = get_pattern_symb(lcp);
+
+    uint i_begin = 0;
+    uint i_end = num_str;
+    bool is_split = false;
+    CharT first_branch_symb{};
+    uint i_bound = 0;  // First split with branch symbol greater then pattern
+    bool is_bound = false;
+
+    // Chunks without splits and bounds of subtree are skipped, begin of subtree is in the last
+    // chunk before blind string with smaller lcp. Saturated min_lcp is only lower bound, so for
+    // lcp above it exact minimum is read
+    const str_len_t min_skip_lcp = is_pattern_end ? lcp : lcp + 1;
+    uint i_chunk = i_blind ? (i_blind - 1) / c_chunk_size : 0;
+    while (i_chunk > 0 && (chunks[i_chunk - 1].min_lcp >= lcp ||
+                           (chunks[i_chunk - 1].min_lcp == c_max_chunk_lcp &&
+                            GetChunkMinLcp(chunks, entries_begin, i_chunk - 1, num_str) >= lcp))) {
+        --i_chunk;
+    }
+    i_chunk -= i_chunk > 0;
+
+    for (; i_chunk < num_chunk && i_end == num_str; ++i_chunk) {
+        if (chunks[i_chunk].min_lcp >= min_skip_lcp) {
+            continue;
+        }
+
+        const u8* it = entries_begin + chunks[i_chunk].entries_pos;
+        const uint i_chunk_end = std::min((i_chunk + 1) * c_chunk_size + 1, num_str);
+        for (uint i = i_chunk * c_chunk_size + 1; i < i_chunk_end; ++i, it += c_symb_pair_size) {
+            const str_len_t entry_lcp = ReadLcp(it);
+            if (entry_lcp < lcp) {
+                if (i > i_blind) {
+                    i_end = i;
+                    break;
+                }
+                i_begin = i;
+                is_split = false;
+                is_bound = false;
+            } else if (entry_lcp == lcp && !is_pattern_end) {
+                if (!is_split) {
+                    first_branch_symb = ReadPackedChar<CharT>(it, 0);
+                    is_split = true;
+                }
+                if (!is_bound && pat_symb < ReadPackedChar<CharT>(it, 1)) {
+                    i_bound = i;
+                    is_bound = true;
+                }
+            }
+        }
+    }
+
+    if (is_pattern_end) {
+        // Every string of subtree has pattern as prefix
+        return {i_begin, i_end, lcp, is_text_read};
+    }
+
+    if (!is_split) {
+        // One branch, string ended at lcp is less then any symbol
+        first_branch_symb = lcp < str_size ? get_str_symb(lcp) : CharT{};
+    }
+
+    uint i_str = i_end;
+    if (pat_symb < first_branch_symb) {
+        i_str = i_begin;
+    } else if (is_bound) {
+        i_str = i_bound;
+    }
+
+    return {i_str, i_str, lcp, is_text_read};
+}
+
+}  // namespace DNA_PT
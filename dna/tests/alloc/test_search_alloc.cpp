@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../blocking_cost_model.h"
+#include "../../dna.h"
+#include "../../string_btree.h"
+
+// Separate binary: global new and delete are replaced to count heap allocations of searches
+
+static std::atomic<std::size_t> g_num_alloc = 0;
+
+static void* CountedAlloc(std::size_t size) {
+    ++g_num_alloc;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size) {
+    return CountedAlloc(size);
+}
+
+void* operator new[](std::size_t size) {
+    return CountedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+using SbtT = DNA_SBT::StringBTree<DnaSymb>;
+
+TEST(SEARCH_ALLOC, STRING_BTREE_SEARCH) {
+    const auto dir = std::filesystem::temp_directory_path() /
+                     ("search_alloc_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+
+    const std::string text_path = dir / "dna";
+    const std::string comp_path = text_path + ".comp";
+    const std::string sa_path = comp_path + ".sa";
+    const std::string sbt_path = comp_path + ".sbt";
+
+    std::mt19937_64 gen{0xA11C};
+    std::string text(100'000, 'A');
+    for (auto& symb : text) {
+        symb = "ACGT"[gen() % 4];
+    }
+    std::ofstream{text_path} << text;
+
+    BuildCompressedDnaFromTextDna(text_path, comp_path);
+    BuildSuffArrayFromComprDna(comp_path, sa_path);
+    {
+        ObjectFileHolder dna_file_holder{comp_path};
+        SbtT::Build(sbt_path, DnaDataAccessor{dna_file_holder}, sa_path);
+    }
+
+    ObjectFileHolder dna_file_holder{comp_path};
+    DnaDataAccessor dna{dna_file_holder};
+    SbtT sbt{sbt_path};
+
+    std::vector<DnaBuffer> patterns;
+    for (unsigned i_query = 0; i_query < 1000; ++i_query) {
+        const std::size_t len = 1 + gen() % 24;
+        const auto pos = gen() % (text.size() - len);
+        patterns.emplace_back(dna, pos, pos + len);
+    }
+
+    // Search of one pattern is a single pass over nodes without heap
+    std::vector<SbtT::SearchResult> results(patterns.size());
+    const std::size_t num_alloc_before = g_num_alloc;
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+        results[i] = sbt.Search(patterns[i].GetAccessor(), dna);
+    }
+    ASSERT_EQ(g_num_alloc, num_alloc_before);
+
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+        ASSERT_EQ(results[i].lcp, patterns[i].GetAccessor().Size()) << i;
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(SEARCH_ALLOC, COST_MODEL_CHOOSE) {
+    std::vector<BlockingCostModel::Sample> samples;
+    for (u8 d : {1, 4}) {
+        for (str_len_t pattern_len : {8, 16, 32, 64}) {
+            samples.push_back({d, pattern_len, d == 1 ? 0.5 * pattern_len : 10.0});
+        }
+    }
+    const auto model = BlockingCostModel::Fit(samples);
+    const std::vector<u8> ds{1, 4};
+
+    // d of every pattern is chosen without heap
+    const std::size_t num_alloc_before = g_num_alloc;
+    std::size_t num_d4 = 0;
+    for (str_len_t pattern_len = 1; pattern_len < 100; ++pattern_len) {
+        num_d4 += model.Choose(ds, pattern_len) == 4;
+    }
+    ASSERT_EQ(g_num_alloc, num_alloc_before);
+    ASSERT_EQ(num_d4, 79);
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../blocked_index.hpp"
+#include "../query_executor.hpp"
+
+TEST(BLOCKED_INDEX, CONTAINS_AS_FIND) {
+    const auto dir = std::filesystem::temp_directory_path() /
+                     ("blocked_index_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+
+    const std::string text_path = dir / "dna";
+    std::mt19937_64 gen{0xB0B};
+
+    // Repeated part gives hits, that are not aligned to d
+    std::string text(20'000, 'A');
+    for (auto& symb : text) {
+        symb = "ACGT"[gen() % 4];
+    }
+    text += text.substr(1'001, 5'000);
+    std::ofstream{text_path} << text;
+
+    // lcm of 1, 3 and 4
+    BuildCompressedDnaFromTextDna(text_path, NameGenerator{text_path, 1}.GetCompressedTextPath(),
+                                  12);
+    ASSERT_THROW(DispatchBlockSize(c_max_block_size + 1, []<u8> {}), std::invalid_argument);
+
+    // Executor shares one searcher by workers
+    ThreadPool pool{4};
+    auto check = [&]<u8 d> {
+        BuildBlockedIndex<d>(text_path);
+        const QueryExecutor<d> executor{NameGenerator{text_path, d}, pool, 16};
+        const auto& searcher = executor.GetSearcher();
+
+        std::vector<std::string> patterns;
+        for (int i = 0; i < 300; ++i) {
+            const std::size_t len = d + 1 + gen() % 40;
+            std::string pattern = text.substr(gen() % (text.size() - len), len);
+            if (i % 2) {
+                pattern[gen() % len] = "ACGT"[gen() % 4];
+            }
+            ASSERT_EQ(searcher.Contains(searcher.Prepare(pattern)),
+                      text.find(pattern) != std::string::npos)
+                << (uint)d << ' ' << pattern;
+            patterns.push_back(std::move(pattern));
+        }
+
+        const auto is_found = executor.Contains(patterns);
+        for (std::size_t i = 0; i < patterns.size(); ++i) {
+            ASSERT_EQ(is_found[i], searcher.Contains(searcher.Prepare(patterns[i]))) << i;
+        }
+    };
+    DispatchBlockSize(1, check);
+    DispatchBlockSize(3, check);
+    DispatchBlockSize(4, check);
+
+    // Front-end chooses d of every pattern by cost model of built indexes
+    std::vector<BlockingCostModel::Sample> samples;
+    for (u8 d : {1, 3, 4}) {
+        for (str_len_t pattern_len : {8, 16, 32}) {
+            samples.push_back({d, pattern_len, 10.0 / d + pattern_len});
+        }
+    }
+    BlockingCostModel::Fit(samples).Save(NameGenerator{text_path, 1}.GetCostModelPath());
+
+    const MultiBlockedSearcher<1, 2, 3, 4> multi_searcher{text_path};
+    ASSERT_EQ(multi_searcher.GetBlockSizes(), (std::vector<u8>{1, 3, 4}));
+    for (int i = 0; i < 200; ++i) {
+        const std::size_t len = 2 + gen() % 30;
+        std::string pattern = text.substr(gen() % (text.size() - len), len);
+        if (i % 2) {
+            pattern[gen() % len] = "ACGT"[gen() % 4];
+        }
+        ASSERT_EQ(multi_searcher.Contains(pattern), text.find(pattern) != std::string::npos)
+            << pattern;
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+
+#include "../blocking_cost_model.h"
+
+namespace {
+
+// d = 1 is cheap for short patterns, d = 4 for long ones
+double Latency(u8 d, str_len_t pattern_len) {
+    return d == 1 ? 2.0 + 0.5 * pattern_len : 10.0 + 0.1 * pattern_len;
+}
+
+}  // namespace
+
+TEST(BLOCKING_COST_MODEL, FIT_CHOOSE) {
+    std::vector<BlockingCostModel::Sample> samples;
+    for (u8 d : {1, 4}) {
+        for (str_len_t pattern_len : {8, 16, 32, 64}) {
+            samples.push_back({d, pattern_len, Latency(d, pattern_len)});
+        }
+    }
+    samples.push_back({2, 16, 7.0});
+
+    const auto model = BlockingCostModel::Fit(samples);
+    ASSERT_TRUE(model.Has(1));
+    ASSERT_TRUE(model.Has(2));
+    ASSERT_TRUE(model.Has(4));
+    ASSERT_FALSE(model.Has(3));
+
+    for (str_len_t pattern_len : {8, 20, 100}) {
+        ASSERT_NEAR(model.Estimate(1, pattern_len), Latency(1, pattern_len), 1e-9);
+        ASSERT_NEAR(model.Estimate(4, pattern_len), Latency(4, pattern_len), 1e-9);
+        ASSERT_NEAR(model.Estimate(2, pattern_len), 7.0, 1e-9);
+    }
+
+    // Crossing of d = 1 and d = 4 is at 20
+    const std::vector<u8> ds{1, 4};
+    ASSERT_EQ(model.Choose(ds, 10), 1);
+    ASSERT_EQ(model.Choose(ds, 30), 4);
+    ASSERT_EQ(model.Choose(ds, std::vector<str_len_t>{4, 10, 64}), 1);
+    ASSERT_EQ(model.Choose(ds, std::vector<str_len_t>{16, 64, 64}), 4);
+
+    // Pattern must be longer then d
+    ASSERT_EQ(model.Choose({2, 4}, 3), 2);
+    ASSERT_THROW(model.Choose({4}, 4), std::invalid_argument);
+    ASSERT_THROW(model.Choose({3}, 30), std::invalid_argument);
+}
+
+TEST(BLOCKING_COST_MODEL, SAVE_LOAD) {
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("cost_model_test_" + std::to_string(getpid()));
+
+    const auto model = BlockingCostModel::Fit({{1, 8, 3.25}, {1, 16, 4.5}, {7, 64, 1.0 / 3}});
+    model.Save(path.string());
+
+    const auto loaded = BlockingCostModel::Load(path.string());
+    for (u8 d = 1; d <= BlockingCostModel::c_max_d; ++d) {
+        ASSERT_EQ(loaded.Has(d), model.Has(d));
+        if (model.Has(d)) {
+            ASSERT_EQ(loaded.Estimate(d, 20), model.Estimate(d, 20));
+        }
+    }
+
+    std::filesystem::remove(path);
+    ASSERT_THROW(BlockingCostModel::Load(path.string()), std::runtime_error);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../dna.h"
+#include "../document_index.h"
+#include "../string_btree.h"
+
+TEST(DOCUMENT_INDEX, LIST_RANDOM) {
+    using SbtT = DNA_SBT::StringBTree<DnaSymb>;
+
+    const std::filesystem::path dir =
+        std::filesystem::temp_directory_path() / ("doc_index_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+
+    const std::string text_path = dir / "dna";
+    const std::string comp_path = text_path + ".comp";
+    const std::string docs_path = comp_path + ".docs";
+    const std::string sa_path = comp_path + ".sa";
+    const std::string sbt_path = comp_path + ".sbt";
+    const std::string doc_index_path = comp_path + ".dl";
+
+    std::mt19937_64 gen{0xEDA};
+    const char* alph = "ACTG";
+
+    // Documents share pieces, so pattern is in several documents
+    const std::size_t num_docs = 300;
+    std::vector<std::string> docs(num_docs);
+    for (auto& doc : docs) {
+        doc.resize(10 + gen() % 500);
+        for (auto& symb : doc) {
+            symb = alph[gen() % 4];
+        }
+
+        const auto& other = docs[gen() % num_docs];
+        const std::size_t len = 5 + gen() % 30;
+        if (other.size() > len && doc.size() > len) {
+            const auto piece = other.substr(gen() % (other.size() - len), len);
+            doc.replace(gen() % (doc.size() - len), len, piece);
+        }
+    }
+    docs[7].clear();  // Empty record
+
+    {
+        std::ofstream fasta{text_path};
+        for (std::size_t i = 0; i < num_docs; ++i) {
+            fasta << ">doc " << i << '\n' << docs[i] << '\n';
+        }
+    }
+
+    BuildCompressedDocsDnaFromTextDna(text_path, comp_path, docs_path);
+    BuildSuffArrayFromComprDna(comp_path, sa_path);
+
+    ObjectFileHolder dna_file_holder{comp_path};
+    DnaDataAccessor dna{dna_file_holder};
+    SbtT::Build(sbt_path, dna, sa_path);
+
+    SbtT sbt{sbt_path};
+    auto doc_index = DocumentIndex::Build(doc_index_path, sa_path, docs_path);
+    ASSERT_EQ(doc_index.NumDocs(), num_docs);
+    ASSERT_EQ(doc_index.Size(), dna.Size());
+
+    for (unsigned i_query = 0; i_query < 2000; ++i_query) {
+        const auto& doc = docs[gen() % num_docs];
+        const std::size_t len = 1 + gen() % (i_query % 2 ? 12 : 4);
+        if (doc.size() < len) {
+            continue;
+        }
+        const auto pattern = doc.substr(gen() % (doc.size() - len + 1), len);
+
+        std::vector<doc_id_t> ref;
+        for (doc_id_t i_doc = 0; i_doc < num_docs; ++i_doc) {
+            if (docs[i_doc].find(pattern) != std::string::npos) {
+                ref.push_back(i_doc);
+            }
+        }
+
+        DnaBuffer pattern_buf{pattern};
+        auto [sa_pos_left, sa_pos_right] = sbt.SearchRange(pattern_buf.GetAccessor(), dna);
+
+        auto res = doc_index.ListDocuments(sa_pos_left, sa_pos_right);
+        std::sort(res.begin(), res.end());
+        ASSERT_EQ(res, ref) << pattern;
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../dna.h"
+#include "../fm_index.hpp"
+
+namespace {
+
+// Text with symbols in order of DnaSymb, to compare suffixes as strings
+std::string ToSymbOrder(std::string str) {
+    for (auto& symb : str) {
+        symb = (char)ConvertTextDnaSymb2DnaSymb(symb).first;
+    }
+    return str;
+}
+
+}  // namespace
+
+TEST(FM_INDEX, COUNT_LOCATE_RANDOM) {
+    const auto dir = std::filesystem::temp_directory_path() /
+                     ("fm_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+
+    const std::string text_path = dir / "dna";
+    const std::string comp_path = text_path + ".comp";
+    const std::string sa_path = comp_path + ".sa";
+    const std::string fm_path = comp_path + ".fm";
+
+    for (std::size_t text_size : {1'000, 50'000}) {
+        std::mt19937_64 gen{0xF1D + text_size};
+
+        std::string text(text_size, 'A');
+        for (auto& symb : text) {
+            symb = "ACTG"[gen() % 4];
+        }
+
+        // Repeats for many occurrences
+        for (std::size_t i = 0; i + 200 < text_size; i += 1000) {
+            text.replace(i + 100, 60, text.substr(i, 60));
+        }
+
+        std::ofstream{text_path} << text;
+        BuildCompressedDnaFromTextDna(text_path, comp_path);
+        BuildSuffArrayFromComprDna(comp_path, sa_path);
+
+        ObjectFileHolder dna_file_holder{comp_path};
+        DnaDataAccessor dna{dna_file_holder};
+
+        ObjectFileHolder suff_arr_holder{sa_path};
+        const str_pos_t* suff_arr = (const str_pos_t*)suff_arr_holder.cbegin();
+
+        // Every SA position is walked with small sample rate
+        for (FMIndex::size_t sample_rate : {1u, 7u, FMIndex::c_default_sample_rate}) {
+            auto fm_file = FMIndexOnDisk::Build(fm_path, dna, sa_path, sample_rate);
+            const auto& fm = fm_file.Get();
+
+            for (str_pos_t sa_pos = 0; sa_pos < dna.Size(); sa_pos += 1 + gen() % 10) {
+                ASSERT_EQ(fm.Locate(sa_pos), suff_arr[sa_pos]) << sa_pos;
+            }
+
+            const auto text_symb = ToSymbOrder(text);
+            for (unsigned i_query = 0; i_query < 300; ++i_query) {
+                const std::size_t len = 1 + gen() % (i_query % 2 ? 24 : 5);
+
+                std::string pattern;
+                if (i_query % 3) {
+                    pattern = text.substr(gen() % (text.size() - len), len);
+                } else {
+                    for (std::size_t i = 0; i < len; ++i) {
+                        pattern += "ACTG"[gen() % 4];
+                    }
+                }
+
+                std::vector<str_pos_t> ref;
+                const auto pattern_symb = ToSymbOrder(pattern);
+                for (auto pos = text_symb.find(pattern_symb); pos != std::string::npos;
+                     pos = text_symb.find(pattern_symb, pos + 1)) {
+                    ref.push_back(pos);
+                }
+
+                DnaBuffer pattern_buf{pattern};
+                const auto pattern_dna = pattern_buf.GetAccessor();
+                ASSERT_EQ(fm.Count(pattern_dna), ref.size()) << pattern;
+
+                auto poss = fm.Locate(pattern_dna);
+                std::sort(poss.begin(), poss.end());
+                ASSERT_EQ(poss, ref) << pattern;
+            }
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <unordered_set>
+
+#include "../genome_generator.h"
+
+namespace {
+
+std::string Generate(const GenomeGenParams& params) {
+    std::string genome;
+    GenomeGenerator{params}.Generate([&](char symb) { genome += symb; });
+    return genome;
+}
+
+// Share of k-mers of genome, that occur more then once
+double CalcRepeatedShare(const std::string& genome, std::size_t k) {
+    std::unordered_set<std::string_view> kmers;
+    std::size_t num_repeated = 0;
+    for (std::size_t pos = 0; pos + k <= genome.size(); ++pos) {
+        num_repeated += !kmers.insert(std::string_view{genome}.substr(pos, k)).second;
+    }
+    return double(num_repeated) / (genome.size() - k + 1);
+}
+
+}  // namespace
+
+TEST(GENOME_GENERATOR, SEED_GC_CONTENT) {
+    GenomeGenParams params;
+    params.size = 300'000;
+    params.gc_content = 0.6;
+    params.tandem_rate = params.interspersed_rate = params.n_run_rate = 0;
+
+    const auto genome = Generate(params);
+    ASSERT_EQ(genome.size(), params.size);
+    ASSERT_EQ(genome, Generate(params));
+
+    const auto num_gc = std::count_if(genome.begin(), genome.end(),
+                                      [](char symb) { return symb == 'C' || symb == 'G'; });
+    ASSERT_NEAR(double(num_gc) / genome.size(), params.gc_content, 0.01);
+
+    params.seed += 1;
+    ASSERT_NE(genome, Generate(params));
+
+    params.markov_order = GenomeGenerator::c_max_markov_order + 1;
+    ASSERT_THROW(GenomeGenerator{params}, std::invalid_argument);
+}
+
+TEST(GENOME_GENERATOR, REPEATS_N_RUNS) {
+    GenomeGenParams params;
+    params.size = 300'000;
+    params.tandem_rate = params.interspersed_rate = params.n_run_rate = 0;
+
+    const double background_share = CalcRepeatedShare(Generate(params), 32);
+
+    params.tandem_rate = 2e-4;
+    params.interspersed_rate = 5e-4;
+    params.n_run_rate = 5e-5;
+    const auto genome = Generate(params);
+    ASSERT_EQ(genome.size(), params.size);
+    ASSERT_NE(genome.find('N'), std::string::npos);
+
+    // Copies of repeats share long substrings, random background does not
+    ASSERT_LT(background_share, 0.01);
+    ASSERT_GT(CalcRepeatedShare(genome, 32), 0.1);
+}
+
+TEST(GENOME_GENERATOR, COMP_AS_OF_FASTA) {
+    const auto dir = std::filesystem::temp_directory_path() /
+                     ("genome_generator_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+
+    const std::string fasta_path = dir / "genome.fa";
+    const std::string comp_path = dir / "genome.comp";
+    const std::string fasta_comp_path = fasta_path + ".comp";
+
+    GenomeGenParams params;
+    params.size = 100'000;
+    params.n_run_rate = 1e-4;
+    params.seed = 0xB0B;
+
+    for (uint d_max : {1, 4}) {
+        GenerateGenomeFasta(fasta_path, params);
+        auto fasta_dna_file = BuildCompressedDnaFromTextDna(fasta_path, fasta_comp_path, d_max);
+        auto dna_file = GenerateGenomeComp(comp_path, params, d_max);
+
+        ASSERT_EQ(dna_file.Size(), fasta_dna_file.Size());
+        ASSERT_LT(dna_file.Size(), params.size);
+        ASSERT_EQ(std::filesystem::file_size(comp_path),
+                  std::filesystem::file_size(fasta_comp_path));
+
+        DnaDataAccessor dna{dna_file}, fasta_dna{fasta_dna_file};
+        for (uint64_t pos = 0; pos < dna.Size(); ++pos) {
+            ASSERT_EQ(dna[pos], fasta_dna[pos]) << pos;
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+}
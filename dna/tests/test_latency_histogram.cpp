@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "../../common/latency_histogram.h"
+
+TEST(LATENCY_HISTOGRAM, PERCENTILES_AS_SORT) {
+    std::mt19937_64 gen{0xB0B};
+
+    // Heavy tail: most values are short, rare values are orders longer
+    std::vector<uint64_t> values(100'000);
+    LatencyHistogram first_half, second_half;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = gen() % 8 == 0 ? gen() % 10'000'000 : 500 + gen() % 5'000;
+        (i % 2 ? first_half : second_half).Record(values[i]);
+    }
+
+    LatencyHistogram hist = first_half;
+    hist.Merge(second_half);
+    ASSERT_EQ(hist.GetCount(), values.size());
+
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(hist.GetMax(), values.back());
+    ASSERT_EQ(hist.GetPercentile(100), values.back());
+
+    for (double percentile : {1.0, 50.0, 90.0, 99.0, 99.9}) {
+        const auto exact =
+            values[std::size_t(std::ceil(percentile / 100 * values.size())) - 1];
+        const auto approx = hist.GetPercentile(percentile);
+        ASSERT_GE(approx, exact) << percentile;
+        ASSERT_LE(approx - exact, exact / 64) << percentile;
+    }
+
+    // Small values are exact, largest values do not overflow
+    LatencyHistogram edge_hist;
+    for (uint64_t value : {uint64_t{0}, uint64_t{3}, uint64_t{127},
+                           std::numeric_limits<uint64_t>::max()}) {
+        edge_hist.Record(value);
+    }
+    ASSERT_EQ(edge_hist.GetPercentile(25), 0);
+    ASSERT_EQ(edge_hist.GetPercentile(50), 3);
+    ASSERT_EQ(edge_hist.GetPercentile(75), 127);
+    ASSERT_EQ(edge_hist.GetPercentile(100), std::numeric_limits<uint64_t>::max());
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../dna.h"
+#include "../r_index.hpp"
+
+namespace {
+
+// Text with symbols in order of DnaSymb, to compare suffixes as strings
+std::string ToSymbOrder(std::string str) {
+    for (auto& symb : str) {
+        symb = (char)ConvertTextDnaSymb2DnaSymb(symb).first;
+    }
+    return str;
+}
+
+}  // namespace
+
+TEST(R_INDEX, COUNT_LOCATE_REPETITIVE) {
+    const auto dir = std::filesystem::temp_directory_path() /
+                     ("r_index_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+
+    const std::string text_path = dir / "dna";
+    const std::string comp_path = text_path + ".comp";
+    const std::string sa_path = comp_path + ".sa";
+    const std::string r_index_path = comp_path + ".ri";
+
+    // Copies of genome with rare mutations, and random text, where r is close to n
+    for (auto [genome_size, num_copies] : {std::pair{3'000, 20}, std::pair{5'000, 1}}) {
+        std::mt19937_64 gen{0xB0B + std::size_t(genome_size)};
+
+        std::string genome(genome_size, 'A');
+        for (auto& symb : genome) {
+            symb = "ACTG"[gen() % 4];
+        }
+
+        std::string text;
+        for (int i_copy = 0; i_copy < num_copies; ++i_copy) {
+            auto copy = genome;
+            for (int i_mut = 0; i_mut < 5; ++i_mut) {
+                copy[gen() % copy.size()] = "ACTG"[gen() % 4];
+            }
+            text += copy;
+        }
+
+        std::ofstream{text_path} << text;
+        BuildCompressedDnaFromTextDna(text_path, comp_path);
+        BuildSuffArrayFromComprDna(comp_path, sa_path);
+
+        ObjectFileHolder dna_file_holder{comp_path};
+        DnaDataAccessor dna{dna_file_holder};
+
+        auto r_index_file = RIndexOnDisk::Build(r_index_path, dna, sa_path);
+        const auto& r_index = r_index_file.Get();
+        if (num_copies > 1) {
+            ASSERT_LT(r_index.GetNumRuns() * 10, dna.Size());
+        }
+
+        const auto text_symb = ToSymbOrder(text);
+        for (unsigned i_query = 0; i_query < 300; ++i_query) {
+            const std::size_t len = 1 + gen() % (i_query % 2 ? 40 : 5);
+
+            std::string pattern;
+            if (i_query % 3) {
+                pattern = text.substr(gen() % (text.size() - len), len);
+            } else {
+                for (std::size_t i = 0; i < len; ++i) {
+                    pattern += "ACTG"[gen() % 4];
+                }
+            }
+
+            std::vector<str_pos_t> ref;
+            const auto pattern_symb = ToSymbOrder(pattern);
+            for (auto pos = text_symb.find(pattern_symb); pos != std::string::npos;
+                 pos = text_symb.find(pattern_symb, pos + 1)) {
+                ref.push_back(pos);
+            }
+
+            DnaBuffer pattern_buf{pattern};
+            const auto pattern_dna = pattern_buf.GetAccessor();
+            ASSERT_EQ(r_index.Count(pattern_dna), ref.size()) << pattern;
+
+            auto poss = r_index.Locate(pattern_dna);
+            std::sort(poss.begin(), poss.end());
+            ASSERT_EQ(poss, ref) << pattern;
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,412 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../dna.h"
+#include "../string_btree.h"
+
+namespace {
+
+using SbtT = DNA_SBT::StringBTree<DnaSymb>;
+
+// Text with symbols in order of DnaSymb, to compare suffixes as strings
+std::string ToSymbOrder(std::string str) {
+    for (auto& symb : str) {
+        symb = (char)ConvertTextDnaSymb2DnaSymb(symb).first;
+    }
+    return str;
+}
+
+class SbtData {
+public:
+    SbtData(std::size_t text_size, unsigned seed)
+        : SbtData{GenText(text_size, seed)} {}
+
+    explicit SbtData(std::string text)
+        : m_dir{std::filesystem::temp_directory_path() /
+                ("sbt_test_" + std::to_string(getpid()) + "_" + std::to_string(text.size()))}
+        , m_text{std::move(text)} {
+        std::filesystem::create_directories(m_dir);
+
+        std::ofstream{TextPath()} << m_text;
+        BuildCompressedDnaFromTextDna(TextPath(), CompPath());
+        BuildSuffArrayFromComprDna(CompPath(), SaPath());
+
+        ObjectFileHolder dna_file_holder{CompPath()};
+        SbtT::Build(SbtPath(), DnaDataAccessor{dna_file_holder}, SaPath());
+
+        m_text_symb = ToSymbOrder(m_text) + '\0';
+    }
+
+    ~SbtData() {
+        std::filesystem::remove_all(m_dir);
+    }
+
+    std::string TextPath() const {
+        return m_dir / "dna";
+    }
+    std::string CompPath() const {
+        return TextPath() + ".comp";
+    }
+    std::string SaPath() const {
+        return CompPath() + ".sa";
+    }
+    std::string SbtPath() const {
+        return CompPath() + ".sbt";
+    }
+
+    const std::string& Text() const noexcept {
+        return m_text;
+    }
+
+    std::vector<str_pos_t> FindAll(const std::string& pattern) const {
+        std::vector<str_pos_t> poss;
+        const auto pattern_symb = ToSymbOrder(pattern);
+        for (auto pos = m_text_symb.find(pattern_symb); pos != std::string::npos;
+             pos = m_text_symb.find(pattern_symb, pos + 1)) {
+            poss.push_back(pos);
+        }
+        return poss;
+    }
+
+private:
+    static std::string GenText(std::size_t text_size, unsigned seed) {
+        std::mt19937_64 gen{seed};
+        const char* alph = "ACTG";
+        std::string text(text_size, 'A');
+        for (auto& symb : text) {
+            symb = alph[gen() % 4];
+        }
+
+        // Repeats for long LCP
+        for (std::size_t i = 0; i + 200 < text_size; i += 1000) {
+            text.replace(i + 100, 60, text.substr(i, 60));
+        }
+        return text;
+    }
+
+    std::filesystem::path m_dir;
+    std::string m_text;
+    std::string m_text_symb;
+};
+
+}  // namespace
+
+TEST(STRING_BTREE, COUNT_LOCATE_RANDOM) {
+    for (std::size_t text_size : {1'000, 20'000, 200'000}) {
+        SbtData data{text_size, 0xEDA};
+        const auto& text = data.Text();
+
+        ObjectFileHolder dna_file_holder{data.CompPath()};
+        DnaDataAccessor dna{dna_file_holder};
+
+        ObjectFileHolder suff_arr_holder{data.SaPath()};
+        const str_pos_t* suff_arr = (const str_pos_t*)suff_arr_holder.cbegin();
+
+        SbtT sbt{data.SbtPath()};
+
+        std::mt19937_64 gen{0xDED};
+        for (unsigned i_query = 0; i_query < 1000; ++i_query) {
+            const std::size_t len = 1 + gen() % (i_query % 2 ? 24 : 5);
+
+            std::string pattern;
+            if (i_query % 3) {
+                pattern = text.substr(gen() % (text.size() - len), len);
+            } else {
+                for (std::size_t i = 0; i < len; ++i) {
+                    pattern += "ACTG"[gen() % 4];
+                }
+            }
+
+            DnaBuffer pattern_buf{pattern};
+            const auto pattern_dna = pattern_buf.GetAccessor();
+
+            auto ref = data.FindAll(pattern);
+            ASSERT_EQ(sbt.Count(pattern_dna, dna), ref.size()) << pattern;
+
+            std::vector<str_pos_t> poss;
+            for (str_pos_t pos : sbt.Locate(pattern_dna, dna, suff_arr)) {
+                poss.push_back(pos);
+            }
+            std::sort(poss.begin(), poss.end());
+            ASSERT_EQ(poss, ref) << pattern;
+
+            auto sorted_occs = sbt.Locate(pattern_dna, dna, suff_arr, true);
+            ASSERT_TRUE(std::equal(sorted_occs.begin(), sorted_occs.end(), ref.begin(), ref.end()))
+                << pattern;
+        }
+    }
+}
+
+TEST(STRING_BTREE, SEARCH_SINGLE_PASS) {
+    SbtData data{200'000, 0xBEE};
+    const auto& text = data.Text();
+
+    ObjectFileHolder dna_file_holder{data.CompPath()};
+    DnaDataAccessor dna{dna_file_holder};
+
+    ObjectFileHolder suff_arr_holder{data.SaPath()};
+    const str_pos_t* suff_arr = (const str_pos_t*)suff_arr_holder.cbegin();
+
+    SbtT sbt{data.SbtPath()};
+
+    std::mt19937_64 gen{0xDED};
+    std::vector<DnaBuffer> patterns;
+    for (unsigned i_query = 0; i_query < 1000; ++i_query) {
+        const std::size_t len = 1 + gen() % 24;
+        const auto pos = gen() % (text.size() - len);
+        patterns.emplace_back(dna, pos, pos + len);
+    }
+
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+        const auto pattern = patterns[i].GetAccessor();
+        const auto res = sbt.Search(pattern, dna);
+
+        ASSERT_EQ(res.sa_pos_left, sbt.SearchBound<DNA_PT::Bound::Lower>(pattern, dna));
+        ASSERT_EQ(res.sa_pos_right, sbt.SearchBound<DNA_PT::Bound::Upper>(pattern, dna));
+        ASSERT_LT(res.sa_pos_left, res.sa_pos_right);
+        ASSERT_EQ(res.lcp, pattern.Size());
+        ASSERT_EQ(res.str_pos, suff_arr[res.sa_pos_left]);
+    }
+}
+
+TEST(STRING_BTREE, SEARCH_BATCH) {
+    SbtData data{200'000, 0xBA7};
+    const auto& text = data.Text();
+
+    ObjectFileHolder dna_file_holder{data.CompPath()};
+    DnaDataAccessor dna{dna_file_holder};
+
+    SbtT sbt{data.SbtPath()};
+
+    std::mt19937_64 gen{0xDED};
+    for (unsigned i_batch = 0; i_batch < 200; ++i_batch) {
+        // Shifts of one substring, as offsets of blocked search, and random patterns
+        const std::size_t num_queries = 1 + gen() % SbtT::c_max_batch_queries;
+        const std::size_t pos = gen() % (text.size() - 64);
+
+        std::vector<DnaBuffer> buffers;
+        for (std::size_t i = 0; i < num_queries; ++i) {
+            const std::size_t len = 1 + gen() % 24;
+            if (i % 4 == 3) {
+                std::string pattern;
+                for (std::size_t j = 0; j < len; ++j) {
+                    pattern += "ACTG"[gen() % 4];
+                }
+                buffers.emplace_back(pattern);
+            } else {
+                buffers.emplace_back(dna, pos + i, pos + i + len);
+            }
+        }
+
+        std::vector<DnaDataAccessor> patterns;
+        for (const auto& buffer : buffers) {
+            patterns.push_back(buffer.GetAccessor());
+        }
+        std::vector<SbtT::BatchQuery<DnaDataAccessor>> queries;
+        for (const auto& pattern : patterns) {
+            queries.push_back({&pattern, &pattern});
+        }
+
+        // Without hit every query is finished
+        std::vector<SbtT::SearchResult> results(num_queries);
+        std::vector<bool> is_called(num_queries);
+        auto batch_res = sbt.SearchBatch(queries.data(), num_queries, dna, results.data(),
+                                         [&](std::size_t i, const auto&) {
+                                             is_called[i] = true;
+                                             return false;
+                                         });
+        ASSERT_EQ(batch_res.i_hit, num_queries);
+        ASSERT_EQ(std::count(is_called.begin(), is_called.end(), true), num_queries);
+
+        uint num_node_reads = 0;
+        for (std::size_t i = 0; i < num_queries; ++i) {
+            const auto res = sbt.Search(patterns[i], dna);
+            num_node_reads += res.stats.num_node_reads;
+
+            ASSERT_EQ(results[i].str_pos, res.str_pos);
+            ASSERT_EQ(results[i].sa_pos_left, res.sa_pos_left);
+            ASSERT_EQ(results[i].sa_pos_right, res.sa_pos_right);
+            ASSERT_EQ(results[i].lcp, res.lcp);
+        }
+        // Nodes, that are common for queries (at least root), are read once
+        if (num_queries > 1) {
+            ASSERT_LT(batch_res.stats.num_node_reads, num_node_reads);
+        } else {
+            ASSERT_EQ(batch_res.stats.num_node_reads, num_node_reads);
+        }
+
+        // Stop on first found pattern: query is checked once, hit is the last check
+        std::vector<std::size_t> called;
+        batch_res = sbt.SearchBatch(queries.data(), num_queries, dna, results.data(),
+                                    [&](std::size_t i, const SbtT::SearchResult& res) {
+                                        called.push_back(i);
+                                        return res.lcp == patterns[i].Size();
+                                    });
+        ASSERT_LT(batch_res.i_hit, num_queries);
+        ASSERT_EQ(results[batch_res.i_hit].lcp, patterns[batch_res.i_hit].Size());
+        ASSERT_EQ(called.back(), batch_res.i_hit);
+        std::sort(called.begin(), called.end());
+        ASSERT_EQ(std::unique(called.begin(), called.end()), called.end());
+    }
+
+    // Queries with the same path to leaf share all node reads
+    const DnaBuffer buffer{dna, 1'000, 1'020};
+    const auto pattern = buffer.GetAccessor();
+    const auto single_res = sbt.Search(pattern, dna);
+    const std::vector<SbtT::BatchQuery<DnaDataAccessor>> queries(4, {&pattern, &pattern});
+    SbtT::SearchResult results[4];
+    const auto batch_res = sbt.SearchBatch(queries.data(), queries.size(), dna, results,
+                                           [](std::size_t, const auto&) { return false; });
+    ASSERT_LT(batch_res.stats.num_node_reads, 4 * single_res.stats.num_node_reads);
+    for (const auto& res : results) {
+        ASSERT_EQ(res.sa_pos_left, single_res.sa_pos_left);
+        ASSERT_EQ(res.sa_pos_right, single_res.sa_pos_right);
+    }
+}
+
+TEST(STRING_BTREE, KEY_CACHE) {
+    using SbtCacheT = DNA_SBT::StringBTree<DnaSymb, 16>;
+
+    SbtData data{200'000, 0xCAC};
+    const auto& text = data.Text();
+
+    ObjectFileHolder dna_file_holder{data.CompPath()};
+    DnaDataAccessor dna{dna_file_holder};
+
+    const auto sbt_cache_path = data.SbtPath() + ".kc";
+    SbtCacheT::Build(sbt_cache_path, dna, data.SaPath());
+
+    SbtT sbt{data.SbtPath()};
+    SbtCacheT sbt_cache{sbt_cache_path};
+
+    std::mt19937_64 gen{0xDED};
+    std::size_t num_text_reads = 0, num_text_reads_cache = 0;
+    for (unsigned i_query = 0; i_query < 1000; ++i_query) {
+        const std::size_t len = 1 + gen() % 40;
+
+        std::string pattern;
+        if (i_query % 2) {
+            pattern = text.substr(gen() % (text.size() - len), len);
+        } else {
+            for (std::size_t i = 0; i < len; ++i) {
+                pattern += "ACTG"[gen() % 4];
+            }
+        }
+
+        DnaBuffer pattern_buf{pattern};
+        const auto pattern_dna = pattern_buf.GetAccessor();
+
+        auto res = sbt.Search(pattern_dna, dna);
+        auto res_cache = sbt_cache.Search(pattern_dna, dna);
+        ASSERT_EQ(res_cache.sa_pos_left, res.sa_pos_left) << pattern;
+        ASSERT_EQ(res_cache.sa_pos_right, res.sa_pos_right) << pattern;
+        ASSERT_EQ(res_cache.lcp == pattern.size(), res.lcp == pattern.size()) << pattern;
+
+        num_text_reads += res.stats.num_text_reads;
+        num_text_reads_cache += res_cache.stats.num_text_reads;
+    }
+
+    ASSERT_LT(num_text_reads_cache, num_text_reads / 2);
+}
+
+TEST(STRING_BTREE, SUCCINCT_PT) {
+    using SbtSuccinctT = DNA_SBT::StringBTree<DnaSymb, 0, DNA_PT::Format::Succinct>;
+
+    SbtData data{200'000, 0x5CC};
+    const auto& text = data.Text();
+
+    ObjectFileHolder dna_file_holder{data.CompPath()};
+    DnaDataAccessor dna{dna_file_holder};
+
+    const auto sbt_succinct_path = data.SbtPath() + ".succ";
+    SbtSuccinctT::Build(sbt_succinct_path, dna, data.SaPath());
+
+    SbtT sbt{data.SbtPath()};
+    SbtSuccinctT sbt_succinct{sbt_succinct_path};
+
+    // Higher fanout
+    ASSERT_LT(2 * std::filesystem::file_size(sbt_succinct_path),
+              std::filesystem::file_size(data.SbtPath()));
+
+    std::mt19937_64 gen{0xDED};
+    std::size_t num_node_reads = 0, num_node_reads_succinct = 0;
+    for (unsigned i_query = 0; i_query < 1000; ++i_query) {
+        const std::size_t len = 1 + gen() % 40;
+
+        std::string pattern;
+        if (i_query % 2) {
+            pattern = text.substr(gen() % (text.size() - len), len);
+        } else {
+            for (std::size_t i = 0; i < len; ++i) {
+                pattern += "ACTG"[gen() % 4];
+            }
+        }
+
+        DnaBuffer pattern_buf{pattern};
+        const auto pattern_dna = pattern_buf.GetAccessor();
+
+        auto res = sbt.Search(pattern_dna, dna);
+        auto res_succinct = sbt_succinct.Search(pattern_dna, dna);
+        ASSERT_EQ(res_succinct.sa_pos_left, res.sa_pos_left) << pattern;
+        ASSERT_EQ(res_succinct.sa_pos_right, res.sa_pos_right) << pattern;
+        ASSERT_EQ(res_succinct.str_pos, res.str_pos) << pattern;
+        ASSERT_EQ(res_succinct.lcp == pattern.size(), res.lcp == pattern.size()) << pattern;
+        ASSERT_EQ(sbt_succinct.Count(pattern_dna, dna), data.FindAll(pattern).size()) << pattern;
+
+        num_node_reads += res.stats.num_node_reads;
+        num_node_reads_succinct += res_succinct.stats.num_node_reads;
+    }
+
+    ASSERT_LT(num_node_reads_succinct, num_node_reads);
+}
+
+TEST(STRING_BTREE, SUCCINCT_PT_LONG_LCP) {
+    using SbtSuccinctT = DNA_SBT::StringBTree<DnaSymb, 0, DNA_PT::Format::Succinct>;
+
+    // Near-identical copies: lcp of neighbour suffixes is above 255, that is saturated in
+    // directory of chunks
+    std::mt19937_64 gen{0x1CB};
+    std::string genome(1'200, 'A');
+    for (auto& symb : genome) {
+        symb = "ACTG"[gen() % 4];
+    }
+    std::string text;
+    for (int i_copy = 0; i_copy < 100; ++i_copy) {
+        auto copy = genome;
+        copy[gen() % copy.size()] = "ACTG"[gen() % 4];
+        text += copy;
+    }
+
+    SbtData data{text};
+    ObjectFileHolder dna_file_holder{data.CompPath()};
+    DnaDataAccessor dna{dna_file_holder};
+
+    const auto sbt_succinct_path = data.SbtPath() + ".succ";
+    SbtSuccinctT::Build(sbt_succinct_path, dna, data.SaPath());
+
+    SbtT sbt{data.SbtPath()};
+    SbtSuccinctT sbt_succinct{sbt_succinct_path};
+
+    for (unsigned i_query = 0; i_query < 2'000; ++i_query) {
+        const std::size_t len = 256 + gen() % 700;
+        std::string pattern = text.substr(gen() % (text.size() - len), len);
+        if (i_query % 2) {
+            pattern[gen() % len] = "ACTG"[gen() % 4];
+        }
+
+        DnaBuffer pattern_buf{pattern};
+        const auto pattern_dna = pattern_buf.GetAccessor();
+
+        auto res = sbt.Search(pattern_dna, dna);
+        auto res_succinct = sbt_succinct.Search(pattern_dna, dna);
+        ASSERT_EQ(res_succinct.sa_pos_left, res.sa_pos_left) << i_query;
+        ASSERT_EQ(res_succinct.sa_pos_right, res.sa_pos_right) << i_query;
+        ASSERT_EQ(res_succinct.str_pos, res.str_pos) << i_query;
+    }
+}
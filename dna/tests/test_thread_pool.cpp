@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "../../common/thread_pool.h"
+
+TEST(THREAD_POOL, PARALLEL_FOR) {
+    for (unsigned num_threads : {1, 4}) {
+        ThreadPool pool{num_threads};
+        ASSERT_EQ(pool.GetNumThreads(), num_threads);
+
+        // Uneven chunks: every index is visited once, by worker of pool
+        std::vector<std::atomic<int>> visits(10'007);
+        pool.ParallelFor(visits.size(), 13, [&](std::size_t begin, std::size_t end) {
+            ASSERT_LT(ThreadPool::GetWorkerIndex(), num_threads);
+            volatile std::size_t spin = 0;
+            for (std::size_t i = 0; i < (begin % 7) * 1'000; ++i) {
+                spin = spin + i;
+            }
+            for (std::size_t i = begin; i < end; ++i) {
+                ++visits[i];
+            }
+        });
+        for (const auto& num_visits : visits) {
+            ASSERT_EQ(num_visits, 1);
+        }
+
+        // Worker waits for nested chunks by running them, even if it is the only worker
+        std::atomic<std::size_t> num_nested = 0;
+        pool.ParallelFor(8, 1, [&](std::size_t, std::size_t) {
+            pool.ParallelFor(100, 10, [&](std::size_t begin, std::size_t end) {
+                num_nested += end - begin;
+            });
+        });
+        ASSERT_EQ(num_nested, 800);
+
+        ASSERT_THROW(pool.ParallelFor(100, 1,
+                                      [](std::size_t begin, std::size_t) {
+                                          if (begin == 42) {
+                                              throw std::runtime_error{"chunk"};
+                                          }
+                                      }),
+                     std::runtime_error);
+    }
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../wavelet_tree_on_disk.hpp"
+
+namespace {
+
+class TestText : public std::vector<unsigned> {
+public:
+    std::size_t Size() const noexcept {
+        return size();
+    }
+};
+
+}  // namespace
+
+TEST(WAVELET_TREE_ON_DISK, BUILD) {
+    using size_t = WaveletTree::size_t;
+
+    const size_t alph_size = 64;
+
+    // More than one chunk of build
+    std::mt19937_64 gen{0xEDA};
+    TestText text;
+    text.resize(2'500'000);
+    for (auto& symb : text) {
+        symb = gen() % 4 ? gen() % 8 : gen() % alph_size;
+    }
+
+    const auto wt_path = std::filesystem::temp_directory_path() /
+                         ("wt_test_" + std::to_string(getpid()) + ".wt");
+    WaveletTreeOnDisk::Build(wt_path, text, alph_size);
+
+    {
+        WaveletTreeOnDisk wt_file{wt_path};
+        const auto& wt = wt_file.Get();
+
+        std::vector<size_t> symb_ctr(alph_size);
+        for (size_t i = 0; i < text.size(); ++i) {
+            if (i % 1000 == 0) {
+                const size_t symb = gen() % alph_size;
+                ASSERT_EQ(wt.GetRank(symb, i), symb_ctr[symb]) << i;
+            }
+            if (i % 997 == 0) {
+                ASSERT_EQ(wt.Select(text[i], symb_ctr[text[i]]), i);
+            }
+            ++symb_ctr[text[i]];
+        }
+
+        // Statistics of whole text
+        std::size_t num_symbs = 0;
+        for (auto [symb, freq] : wt_file.RangeDistinct(0, text.size())) {
+            ASSERT_EQ(freq, symb_ctr[symb]);
+            num_symbs += freq;
+        }
+        ASSERT_EQ(num_symbs, text.size());
+
+        const auto top = wt_file.RangeTopK(0, text.size(), 1);
+        ASSERT_EQ(top.size(), 1);
+        ASSERT_EQ(top[0].second, *std::max_element(symb_ctr.begin(), symb_ctr.end()));
+        ASSERT_EQ(wt_file.RangeQuantile(0, text.size(), 0),
+                  *std::min_element(text.begin(), text.end()));
+    }
+
+    std::filesystem::remove(wt_path);
+}
@@ -8,9 +8,13 @@
 #include <cassert>
 #include <string.h>
 
-enum class DnaSymb : uint8_t { TERM = 0, A, C, T, G };
+// SEP - end of document in generalized text, TERM - end of all text
+enum class DnaSymb : uint8_t { TERM = 0, A, C, T, G, SEP };
 constexpr u8 DnaSymbBitSize = 3;
 
+// Greater then any symbol, pads tail of unaligned pattern for upper bound of SA interval
+constexpr DnaSymb DnaSymbMaxPad = DnaSymb{(1u << DnaSymbBitSize) - 1};
+
 void InsertDnaSymb(uint8_t* begin, uint64_t dna_pos, DnaSymb dna_symb);
 DnaSymb ReadDnaSymb(const uint8_t* begin, uint64_t dna_pos);
 
@@ -71,3 +75,5 @@ using str_len_t = uint32_t;
 using in_blk_pos_t = uint16_t;
 using blk_pos_t = uint32_t;
 using str_pos_t = str_len_t;
+
+using doc_id_t = uint32_t;
@@ -1,36 +1,65 @@
 #pragma once
 
 #include "../wavelet_tree/wavelet_tree.hpp"
+#include "../wavelet_tree/wavelet_matrix.hpp"
+#include "../wavelet_tree/compact_wavelet.hpp"
+#include "../wavelet_tree/shaped_wavelet_tree.hpp"
 #include "../common/file_manip.h"
 
 #include <string>
+#include <vector>
 
-class WaveletTreeOnDisk {
+// WaveletTreeT - WaveletTree, WaveletMatrix, CompactWaveletMatrix, CompactWaveletTree or
+// ShapedWaveletTree
+template <typename WaveletTreeT>
+class BasicWaveletTreeOnDisk {
 public:
-    WaveletTreeOnDisk(std::string wt_path)
+    using size_t = typename WaveletTreeT::size_t;
+
+    BasicWaveletTreeOnDisk(std::string wt_path)
         : m_wt{wt_path} {}
 
-    const WaveletTree& Get() const noexcept {
-        return *(const WaveletTree*)m_wt.begin();
+    const WaveletTreeT& Get() const noexcept {
+        return *(const WaveletTreeT*)m_wt.begin();
+    }
+
+    // Statistics of BWT symbols on SA interval [l_pos, r_pos), only for WaveletTree
+    std::vector<std::pair<size_t, size_t>> RangeDistinct(size_t l_pos, size_t r_pos) const {
+        return Get().RangeDistinct(l_pos, r_pos);
+    }
+    size_t RangeQuantile(size_t l_pos, size_t r_pos, size_t k) const {
+        return Get().RangeQuantile(l_pos, r_pos, k);
+    }
+    std::vector<std::pair<size_t, size_t>> RangeTopK(size_t l_pos, size_t r_pos, size_t k) const {
+        return Get().RangeTopK(l_pos, r_pos, k);
     }
 
     template <typename NumberAccessorT>
-    static WaveletTreeOnDisk Build(std::string wt_path, const NumberAccessorT& text,
-                                   WaveletTree::size_t alph_size);
+    static BasicWaveletTreeOnDisk Build(std::string wt_path, const NumberAccessorT& text,
+                                        size_t alph_size);
 
 private:
     FileMapperRead m_wt;
 };
 
+using WaveletTreeOnDisk = BasicWaveletTreeOnDisk<WaveletTree>;
+using HybridWaveletTreeOnDisk = BasicWaveletTreeOnDisk<HybridWaveletTree>;
+using WaveletMatrixOnDisk = BasicWaveletTreeOnDisk<WaveletMatrix>;
+using CompactWaveletMatrixOnDisk = BasicWaveletTreeOnDisk<CompactWaveletMatrix>;
+using CompactWaveletTreeOnDisk = BasicWaveletTreeOnDisk<CompactWaveletTree>;
+using ShapedWaveletTreeOnDisk = BasicWaveletTreeOnDisk<ShapedWaveletTree>;
+
+template <typename WaveletTreeT>
 template <typename NumberAccessorT>
-WaveletTreeOnDisk WaveletTreeOnDisk::Build(std::string wt_path, const NumberAccessorT& text,
-                                           WaveletTree::size_t alph_size) {
+BasicWaveletTreeOnDisk<WaveletTreeT> BasicWaveletTreeOnDisk<WaveletTreeT>::Build(
+    std::string wt_path, const NumberAccessorT& text, size_t alph_size) {
     {
-        auto build_info = WaveletTree::PrepareBuild(text, alph_size);
-        
-        // FileMapperWrite file{wt_path, build_info.CalcOccupiedSize()};
-        // new (file.begin()) WaveletTree{text, alph_size, build_info};
+        auto build_info = WaveletTreeT::PrepareBuild(text, alph_size);
+
+        // Structure is built directly in mapped file
+        FileMapperWrite file{wt_path, build_info.CalcOccupiedSize()};
+        new (file.begin()) WaveletTreeT{text, alph_size, build_info};
     }
 
     return {wt_path};
-}
\ No newline at end of file
+}
@@ -0,0 +1,535 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "common/latency_histogram.h"
+#include "common/thread_pool.h"
+#include "dna/blocked_index.hpp"
+#include "dna/query_executor.hpp"
+
+/*
+    dna_index build <text_path> [--d <d>,...] [--threads <n>]
+        Compressed text of FASTA text_path and index of every d next to it
+    dna_index query <text_path> [--d <d>] [--threads <n>] [--batch <n>] [--input <path>]...
+        Patterns (one per line) of inputs, stdin if there is no input or input is "-".
+        Output is TSV: pattern, found (0 or 1), d of index, status. Status is ok, invalid_symbol
+        (not ACGT, e.g. N) or too_short (not longer then smallest d), such pattern is not found
+    dna_index bench <text_path> [--d <d>,...] [--pattern-len <len>,...] [--num-queries <n>]
+                    [--threads <n>,...] [--cache warm|cold]
+        Latency percentiles and throughput of substrings of text, output is JSON line per d,
+        length and number of threads. Cache warm (default): untimed run precedes measured one.
+        Cache cold: files of index are evicted from page cache before every measured run
+    dna_index calibrate <text_path> [--d <d>,...] [--pattern-len <len>,...] [--num-queries <n>]
+        Cost model of text by latency of indexes of d (every built d by default)
+
+    d of query and bench is chosen by cost model of text, if it is not given. Queries are run
+    on work-stealing thread pool over one shared searcher of d
+*/
+
+namespace {
+
+void PrintUsage() {
+    std::cerr << "Usage:\n"
+                 "  dna_index build <text_path> [--d <d>,...] [--threads <n>]\n"
+                 "  dna_index query <text_path> [--d <d>] [--threads <n>] [--batch <n>]"
+                 " [--input <path>]...\n"
+                 "  dna_index bench <text_path> [--d <d>,...] [--pattern-len <len>,...]"
+                 " [--num-queries <n>] [--threads <n>,...] [--cache warm|cold]\n"
+                 "  dna_index calibrate <text_path> [--d <d>,...] [--pattern-len <len>,...]"
+                 " [--num-queries <n>]\n";
+}
+
+struct Options {
+    std::string command;
+    std::string text_path;
+    std::vector<u8> ds;  // Empty - by cost model
+    std::vector<unsigned> thread_counts = {1};
+    std::size_t batch_size = 1 << 16;
+    std::vector<std::string> inputs;
+    std::vector<str_len_t> pattern_lens;  // Empty - default of command
+    unsigned num_queries = 10'000;
+    CacheMode cache_mode = CacheMode::Warm;
+};
+
+template <typename T>
+std::vector<T> ParseList(const std::string& str) {
+    std::vector<T> values;
+    std::size_t begin = 0;
+    while (begin <= str.size()) {
+        const auto end = std::min(str.find(',', begin), str.size());
+        const auto value = std::stoul(str.substr(begin, end - begin));
+        if (value > std::numeric_limits<T>::max()) {
+            throw std::invalid_argument{"Too large value: " + std::to_string(value)};
+        }
+        values.push_back(value);
+        begin = end + 1;
+    }
+    return values;
+}
+
+Options ParseOptions(int argc, char* argv[]) {
+    if (argc < 3 || argc % 2 == 0) {
+        throw std::invalid_argument{"Incorrect number of arguments"};
+    }
+
+    Options options;
+    options.command = argv[1];
+    options.text_path = argv[2];
+
+    for (int i = 3; i < argc; i += 2) {
+        const std::string_view option{argv[i]};
+        const std::string value{argv[i + 1]};
+
+        if (option == "--d") {
+            options.ds = ParseList<u8>(value);
+        } else if (option == "--threads") {
+            options.thread_counts = ParseList<unsigned>(value);
+        } else if (option == "--batch") {
+            options.batch_size = std::max(1ul, std::stoul(value));
+        } else if (option == "--input") {
+            options.inputs.push_back(value);
+        } else if (option == "--pattern-len") {
+            options.pattern_lens = ParseList<str_len_t>(value);
+        } else if (option == "--num-queries") {
+            options.num_queries = std::stoul(value);
+        } else if (option == "--cache") {
+            if (value != "warm" && value != "cold") {
+                throw std::invalid_argument{"Cache mode must be warm or cold: " + value};
+            }
+            options.cache_mode = value == "warm" ? CacheMode::Warm : CacheMode::Cold;
+        } else {
+            throw std::invalid_argument{"Unknown option: " + std::string{option}};
+        }
+    }
+
+    if (options.command != "bench" && options.thread_counts.size() > 1) {
+        throw std::invalid_argument{"Only bench takes several numbers of threads"};
+    }
+    for (unsigned num_threads : options.thread_counts) {
+        if (num_threads == 0) {
+            throw std::invalid_argument{"Number of threads must be greater 0"};
+        }
+    }
+    for (u8 d : options.ds) {
+        if (d < 1 || d > c_max_block_size) {
+            throw std::invalid_argument{"d must be in [1, " + std::to_string(c_max_block_size) +
+                                        "]: " + std::to_string(d)};
+        }
+    }
+
+    return options;
+}
+
+enum class PatternStatus { Ok, InvalidSymbol, TooShort };
+
+const char* ToString(PatternStatus status) noexcept {
+    switch (status) {
+        case PatternStatus::Ok:
+            return "ok";
+        case PatternStatus::InvalidSymbol:
+            return "invalid_symbol";
+        case PatternStatus::TooShort:
+            return "too_short";
+    }
+    return "";
+}
+
+// Pattern is searched only by indexes, that are applicable to it
+PatternStatus GetPatternStatus(const std::string& pattern, u8 min_d) noexcept {
+    for (char symb : pattern) {
+        if (symb == '\0' || !ConvertTextDnaSymb2DnaSymb(symb).second) {
+            return PatternStatus::InvalidSymbol;
+        }
+    }
+    return BlockingCostModel::IsApplicable(min_d, pattern.size()) ? PatternStatus::Ok
+                                                                  : PatternStatus::TooShort;
+}
+
+// Executor of d is opened on first batch of d and serves all following batches
+template <u8... ds>
+class QueryExecutors {
+public:
+    QueryExecutors(std::string text_path, ThreadPool& pool)
+        : m_text_path{std::move(text_path)}
+        , m_pool{pool} {}
+
+    template <u8 d>
+    const QueryExecutor<d>& Get() {
+        auto& executor = std::get<std::optional<QueryExecutor<d>>>(m_executors);
+        if (!executor) {
+            executor.emplace(NameGenerator{m_text_path, d}, m_pool);
+        }
+        return *executor;
+    }
+
+private:
+    std::string m_text_path;
+    ThreadPool& m_pool;
+    std::tuple<std::optional<QueryExecutor<ds>>...> m_executors;
+};
+
+void Build(const Options& options) {
+    std::vector<u8> ds = options.ds.empty() ? std::vector<u8>{1} : options.ds;
+
+    // Compressed text is common for all d, so it is padded for every d
+    const uint d_max = std::accumulate(ds.begin(), ds.end(), 1u,
+                                       [](uint lhs, u8 rhs) { return std::lcm(lhs, rhs); });
+    const NameGenerator name_gen{options.text_path, 1};
+    const auto& dna_compr_path = name_gen.GetCompressedTextPath();
+    std::cout << "Build compressed dna text -> " << dna_compr_path << std::endl;
+    BuildCompressedDnaFromTextDna(options.text_path, dna_compr_path, d_max);
+
+    ThreadPool pool{options.thread_counts[0]};
+    pool.ParallelFor(ds.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            DispatchBlockSize(ds[i], [&]<u8 block_size> {
+                BuildBlockedIndex<block_size>(options.text_path);
+            });
+        }
+    });
+
+    for (u8 d : ds) {
+        NameGenerator name_gen{options.text_path, d};
+        std::cout << "d = " << (uint)d << ": " << name_gen.GetStringBTreePath()
+                  << (d > 1 ? ", " + name_gen.GetWaveletTreePath() : "") << std::endl;
+    }
+}
+
+// Lines of input, that are not empty, in upper case
+class PatternReader {
+public:
+    PatternReader(const std::vector<std::string>& inputs)
+        : m_inputs{inputs.empty() ? std::vector<std::string>{"-"} : inputs} {
+        Open();
+    }
+
+    // Up to batch_size patterns, empty at the end of inputs
+    std::vector<std::string> ReadBatch(std::size_t batch_size) {
+        std::vector<std::string> patterns;
+        std::string line;
+        while (patterns.size() < batch_size && m_stream) {
+            if (!std::getline(*m_stream, line)) {
+                if (++m_i_input == m_inputs.size()) {
+                    m_stream = nullptr;
+                } else {
+                    Open();
+                }
+                continue;
+            }
+
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.empty()) {
+                continue;
+            }
+
+            std::transform(line.begin(), line.end(), line.begin(),
+                           [](unsigned char symb) { return std::toupper(symb); });
+            patterns.push_back(std::move(line));
+        }
+
+        return patterns;
+    }
+
+private:
+    void Open() {
+        const auto& input = m_inputs[m_i_input];
+        if (input == "-") {
+            m_stream = &std::cin;
+            return;
+        }
+
+        m_file.close();
+        m_file.clear();
+        m_file.open(input);
+        if (!m_file) {
+            throw std::runtime_error{"Failed to open input: " + input};
+        }
+        m_stream = &m_file;
+    }
+
+    std::vector<std::string> m_inputs;
+    std::size_t m_i_input = 0;
+    std::ifstream m_file;
+    std::istream* m_stream = nullptr;
+};
+
+void Query(const Options& options) {
+    if (options.ds.size() > 1) {
+        throw std::invalid_argument{"Query takes one d"};
+    }
+
+    // Only d of executors is opened, chooser reads cost model and names of index files
+    std::optional<BlockSizeChooser> chooser;
+    if (options.ds.empty()) {
+        chooser.emplace(options.text_path, std::vector<u8>{1, 2, 3, 4, 5, 6, 7, 8});
+    }
+
+    // Patterns, that are not longer then smallest d, are too short for every index
+    const u8 min_d = chooser ? *std::min_element(chooser->GetBlockSizes().begin(),
+                                                 chooser->GetBlockSizes().end())
+                             : options.ds[0];
+
+    ThreadPool pool{options.thread_counts[0]};
+    QueryExecutors<1, 2, 3, 4, 5, 6, 7, 8> executors{options.text_path, pool};
+    PatternReader reader{options.inputs};
+    std::cout << "pattern\tfound\td\tstatus\n";
+    for (auto patterns = reader.ReadBatch(options.batch_size); !patterns.empty();
+         patterns = reader.ReadBatch(options.batch_size)) {
+        std::vector<PatternStatus> statuses;
+        statuses.reserve(patterns.size());
+        for (const auto& pattern : patterns) {
+            statuses.push_back(GetPatternStatus(pattern, min_d));
+        }
+
+        // Batch is copied only if it has bad patterns
+        const std::vector<std::string>* search_patterns = &patterns;
+        std::vector<std::string> ok_patterns;
+        if (!std::all_of(statuses.begin(), statuses.end(),
+                         [](auto status) { return status == PatternStatus::Ok; })) {
+            for (std::size_t i = 0; i < patterns.size(); ++i) {
+                if (statuses[i] == PatternStatus::Ok) {
+                    ok_patterns.push_back(patterns[i]);
+                }
+            }
+            search_patterns = &ok_patterns;
+        }
+
+        u8 d = min_d;
+        std::vector<u8> is_found;
+        if (!search_patterns->empty()) {
+            d = chooser ? chooser->Choose(*search_patterns) : min_d;
+            DispatchBlockSize(d, [&]<u8 block_size> {
+                is_found = executors.template Get<block_size>().Contains(*search_patterns);
+            });
+        }
+
+        for (std::size_t i = 0, i_found = 0; i < patterns.size(); ++i) {
+            const bool is_ok = statuses[i] == PatternStatus::Ok;
+            std::cout << patterns[i] << '\t' << (is_ok ? (uint)is_found[i_found++] : 0) << '\t'
+                      << (uint)d << '\t' << ToString(statuses[i]) << '\n';
+        }
+    }
+    std::cout.flush();
+}
+
+// Substrings of text at random positions
+std::vector<std::string> GenPatternStrs(const DnaDataAccessor& dna, str_len_t pattern_len,
+                                        unsigned num_queries) {
+    if (dna.Size() <= pattern_len + 1) {
+        throw std::invalid_argument{"Pattern is longer then text"};
+    }
+
+    std::mt19937_64 gen{0xEDA};
+    std::vector<std::string> patterns(num_queries);
+    for (auto& pattern : patterns) {
+        const str_pos_t pos = gen() % (dna.Size() - pattern_len - 1);
+        for (str_pos_t i = pos; i < pos + pattern_len; ++i) {
+            pattern += DNASymb2String(dna[i]);
+        }
+    }
+    return patterns;
+}
+
+struct BenchResult {
+    std::size_t num_found = 0;
+    LatencyHistogram latencies;  // Nanoseconds
+    double throughput = 0;       // Queries per second
+};
+
+// Patterns are prepared before measure, latency of query is measured in worker, that runs it.
+// Workers share one searcher. For cold cache files of index must not be mapped by caller
+template <u8 block_size>
+BenchResult BenchBlockSize(const std::string& text_path, const std::vector<std::string>& patterns,
+                           ThreadPool& pool, CacheMode cache_mode) {
+    using ExecutorT = QueryExecutor<block_size>;
+    using ClockT = std::chrono::steady_clock;
+
+    std::vector<typename ExecutorT::Query> queries;
+    queries.reserve(patterns.size());
+    for (const auto& pattern : patterns) {
+        queries.push_back(ExecutorT::SearcherT::Prepare(pattern));
+    }
+
+    if (cache_mode == CacheMode::Cold) {
+        EvictBlockedIndexCache(text_path, block_size);
+    }
+    const ExecutorT executor{NameGenerator{text_path, block_size}, pool};
+    if (cache_mode == CacheMode::Warm) {
+        executor.Contains(queries);
+    }
+
+    const auto& searcher = executor.GetSearcher();
+    std::vector<LatencyHistogram> worker_latencies(pool.GetNumThreads());
+    std::atomic<std::size_t> num_found = 0;
+
+    const auto time_start = ClockT::now();
+    pool.ParallelFor(queries.size(), ExecutorT::c_default_grain_size,
+                     [&](std::size_t begin, std::size_t end) {
+                         auto& latencies = worker_latencies[ThreadPool::GetWorkerIndex()];
+                         std::size_t num_found_chunk = 0;
+                         for (std::size_t i = begin; i < end; ++i) {
+                             const auto query_start = ClockT::now();
+                             num_found_chunk += searcher.Contains(queries[i]);
+                             latencies.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                  ClockT::now() - query_start)
+                                                  .count());
+                         }
+                         num_found += num_found_chunk;
+                     });
+    const std::chrono::duration<double> duration = ClockT::now() - time_start;
+
+    BenchResult res;
+    res.num_found = num_found;
+    for (const auto& latencies : worker_latencies) {
+        res.latencies.Merge(latencies);
+    }
+    res.throughput = queries.size() / duration.count();
+    return res;
+}
+
+void Bench(const Options& options) {
+    const auto pattern_lens =
+        options.pattern_lens.empty() ? std::vector<str_len_t>{32} : options.pattern_lens;
+
+    // Patterns and d of every length are chosen before runs, so that no file is mapped in runs
+    std::vector<std::vector<std::string>> patterns_by_len;
+    std::vector<std::vector<u8>> ds_by_len;
+    {
+        ObjectFileHolder dna_file_holder{
+            NameGenerator{options.text_path, 1}.GetCompressedTextPath()};
+        const DnaDataAccessor dna{dna_file_holder};
+
+        std::optional<BlockSizeChooser> chooser;
+        if (options.ds.empty()) {
+            chooser.emplace(options.text_path, std::vector<u8>{1, 2, 3, 4, 5, 6, 7, 8});
+        }
+
+        for (str_len_t pattern_len : pattern_lens) {
+            auto patterns = GenPatternStrs(dna, pattern_len, options.num_queries);
+            ds_by_len.push_back(chooser ? std::vector<u8>{chooser->Choose(patterns)}
+                                        : options.ds);
+            patterns_by_len.push_back(std::move(patterns));
+        }
+    }
+
+    // Throughput by number of threads, pool is created per number
+    const char* cache_mode_name = options.cache_mode == CacheMode::Warm ? "warm" : "cold";
+    for (unsigned num_threads : options.thread_counts) {
+        ThreadPool pool{num_threads};
+        for (std::size_t i_len = 0; i_len < pattern_lens.size(); ++i_len) {
+            const auto& patterns = patterns_by_len[i_len];
+            for (u8 d : ds_by_len[i_len]) {
+                BenchResult res;
+                DispatchBlockSize(d, [&]<u8 block_size> {
+                    res = BenchBlockSize<block_size>(options.text_path, patterns, pool,
+                                                     options.cache_mode);
+                });
+
+                const auto& latencies = res.latencies;
+                auto micros = [](double nanos) { return nanos / 1'000; };
+                std::cout << "{\"d\": " << (uint)d << ", \"pattern_len\": " << pattern_lens[i_len]
+                          << ", \"num_queries\": " << patterns.size()
+                          << ", \"num_threads\": " << num_threads
+                          << ", \"cache\": \"" << cache_mode_name << "\""
+                          << ", \"num_found\": " << res.num_found
+                          << ", \"mean_latency_us\": " << micros(latencies.GetMean())
+                          << ", \"p50_us\": " << micros(latencies.GetPercentile(50))
+                          << ", \"p90_us\": " << micros(latencies.GetPercentile(90))
+                          << ", \"p99_us\": " << micros(latencies.GetPercentile(99))
+                          << ", \"p999_us\": " << micros(latencies.GetPercentile(99.9))
+                          << ", \"max_us\": " << micros(latencies.GetMax())
+                          << ", \"throughput_qps\": " << res.throughput << "}" << std::endl;
+            }
+        }
+    }
+}
+
+// Single thread latency of every d and length is sample of cost model, that is stored next to
+// indexes
+void Calibrate(const Options& options) {
+    ObjectFileHolder dna_file_holder{
+        NameGenerator{options.text_path, 1}.GetCompressedTextPath()};
+    const DnaDataAccessor dna{dna_file_holder};
+
+    std::vector<u8> ds = options.ds;
+    if (ds.empty()) {
+        for (u8 d = 1; d <= c_max_block_size; ++d) {
+            const NameGenerator name_gen{options.text_path, d};
+            if (std::filesystem::exists(name_gen.GetStringBTreePath()) &&
+                (d == 1 || std::filesystem::exists(name_gen.GetWaveletTreePath()))) {
+                ds.push_back(d);
+            }
+        }
+    }
+    const auto pattern_lens = options.pattern_lens.empty()
+                                  ? std::vector<str_len_t>{16, 32, 64, 128}
+                                  : options.pattern_lens;
+
+    ThreadPool pool{1};
+    std::vector<BlockingCostModel::Sample> samples;
+    for (str_len_t pattern_len : pattern_lens) {
+        const auto patterns = GenPatternStrs(dna, pattern_len, options.num_queries);
+        for (u8 d : ds) {
+            if (!BlockingCostModel::IsApplicable(d, pattern_len)) {
+                continue;
+            }
+
+            BenchResult res;
+            DispatchBlockSize(d, [&]<u8 block_size> {
+                res = BenchBlockSize<block_size>(options.text_path, patterns, pool,
+                                                 CacheMode::Warm);
+            });
+            const double mean_latency = res.latencies.GetMean() / 1'000;
+            samples.push_back({d, pattern_len, mean_latency});
+            std::cout << "d: " << (uint)d << ", pattern_len: " << pattern_len
+                      << ", mean: " << mean_latency << ", found: " << res.num_found << std::endl;
+        }
+    }
+
+    const auto cost_model_path = NameGenerator{options.text_path, 1}.GetCostModelPath();
+    BlockingCostModel::Fit(samples).Save(cost_model_path);
+    std::cout << "Cost model -> " << cost_model_path << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) try {
+    Options options;
+    try {
+        options = ParseOptions(argc, argv);
+    } catch (std::exception& exc) {
+        std::cerr << "Exception: " << exc.what() << std::endl;
+        PrintUsage();
+        return 1;
+    }
+
+    if (options.command == "build") {
+        Build(options);
+    } else if (options.command == "query") {
+        Query(options);
+    } else if (options.command == "bench") {
+        Bench(options);
+    } else if (options.command == "calibrate") {
+        Calibrate(options);
+    } else {
+        PrintUsage();
+        return 1;
+    }
+} catch (std::exception& exc) {
+    std::cerr << "Exception: " << exc.what() << std::endl;
+    return 1;
+}
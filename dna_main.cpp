@@ -1,10 +1,18 @@
 #include <cstdio>
+#include <filesystem>
 #include <iostream>
 #include <future>
+#include <optional>
 #include <random>
 
+#include "common/latency_histogram.h"
+#include "dna/blocked_index.hpp"
+#include "dna/blocking_cost_model.h"
 #include "dna/dna.h"
+#include "dna/document_index.h"
+#include "dna/fm_index.hpp"
 #include "dna/patricia_trie.h"
+#include "dna/r_index.hpp"
 #include "dna/string_btree.h"
 #include "dna/wavelet_tree_on_disk.hpp"
 
@@ -14,48 +22,6 @@
     2) SBT или {SBT, WT}
 */
 
-void CheckBlockSize(u8 block_size) {
-    if (block_size == 0) {
-        throw std::invalid_argument{"Block size \"d\" must be greater 0"};
-    }
-}
-
-class NameGenerator {
-public:
-    NameGenerator(std::string text_path, u8 block_size /* d */)
-        : m_compressed_text{text_path + ".comp"}
-        , m_suffix_array{m_compressed_text + ".sa"}
-        , m_string_btree{m_compressed_text + ".sbt"}
-        , m_wavelet_tree{m_compressed_text + ".wt"} {
-        CheckBlockSize(block_size);
-        if (block_size > 1) {
-            auto block_size_ext = ".d" + std::to_string(block_size);
-            m_suffix_array += block_size_ext;
-            m_string_btree += block_size_ext;
-            m_wavelet_tree += block_size_ext;
-        }
-    }
-
-    const std::string& GetCompressedTextPath() const noexcept {
-        return m_compressed_text;
-    }
-    const std::string& GetSuffixArrayPath() const noexcept {
-        return m_suffix_array;
-    }
-    const std::string& GetStringBTreePath() const noexcept {
-        return m_string_btree;
-    }
-    const std::string& GetWaveletTreePath() const {
-        return m_wavelet_tree;
-    }
-
-private:
-    std::string m_compressed_text;
-    std::string m_suffix_array;
-    std::string m_string_btree;
-    std::string m_wavelet_tree;
-};
-
 template <u8 block_size>
 void BuildAllStructures(std::string dna_path) {
     CheckBlockSize(block_size);
@@ -102,11 +68,43 @@ void BuildAllStructures(std::string dna_path) {
 
         const auto& wt_path = name_gen.GetWaveletTreePath();
         // std::cout << "Build wavelet tree -> " << wt_path << std::endl;
-        WaveletTreeOnDisk::Build(wt_path, rev_num_dna, rev_num_alph_size);
+        CompactWaveletTreeOnDisk::Build(wt_path, rev_num_dna, rev_num_alph_size);
     }
     std::cout << std::endl;
 }
 
+// Every FASTA record of dna_path is document
+template <u8 block_size>
+void BuildGeneralizedStructures(std::string dna_path) {
+    CheckBlockSize(block_size);
+
+    NameGenerator name_gen{dna_path, block_size};
+
+    const auto& dna_compr_path = name_gen.GetCompressedTextPath();
+    const auto& docs_path = name_gen.GetDocumentsPath();
+    std::cout << "Build compressed dna text -> " << dna_compr_path << std::endl;
+    BuildCompressedDocsDnaFromTextDna(dna_path, dna_compr_path, docs_path, block_size);
+
+    const auto& suff_arr_path = name_gen.GetSuffixArrayPath();
+    std::cout << "Build suffix array -> " << suff_arr_path << std::endl;
+    BuildSuffArrayFromComprDna(dna_compr_path, suff_arr_path, block_size);
+
+    ObjectFileHolder dna_file_holder{dna_compr_path};
+    const auto& sbt_path = name_gen.GetStringBTreePath();
+    std::cout << "Build string b-tree -> " << sbt_path << std::endl;
+    if constexpr (block_size == 1) {
+        DNA_SBT::StringBTree<DnaSymb>::Build(sbt_path, DnaDataAccessor{dna_file_holder},
+                                             suff_arr_path);
+    } else {
+        DNA_SBT::StringBTree<DnaSymbSeq<block_size>>::Build(
+            sbt_path, DnaSeqDataAccessor<block_size>{dna_file_holder}, suff_arr_path);
+    }
+
+    const auto& doc_index_path = name_gen.GetDocumentIndexPath();
+    std::cout << "Build document index -> " << doc_index_path << std::endl;
+    DocumentIndex::Build(doc_index_path, suff_arr_path, docs_path, block_size);
+}
+
 int main_blocking_1() {
     std::string btree_name = "dna_btree.bin";
     const std::string data_dir = "../../data/T_SA/";
@@ -151,8 +149,8 @@ int main_blocking_1() {
         DnaBuffer dna_buf{str};
         DnaDataAccessor pattern = dna_buf.GetAccessor();
 
-        auto [pos, sa_pos, sa_pos_right, is_finded] = sbt.Search(pattern, dna_data);
-        if (is_finded) {
+        auto [pos, sa_pos, sa_pos_right, lcp, search_stats] = sbt.Search(pattern, dna_data);
+        if (lcp == pattern.Size()) {
             str_len_t answer_len = dna_data.Size() - pos;
             str_len_t len = std::min(answer_len, max_print_len);
 
@@ -174,6 +172,19 @@ int main_blocking_1() {
                           << (pos == str_pos_from_sa) << std::endl;
                 throw std::runtime_error{"Incorrect SA index!"};
             }
+
+            const std::size_t max_print_occs = 10;
+            const auto occs = sbt.Locate(pattern, dna_data, suff_arr, true);
+            std::cout << "count: " << occs.Size() << ", poss:";
+            std::size_t num_printed = 0;
+            for (str_pos_t occ_pos : occs) {
+                if (num_printed++ == max_print_occs) {
+                    std::cout << " ...";
+                    break;
+                }
+                std::cout << ' ' << occ_pos;
+            }
+            std::cout << std::endl;
         } else {
             std::cout << "not found" << std::endl;
         }
@@ -182,50 +193,6 @@ int main_blocking_1() {
     return 0;
 }
 
-template <u8 d>
-std::tuple<DnaSymbSeq<d>, DnaBuffer, std::size_t> GetLeftRightPattern(const std::string& str,
-                                                                      std::size_t k) {
-    assert(k < d);
-    assert(str.size() > d);
-
-    DnaSymbSeq<d> left_patt;
-    for (u8 i = 0; i < d; ++i) {
-        DnaSymb symb = DnaSymb::A;
-        if (i < k) {
-            auto [getted_symb, is_good] = ConvertTextDnaSymb2DnaSymb(str[k - 1 - i]);
-            if (!is_good) {
-                throw std::invalid_argument{"Incorect pattern"};
-            }
-            symb = getted_symb;
-        }
-        left_patt.Set(symb, i);
-    }
-
-    auto right_patt_str = str.substr(k);
-
-    std::size_t num_term_symb = 0;
-
-    const bool is_pattern_div_d = right_patt_str.size() % d == 0;
-    if (!is_pattern_div_d) {
-        str_len_t add_size = d - right_patt_str.size() % d;
-        right_patt_str.resize(right_patt_str.size() + add_size);
-
-        for (str_pos_t i = right_patt_str.size() - add_size; i < right_patt_str.size(); ++i) {
-            right_patt_str[i] = '\0';
-        }
-
-        num_term_symb = add_size;
-    }
-
-    DnaBuffer right_patt_buf_d1{right_patt_str};
-    if (right_patt_buf_d1.GetAccessor().Size() % d) {
-        std::cout << right_patt_buf_d1.GetAccessor().Size() << std::endl;
-        throw std::runtime_error{"Too strange"};
-    }
-
-    return {left_patt, right_patt_buf_d1, num_term_symb};
-}
-
 template <u8 d>
 int main_blocking_d() {
     std::string btree_name = "dna_btree.bin";
@@ -297,12 +264,16 @@ int main_blocking_d() {
 
         bool is_finded = false;
         for (std::size_t k = 1; k < d; ++k) {
-            auto [left_pattern, right_patt_buf_d1, num_term_symb] = GetLeftRightPattern<d>(str, k);
+            auto [left_pattern, right_patt_buf_d1, right_patt_upper_buf_d1, num_term_symb] =
+                GetLeftRightPattern<d>(str, k);
 
             auto right_dna_d1 = right_patt_buf_d1.GetAccessor();
             DnaSeqDataAccessor<d> right_pattern{right_dna_d1.data(), right_dna_d1.Size() / d};
+            DnaSeqDataAccessor<d> right_pattern_upper{
+                right_patt_upper_buf_d1.GetAccessor().data(), right_dna_d1.Size() / d};
 
-            auto [pos, sa_pos, sa_pos_right, lcp] = sbt.Search(right_pattern, dna_data);
+            auto [pos, sa_pos, sa_pos_right, lcp, search_stats] =
+                sbt.Search(right_pattern, right_pattern_upper, dna_data);
 
             if (num_term_symb == 0) {
                 is_finded = lcp == right_pattern.Size();
@@ -444,20 +415,9 @@ auto to_microsec(auto time_start, auto time_finish) {
     return std::chrono::duration_cast<std::chrono::microseconds>(delta).count();
 }
 
-// Mean, disp
-template <typename T>
-std::pair<T, T> CalcMeanDisp(const std::vector<T>& buf) {
-    const auto size = buf.size();
-    T mean = std::accumulate(std::begin(buf), std::end(buf), T{}) / size;
-
-    T disp = {};
-    for (std::size_t i = 0; i < size; ++i) {
-        auto delta = buf[i] > mean ? buf[i] - mean : mean - buf[i];
-        disp += delta * delta;
-    }
-    disp = std::sqrt(disp / size);
-
-    return {mean, disp};
+auto to_nanosec(auto time_start, auto time_finish) {
+    auto delta = time_finish - time_start;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count();
 }
 
 std::string DnaSeq2String(const DnaDataAccessor& dna, str_pos_t begin, str_pos_t end) {
@@ -472,150 +432,347 @@ std::string DnaSeq2String(const DnaDataAccessor& dna, str_pos_t begin, str_pos_t
     return res;
 }
 
+// Latency percentiles of index of d. Cold cache: files of index are evicted from page cache
+// before measure, so text is unmapped after patterns are generated
 template <u8 block_size>
-void start(unsigned num_queries, std::string data_size_suffix, str_len_t pattern_len) {
+void start(unsigned num_queries, std::string data_size_suffix, str_len_t pattern_len,
+           CacheMode cache_mode = CacheMode::Warm) {
+    using SearcherT = BlockedSearcher<block_size>;
+
     auto uncompr_data_path = GetDataPath(data_size_suffix);
     NameGenerator name_gen{uncompr_data_path, block_size};
 
     const auto data_path = name_gen.GetCompressedTextPath();
     std::cout << "data_path: " << data_path << std::endl;
     std::cout << "block_size: " << (int)block_size << std::endl;
+    std::cout << "cache: " << (cache_mode == CacheMode::Warm ? "warm" : "cold") << std::endl;
 
-    ObjectFileHolder dna_file_holder{data_path};
-    DnaDataAccessor dna_data{dna_file_holder};
+    std::vector<std::string> patterns_str;
+    {
+        ObjectFileHolder dna_file_holder{data_path};
+        DnaDataAccessor dna_data{dna_file_holder};
+
+        num_queries = (unsigned)dna_data.Size() / 35'000;
+        std::cout << "pattern_len: " << pattern_len << std::endl;
+        std::cout << "num_queries: " << num_queries << std::endl;
 
-    num_queries = (unsigned)dna_data.Size() / 35'000;
-    std::cout << "pattern_len: " << pattern_len << std::endl;
-    std::cout << "num_queries: " << num_queries << std::endl;
+        const str_len_t seed = 0xEDA + 0xDED * 32;
+        std::mt19937_64 gen{seed};
 
+        patterns_str.reserve(num_queries);
+
+        using UniDistT = std::uniform_int_distribution<str_pos_t>;
+        UniDistT pos_distrib{0, (str_len_t)dna_data.Size() - pattern_len - 1};
+        for (unsigned i = 0; i < num_queries; ++i) {
+            const auto pos = pos_distrib(gen);
+            patterns_str.emplace_back(DnaSeq2String(dna_data, pos, pos + pattern_len));
+        }
+    }
+
+    std::vector<typename SearcherT::Query> queries;
+    queries.reserve(num_queries);
+    for (const auto& pattern_str : patterns_str) {
+        queries.push_back(SearcherT::Prepare(pattern_str));
+    }
+
+    str_pos_t unused_counter = 0;
+    if (cache_mode == CacheMode::Warm) {
+        SearcherT searcher{name_gen};
+        for (const auto& query : queries) {
+            unused_counter += searcher.Contains(query);
+        }
+    } else {
+        EvictBlockedIndexCache(uncompr_data_path, block_size);
+    }
+
+    SearcherT searcher{name_gen};
+    LatencyHistogram latencies;
+    for (const auto& query : queries) {
+        auto time_start = now();
+        unused_counter += searcher.Contains(query);
+        auto time_finish = now();
+        latencies.Record(to_nanosec(time_start, time_finish));
+    }
+
+    if (unused_counter == 123) {
+        volatile auto t = 3;
+    }
+
+    std::cout << latencies.FormatMicros() << std::endl;
+}
+
+// Substrings of text at random positions
+std::vector<DnaBuffer> GenPatterns(const DnaDataAccessor& dna_data, str_len_t pattern_len,
+                                   unsigned num_queries) {
     const str_len_t seed = 0xEDA + 0xDED * 32;
     std::mt19937_64 gen{seed};
 
     std::vector<DnaBuffer> patterns;
     patterns.reserve(num_queries);
 
-    std::vector<std::string> patterns_str;
-    patterns_str.reserve(num_queries);
-
     using UniDistT = std::uniform_int_distribution<str_pos_t>;
     UniDistT pos_distrib{0, (str_len_t)dna_data.Size() - pattern_len - 1};
     for (unsigned i = 0; i < num_queries; ++i) {
         const auto pos = pos_distrib(gen);
         patterns.emplace_back(dna_data, pos, pos + pattern_len);
-        patterns_str.emplace_back(DnaSeq2String(dna_data, pos, pos + pattern_len));
     }
 
-    str_pos_t unused_counter = 0;
-    using time_point = std::chrono::time_point<std::chrono::high_resolution_clock>;
-    std::vector<std::pair<time_point, time_point>> times(num_queries);
+    return patterns;
+}
 
-    if constexpr (block_size == 1) {
-        using SbtT = DNA_SBT::StringBTree<DnaSymb>;
-        SbtT sbt{name_gen.GetStringBTreePath()};
+std::vector<std::string> GenPatternStrs(const DnaDataAccessor& dna_data, str_len_t pattern_len,
+                                        unsigned num_queries) {
+    const auto patterns = GenPatterns(dna_data, pattern_len, num_queries);
 
-        for (unsigned i = 0; i < num_queries; ++i) {
-            const auto& patt_buf = patterns[i];
-            auto time_start = now();
+    std::vector<std::string> patterns_str;
+    patterns_str.reserve(num_queries);
+    for (const auto& pattern : patterns) {
+        const auto pattern_dna = pattern.GetAccessor();
+        patterns_str.push_back(DnaSeq2String(pattern_dna, 0, pattern_dna.Size()));
+    }
+
+    return patterns_str;
+}
+
+// Mean latency of indexes of every d, that exists, by pattern lengths (with preparation of
+// pattern, as in MultiBlockedSearcher). Fitted cost model is stored next to indexes
+template <u8... ds>
+void calibrate_blocking(std::string data_size_suffix, std::vector<str_len_t> pattern_lens,
+                        unsigned num_queries) {
+    const auto data_path = GetDataPath(data_size_suffix);
+
+    ObjectFileHolder dna_file_holder{NameGenerator{data_path, 1}.GetCompressedTextPath()};
+    DnaDataAccessor dna_data{dna_file_holder};
+
+    std::vector<BlockingCostModel::Sample> samples;
+    auto calibrate = [&]<u8 d> {
+        NameGenerator name_gen{data_path, d};
+        if (!std::filesystem::exists(name_gen.GetStringBTreePath()) ||
+            (d > 1 && !std::filesystem::exists(name_gen.GetWaveletTreePath()))) {
+            return;
+        }
 
-            const auto pattern = patt_buf.GetAccessor();
-            auto [pos, sa_pos, sa_pos_right, is_finded] = sbt.Search(pattern, dna_data);
-            unused_counter += sa_pos;
+        BlockedSearcher<d> searcher{name_gen};
+        for (str_len_t pattern_len : pattern_lens) {
+            if (!BlockingCostModel::IsApplicable(d, pattern_len)) {
+                continue;
+            }
 
+            std::size_t num_found = 0;
+            const auto patterns_str = GenPatternStrs(dna_data, pattern_len, num_queries);
+            auto time_start = now();
+            for (const auto& pattern_str : patterns_str) {
+                num_found += searcher.Contains(searcher.Prepare(pattern_str));
+            }
             auto time_finish = now();
-            times[i] = {time_start, time_finish};
+
+            const double latency = double(to_microsec(time_start, time_finish)) / num_queries;
+            samples.push_back({d, pattern_len, latency});
+            std::cout << "d: " << (unsigned)d << ", pattern_len: " << pattern_len
+                      << ", mean: " << latency << ", found: " << num_found << std::endl;
         }
-    } else {
-        DnaSeqDataAccessor<block_size> dna_data_seq{dna_file_holder};
+    };
+    (calibrate.template operator()<ds>(), ...);
 
-        using SbtT = DNA_SBT::StringBTree<DnaSymbSeq<block_size>>;
-        SbtT sbt{name_gen.GetStringBTreePath()};
+    const auto cost_model_path = NameGenerator{data_path, 1}.GetCostModelPath();
+    BlockingCostModel::Fit(samples).Save(cost_model_path);
+    std::cout << "Cost model -> " << cost_model_path << std::endl;
+}
 
-        ObjectFileHolder suff_arr_holder{name_gen.GetSuffixArrayPath()};
-        const str_pos_t* suff_arr = (const str_pos_t*)suff_arr_holder.cbegin();
+// Latency of multi-index front-end by pattern lengths, d is chosen per batch of one length
+template <u8... ds>
+void multi_index_latency(std::string data_size_suffix, std::vector<str_len_t> pattern_lens,
+                         unsigned num_queries) {
+    const auto data_path = GetDataPath(data_size_suffix);
 
-        ReverseBWTDnaSeqAccessor rev_num_dna_data{dna_data_seq, suff_arr};
-        const std::size_t rev_num_alph_size = std::pow(8, block_size);
+    ObjectFileHolder dna_file_holder{NameGenerator{data_path, 1}.GetCompressedTextPath()};
+    DnaDataAccessor dna_data{dna_file_holder};
 
-        const auto& wt_file = WaveletTreeOnDisk{name_gen.GetWaveletTreePath()};
-        const auto& wt = wt_file.Get();
+    MultiBlockedSearcher<ds...> searcher{data_path};
+    for (str_len_t pattern_len : pattern_lens) {
+        const auto patterns_str = GenPatternStrs(dna_data, pattern_len, num_queries);
 
-        std::vector<std::tuple<DnaSymbSeq<block_size>, DnaBuffer, std::size_t>> left_right_patt_buf;
-        left_right_patt_buf.reserve(num_queries * block_size);
-        for (unsigned i = 0; i < num_queries; ++i) {
-            const auto& pattern_str = patterns_str[i];
-            for (std::size_t k = 0; k < block_size; ++k) {
-                left_right_patt_buf.emplace_back(GetLeftRightPattern<block_size>(pattern_str, k));
-            }
-        }
+        auto time_start = now();
+        const auto num_found = searcher.Contains(patterns_str);
+        auto time_finish = now();
+
+        std::cout << "pattern_len: " << pattern_len
+                  << ", d: " << (unsigned)searcher.ChooseBlockSize(patterns_str)
+                  << ", mean: " << double(to_microsec(time_start, time_finish)) / num_queries
+                  << ", found: " << num_found << std::endl;
+    }
+}
+
+// Latency of SA interval search: lower and upper bounds by two descents vs one common descent
+void search_latency(std::string data_size_suffix, str_len_t pattern_len, unsigned num_queries) {
+    NameGenerator name_gen{GetDataPath(data_size_suffix), 1};
+
+    ObjectFileHolder dna_file_holder{name_gen.GetCompressedTextPath()};
+    DnaDataAccessor dna_data{dna_file_holder};
 
-        str_pos_t unused_counter = 0;
+    DNA_SBT::StringBTree<DnaSymb> sbt{name_gen.GetStringBTreePath()};
+
+    const auto patterns = GenPatterns(dna_data, pattern_len, num_queries);
+
+    str_pos_t unused_counter = 0;
+    auto measure = [&](const char* name, auto search) {
+        LatencyHistogram latencies;
         for (unsigned i = 0; i < num_queries; ++i) {
+            const auto pattern = patterns[i].GetAccessor();
+
             auto time_start = now();
+            auto [sa_pos_left, sa_pos_right] = search(pattern);
+            auto time_finish = now();
 
-            bool is_finded = false;
-            for (std::size_t k = 0; k < block_size; ++k) {
-                const auto& [left_pattern, right_patt_buf_d1, num_term_symb] =
-                    left_right_patt_buf[k + i * block_size];
-
-                auto right_dna_d1 = right_patt_buf_d1.GetAccessor();
-                DnaSeqDataAccessor<block_size> right_pattern{right_dna_d1.data(),
-                                                             right_dna_d1.Size() / block_size};
-
-                auto [pos, sa_pos, sa_pos_right, lcp] = sbt.Search(right_pattern, dna_data_seq);
-
-                if (num_term_symb == 0) {
-                    is_finded = lcp == right_pattern.Size();
-                } else {
-                    if (lcp == right_pattern.Size() - 1) {
-                        auto patt_tail = right_pattern[lcp];
-                        auto dna_tail = dna_data_seq[pos + lcp];
-
-                        is_finded = true;
-                        for (std::size_t i = 0; i < block_size - num_term_symb; ++i) {
-                            if (patt_tail[i] != dna_tail[i]) {
-                                is_finded = false;
-                                break;
-                            }
-                        }
-                    }
-                }
+            unused_counter += sa_pos_right - sa_pos_left;
+            latencies.Record(to_nanosec(time_start, time_finish));
+        }
 
-                if (is_finded) {
-                    unused_counter += sa_pos;
-                    break;
-                }
+        std::cout << name << ") " << latencies.FormatMicros() << std::endl;
+    };
 
-                const auto left_pattern_num = DnaSeq2Number(left_pattern);
-                auto [res_pos, is_rank_finded] =
-                    wt.GetFirstRank(left_pattern_num, 3 /* bits */ * k, sa_pos, sa_pos_right);
+    measure("two descents", [&](const DnaDataAccessor& pattern) {
+        return std::pair{sbt.SearchBound<DNA_PT::Bound::Lower>(pattern, dna_data),
+                         sbt.SearchBound<DNA_PT::Bound::Upper>(pattern, dna_data)};
+    });
+    measure("one descent", [&](const DnaDataAccessor& pattern) {
+        return sbt.SearchRange(pattern, dna_data);
+    });
 
-                if (is_rank_finded) {
-                    unused_counter += sa_pos;
-                    break;
-                }
-            }
+    if (unused_counter == 123) {
+        volatile auto t = 3;
+    }
+}
+
+// Latency of SA interval search by engine: "sbt" is StringBTree on disk, "fm" is FM-index,
+// "ri" is r-index, indexes are built next to SBT if they do not exist
+void engine_latency(std::string data_size_suffix, str_len_t pattern_len, unsigned num_queries,
+                    std::string_view engine) {
+    NameGenerator name_gen{GetDataPath(data_size_suffix), 1};
+
+    ObjectFileHolder dna_file_holder{name_gen.GetCompressedTextPath()};
+    DnaDataAccessor dna_data{dna_file_holder};
+
+    const auto patterns = GenPatterns(dna_data, pattern_len, num_queries);
+
+    str_pos_t unused_counter = 0;
+    auto measure = [&](auto search) {
+        LatencyHistogram latencies;
+        for (unsigned i = 0; i < num_queries; ++i) {
+            const auto pattern = patterns[i].GetAccessor();
 
+            auto time_start = now();
+            auto [sa_pos_left, sa_pos_right] = search(pattern);
             auto time_finish = now();
-            times[i] = {time_start, time_finish};
+
+            unused_counter += sa_pos_right - sa_pos_left;
+            latencies.Record(to_nanosec(time_start, time_finish));
+        }
+
+        std::cout << engine << ", pattern_len: " << pattern_len << ") "
+                  << latencies.FormatMicros() << std::endl;
+    };
+
+    if (engine == "sbt") {
+        DNA_SBT::StringBTree<DnaSymb> sbt{name_gen.GetStringBTreePath()};
+        measure([&](const DnaDataAccessor& pattern) {
+            return sbt.SearchRange(pattern, dna_data);
+        });
+    } else if (engine == "fm") {
+        const auto& fm_path = name_gen.GetFMIndexPath();
+        if (!std::filesystem::exists(fm_path)) {
+            FMIndexOnDisk::Build(fm_path, dna_data, name_gen.GetSuffixArrayPath());
         }
+        FMIndexOnDisk fm_file{fm_path};
+        const auto& fm = fm_file.Get();
+        measure([&](const DnaDataAccessor& pattern) { return fm.SearchRange(pattern); });
+    } else if (engine == "ri") {
+        const auto& r_index_path = name_gen.GetRIndexPath();
+        if (!std::filesystem::exists(r_index_path)) {
+            RIndexOnDisk::Build(r_index_path, dna_data, name_gen.GetSuffixArrayPath());
+        }
+        RIndexOnDisk r_index_file{r_index_path};
+        const auto& r_index = r_index_file.Get();
+        std::cout << "runs: " << r_index.GetNumRuns() << ", size: "
+                  << std::filesystem::file_size(r_index_path) << std::endl;
+        measure([&](const DnaDataAccessor& pattern) {
+            auto res = r_index.Search(pattern);
+            return std::pair{res.sa_pos_left, res.sa_pos_right};
+        });
+    } else {
+        throw std::invalid_argument{"Unknown search engine, use \"sbt\", \"fm\" or \"ri\""};
     }
 
     if (unused_counter == 123) {
         volatile auto t = 3;
     }
+}
+
+// Blocks touched per query: SBT nodes and random reads of text. SBT with key cache or
+// succinct PT is built next to ordinary SBT
+template <uint KeyCacheLen, DNA_PT::Format PtFormatV = DNA_PT::Format::Pointer>
+void blocks_per_query(std::string data_size_suffix, str_len_t pattern_len, unsigned num_queries) {
+    NameGenerator name_gen{GetDataPath(data_size_suffix), 1};
+
+    ObjectFileHolder dna_file_holder{name_gen.GetCompressedTextPath()};
+    DnaDataAccessor dna_data{dna_file_holder};
 
-    const auto num_sections = 5 * 0 + 1;
-    const auto step = num_queries / num_sections;
-    for (unsigned j = 0; j < num_sections; ++j) {
-        std::vector<std::size_t> deltas((j + 1) * step);
-        for (unsigned i = 0; i < deltas.size(); ++i) {
-            const auto& [time_start, time_finish] = times[i];
-            deltas[i] = to_microsec(time_start, time_finish);
+    constexpr bool is_succinct = PtFormatV == DNA_PT::Format::Succinct;
+
+    using SbtT = DNA_SBT::StringBTree<DnaSymb, KeyCacheLen, PtFormatV>;
+    auto sbt_path = name_gen.GetStringBTreePath();
+    if constexpr (KeyCacheLen || is_succinct) {
+        if constexpr (KeyCacheLen) {
+            sbt_path += ".kc" + std::to_string(KeyCacheLen);
+        }
+        if constexpr (is_succinct) {
+            sbt_path += ".succ";
+        }
+        if (!std::filesystem::exists(sbt_path)) {
+            SbtT::Build(sbt_path, dna_data, name_gen.GetSuffixArrayPath());
         }
+    }
+    SbtT sbt{sbt_path};
+
+    const auto patterns = GenPatterns(dna_data, pattern_len, num_queries);
 
-        auto [mean, disp] = CalcMeanDisp(deltas);
-        std::cout << j << ") mean: " << mean << ", disp: " << disp << std::endl;
+    uint64_t num_node_reads = 0, num_text_reads = 0;
+    for (const auto& pattern_buf : patterns) {
+        auto res = sbt.Search(pattern_buf.GetAccessor(), dna_data);
+        num_node_reads += res.stats.num_node_reads;
+        num_text_reads += res.stats.num_text_reads;
     }
+
+    std::cout << "key cache: " << KeyCacheLen << ", succinct PT: " << is_succinct
+              << ", blocks: " << std::filesystem::file_size(sbt_path) / g_block_size
+              << ", nodes: " << double(num_node_reads) / num_queries
+              << ", text: " << double(num_text_reads) / num_queries << std::endl;
+}
+
+// Balanced wavelet tree vs wavelet tree shaped by frequencies of d-mers: mean number of bit
+// vectors per rank and occupied size. Occupied size of wavelet tree with RRR nodes of low entropy
+template <u8 block_size>
+void wavelet_tree_shape(std::string data_size_suffix) {
+    NameGenerator name_gen{GetDataPath(data_size_suffix), block_size};
+
+    ObjectFileHolder dna_file_holder{name_gen.GetCompressedTextPath()};
+    DnaSeqDataAccessor<block_size> dna{dna_file_holder};
+
+    ObjectFileHolder suff_arr_holder{name_gen.GetSuffixArrayPath()};
+    const str_pos_t* suff_arr = (const str_pos_t*)suff_arr_holder.cbegin();
+
+    ReverseBWTDnaSeqAccessor rev_num_dna{dna, suff_arr};
+    const std::size_t rev_num_alph_size = std::pow(8, block_size);
+
+    auto wt_build_info = WaveletTree::PrepareBuild(rev_num_dna, rev_num_alph_size);
+    auto swt_build_info = ShapedWaveletTree::PrepareBuild(rev_num_dna, rev_num_alph_size);
+    auto hwt_build_info = HybridWaveletTree::PrepareBuild(rev_num_dna, rev_num_alph_size);
+
+    std::cout << "d: " << (unsigned)block_size << ", levels: " << 3 * block_size
+              << ", shaped mean depth: " << swt_build_info.GetMeanDepth()
+              << ", size: " << wt_build_info.CalcOccupiedSize() << " -> "
+              << swt_build_info.CalcOccupiedSize()
+              << ", hybrid size: " << hwt_build_info.CalcOccupiedSize() << std::endl;
 }
 
 }  // namespace lab
@@ -657,8 +814,9 @@ void main(int argc, char* argv[]) {
         return;
     }
 
-    if (argc != 3) {
-        throw std::invalid_argument{"Enter block size and data size index"};
+    if (argc != 3 && argc != 4) {
+        throw std::invalid_argument{
+            "Enter block size, data size index and optionally cache mode (warm or cold)"};
     }
 
     int block_size_input = atoi(argv[1]);
@@ -667,9 +825,11 @@ void main(int argc, char* argv[]) {
     str_len_t pattern_len = 64;
 
     std::string data_size_suffix = data_size_arr[data_size_index];
+    const CacheMode cache_mode =
+        argc == 4 && std::string_view{argv[3]} == "cold" ? CacheMode::Cold : CacheMode::Warm;
 
     auto lab_start = [&]<u8 block_size> {
-        lab::start<block_size>(num_queries, data_size_suffix, pattern_len);
+        lab::start<block_size>(num_queries, data_size_suffix, pattern_len, cache_mode);
     };
 
     switch (block_size_input) {
@@ -736,8 +896,9 @@ void main(int argc, char* argv[]) {
         return;
     }
 
-    if (argc != 3) {
-        throw std::invalid_argument{"Enter block size and data size index"};
+    if (argc != 3 && argc != 4) {
+        throw std::invalid_argument{
+            "Enter block size, data size index and optionally cache mode (warm or cold)"};
     }
 
     int block_size_input = atoi(argv[1]);
@@ -746,8 +907,10 @@ void main(int argc, char* argv[]) {
     str_len_t pattern_len = 16;
 
     std::string data_size_suffix = data_size_arr[data_size_index];
+    const CacheMode cache_mode =
+        argc == 4 && std::string_view{argv[3]} == "cold" ? CacheMode::Cold : CacheMode::Warm;
     auto lab_start = [&]<u8 block_size> {
-        lab::start<block_size>(num_queries, data_size_suffix, pattern_len);
+        lab::start<block_size>(num_queries, data_size_suffix, pattern_len, cache_mode);
     };
 
     switch (block_size_input) {
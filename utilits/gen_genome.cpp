@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "../dna/genome_generator.h"
+
+namespace {
+
+void PrintUsage() {
+    std::cerr
+        << "Usage: gen_genome <out_path> <size>[K|M|G] [options]\n"
+           "Writes .comp, if out_path ends with .comp (N-runs are skipped), else FASTA\n"
+           "Options:\n"
+           "  --order <k>           order of Markov chain of background (3)\n"
+           "  --gc <x>              GC content (0.41)\n"
+           "  --tandem <x>          tandem repeats per symbol (1e-4)\n"
+           "  --interspersed <x>    interspersed repeats per symbol (1e-4)\n"
+           "  --n-runs <x>          N-runs per symbol (1e-6)\n"
+           "  --divergence <x>      mutation probability of repeat symbol (0.02)\n"
+           "  --seed <s>            seed (0xEDA)\n"
+           "  --d <d>               d_max of .comp (1)\n";
+}
+
+// Size with suffix K, M or G of powers of 1024
+uint64_t ParseSize(std::string_view str) {
+    std::size_t num_parsed = 0;
+    uint64_t size = std::stoull(std::string{str}, &num_parsed);
+
+    const auto suffix = str.substr(num_parsed);
+    if (suffix == "K") {
+        size <<= 10;
+    } else if (suffix == "M") {
+        size <<= 20;
+    } else if (suffix == "G") {
+        size <<= 30;
+    } else if (!suffix.empty()) {
+        throw std::invalid_argument{"Incorrect size: " + std::string{str}};
+    }
+
+    return size;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) try {
+    if (argc < 3 || argc % 2 == 0) {
+        PrintUsage();
+        return 1;
+    }
+
+    const std::string_view out_path{argv[1]};
+
+    GenomeGenParams params;
+    params.size = ParseSize(argv[2]);
+    uint d_max = 1;
+
+    for (int i = 3; i < argc; i += 2) {
+        const std::string_view option{argv[i]};
+        const std::string value{argv[i + 1]};
+
+        if (option == "--order") {
+            params.markov_order = std::stoul(value);
+        } else if (option == "--gc") {
+            params.gc_content = std::stod(value);
+        } else if (option == "--tandem") {
+            params.tandem_rate = std::stod(value);
+        } else if (option == "--interspersed") {
+            params.interspersed_rate = std::stod(value);
+        } else if (option == "--n-runs") {
+            params.n_run_rate = std::stod(value);
+        } else if (option == "--divergence") {
+            params.divergence = std::stod(value);
+        } else if (option == "--seed") {
+            params.seed = std::stoull(value, nullptr, 0);
+        } else if (option == "--d") {
+            d_max = std::stoul(value);
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (out_path.ends_with(".comp")) {
+        auto dna_file_holder = GenerateGenomeComp(out_path, params, d_max);
+        std::cout << "Compressed DNA: " << out_path << ", " << dna_file_holder.Size()
+                  << " symbols" << std::endl;
+    } else {
+        GenerateGenomeFasta(out_path, params);
+        std::cout << "FASTA: " << out_path << ", " << params.size << " symbols" << std::endl;
+    }
+} catch (std::exception& exc) {
+    std::cerr << "Exception: " << exc.what() << std::endl;
+    return 1;
+}
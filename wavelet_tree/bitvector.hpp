@@ -1,12 +1,57 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <cmath>
+#include <bit>
+#include <cassert>
 
 #include "../common/common_type.h"
 #include "../common/help_func.h"
 #include "compr_num_buf.hpp"
 
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#if !defined(__BMI2__)
+// Position of rank-th one of byte
+constexpr auto g_select_in_byte = [] {
+    std::array<std::array<u8, 8>, 256> table{};
+    for (uint byte = 0; byte < 256; ++byte) {
+        for (uint pos = 0, rank = 0; pos < 8; ++pos) {
+            if (byte & (1u << pos)) {
+                table[byte][rank++] = pos;
+            }
+        }
+    }
+    return table;
+}();
+#endif
+
+// Position of rank-th one of word, ones are counted from low bit
+inline uint SelectInWord(uint64_t word, uint rank) noexcept {
+#if defined(__BMI2__)
+    return std::countr_zero(_pdep_u64(uint64_t{1} << rank, word));
+#else
+    constexpr uint64_t c_low_bits = 0x0101'0101'0101'0101;
+    constexpr uint64_t c_high_bits = 0x8080'8080'8080'8080;
+
+    // Byte i of byte_ranks is number of ones in bytes [0, i]
+    uint64_t byte_ranks = word - ((word >> 1) & 0x5555'5555'5555'5555);
+    byte_ranks = (byte_ranks & 0x3333'3333'3333'3333) + ((byte_ranks >> 2) & 0x3333'3333'3333'3333);
+    byte_ranks = ((byte_ranks + (byte_ranks >> 4)) & 0x0F0F'0F0F'0F0F'0F0F) * c_low_bits;
+
+    // First byte with rank greater then rank
+    const uint64_t greater = ((byte_ranks | c_high_bits) - (rank + 1) * c_low_bits) & c_high_bits;
+    const uint byte_pos = std::countr_zero(greater) & ~7u;
+
+    rank -= ((byte_ranks << 8) >> byte_pos) & 0xFFu;
+    return byte_pos + g_select_in_byte[(word >> byte_pos) & 0xFFu][rank];
+#endif
+}
+
 class BitVectorNaive {
 public:
     BitVectorNaive(std::size_t size)
@@ -137,6 +182,20 @@ public:
         buf[byte_pos] = byte;
     }
 
+    // Bits [64 * i_word, 64 * i_word + 64) from low bit of word, bits after size are skipped
+    void SetWord(size_t i_word, uint64_t word) noexcept {
+        const size_t pos_begin = 64 * i_word;
+        const size_t pos_end = std::min<size_t>(pos_begin + 64, m_size);
+        for (size_t pos = pos_begin; pos < pos_end; ++pos, word >>= 1) {
+            Set(pos, word & 1u);
+        }
+    }
+
+    // Loads bits of GetRank(pos) to cache
+    void Prefetch(size_t pos) const noexcept {
+        __builtin_prefetch(Buf() + pos / 8);
+    }
+
     size_t GetRank(size_t pos) const noexcept {
         size_t i_sblk = pos / m_sblk_bit_size;
         size_t in_sblk_pos = pos % m_sblk_bit_size;
@@ -172,8 +231,10 @@ public:
         }
 
         const auto& blk = BlkBuf();
+        std::vector<CompressedNumberBuf::chank_t> blk_ranks(blk.Size());
+        blk.DecodeRange(0, blk.Size(), blk_ranks.data());
         for (size_t i_blk = 0; i_blk < blk.Size(); ++i_blk) {
-            printf("blk[%u]: %u\n", i_blk, blk.Get(i_blk));
+            printf("blk[%u]: %u\n", i_blk, blk_ranks[i_blk]);
         }
     }
 
@@ -218,10 +279,270 @@ private:
     size_t m_blk_pos;
 };
 
+/*
+    Rank9-like layout: counters are interleaved with bits in 64-byte blocks, so rank reads one
+    cache line. Block is header and 7 words of bits, header keeps number of ones before block
+    (low 32 bits) and number of ones in block before words 2, 4, 6 (9 bits each).
+    Object takes cache line, so blocks are aligned if object is aligned by 64.
+
+    Select: after blocks are numbers of blocks with every c_select_sample-th one, then with
+    every c_select_sample-th zero. Block of answer is binary searched between two samples.
+*/
+class alignas(8) BitVectorInterleaved {
+public:
+    using size_t = uint32_t;
+
+    BitVectorInterleaved(size_t size)
+        : m_size{size} {}
+
+    static size_t CalcOccupiedSize(size_t size) noexcept {
+        const std::size_t blks_size = CalcNumBlk(size) * sizeof(Block);
+        const std::size_t samples_size = (size / c_select_sample + 2) * sizeof(size_t);
+        return AlignPos(sizeof(BitVectorInterleaved) + blks_size + samples_size, 64);
+    }
+
+    void Reinit() noexcept {
+        ReinitRank();
+        ReinitSelect<true>();
+        ReinitSelect<false>();
+    }
+
+    size_t Size() const noexcept {
+        return m_size;
+    }
+
+    bool Get(size_t pos) const noexcept {
+        const Block& blk = Blks()[pos / c_blk_bit_size];
+        const size_t in_blk_pos = pos % c_blk_bit_size;
+        return (blk.words[in_blk_pos / 64] >> (in_blk_pos % 64)) & 1u;
+    }
+    void Set(size_t pos, bool value) noexcept {
+        Block& blk = Blks()[pos / c_blk_bit_size];
+        const size_t in_blk_pos = pos % c_blk_bit_size;
+
+        uint64_t& word = blk.words[in_blk_pos / 64];
+        const uint64_t mask = uint64_t{1} << (in_blk_pos % 64);
+        word = value ? word | mask : word & ~mask;
+    }
+
+    // Bits [64 * i_word, 64 * i_word + 64) from low bit of word, bits after size must be zero
+    void SetWord(size_t i_word, uint64_t word) noexcept {
+        Blks()[i_word / c_blk_num_word].words[i_word % c_blk_num_word] = word;
+    }
+
+    // Loads block of GetRank(pos) to cache
+    void Prefetch(size_t pos) const noexcept {
+        __builtin_prefetch(&Blks()[pos / c_blk_bit_size]);
+    }
+
+    // Number of ones in [0, pos)
+    size_t GetRank(size_t pos) const noexcept {
+        const Block& blk = Blks()[pos / c_blk_bit_size];
+        const size_t in_blk_pos = pos % c_blk_bit_size;
+        const size_t i_word = in_blk_pos / 64;
+
+        size_t rank = (uint32_t)blk.header;
+        if (i_word >= 2) {
+            rank += (blk.header >> GetHeaderShift(i_word)) & 0x1FFu;
+        }
+        if (i_word % 2) {
+            rank += std::popcount(blk.words[i_word - 1]);
+        }
+
+        const uint64_t mask = (uint64_t{1} << (in_blk_pos % 64)) - 1;
+        rank += std::popcount(blk.words[i_word] & mask);
+
+        return rank;
+    }
+
+    // Position of rank-th one (zero), rank from 0, must be less then number of ones (zeros)
+    size_t Select1(size_t rank) const noexcept {
+        return Select<true>(rank);
+    }
+    size_t Select0(size_t rank) const noexcept {
+        return Select<false>(rank);
+    }
+
+    void Dump() const {
+        printf("size: %u\n", m_size);
+        for (size_t i_blk = 0; i_blk < CalcNumBlk(m_size); ++i_blk) {
+            const uint64_t header = Blks()[i_blk].header;
+            printf("blk[%u]: %u", i_blk, (uint32_t)header);
+            for (size_t i_word = 2; i_word < c_blk_num_word; i_word += 2) {
+                printf(" %u", uint32_t(header >> GetHeaderShift(i_word)) & 0x1FFu);
+            }
+            putchar('\n');
+        }
+    }
+
+private:
+    constexpr static size_t c_blk_num_word = 7;
+    constexpr static size_t c_blk_bit_size = 64 * c_blk_num_word;
+    constexpr static size_t c_select_sample = 2048;
+
+    struct Block {
+        uint64_t header;
+        uint64_t words[c_blk_num_word];
+    };
+    static_assert(sizeof(Block) == 64);
+
+    // Extra block for rank of size
+    static size_t CalcNumBlk(size_t size) noexcept {
+        return size / c_blk_bit_size + 1;
+    }
+
+    static size_t CalcNumSample(size_t num_bits) noexcept {
+        return DivUp(num_bits, c_select_sample);
+    }
+
+    // Shift of in block rank before even word
+    static size_t GetHeaderShift(size_t i_word) noexcept {
+        return 32 + (i_word / 2 - 1) * 9;
+    }
+
+    void ReinitRank() noexcept {
+        Block* blks = Blks();
+        const size_t num_blk = CalcNumBlk(m_size);
+
+        size_t rank = 0;
+        for (size_t i_blk = 0; i_blk < num_blk; ++i_blk) {
+            Block& blk = blks[i_blk];
+
+            uint64_t header = rank;
+            size_t in_blk_rank = 0;
+            for (size_t i_word = 0; i_word < c_blk_num_word; ++i_word) {
+                if (i_word && i_word % 2 == 0) {
+                    header |= uint64_t(in_blk_rank) << GetHeaderShift(i_word);
+                }
+                in_blk_rank += std::popcount(blk.words[i_word]);
+            }
+
+            blk.header = header;
+            rank += in_blk_rank;
+        }
+
+        m_num_ones = rank;
+    }
+
+    template <bool BitV>
+    void ReinitSelect() noexcept {
+        size_t* samples = GetSelectSamples<BitV>();
+        const size_t num_blk = CalcNumBlk(m_size);
+        const size_t num_bits = GetNumBits<BitV>();
+
+        // Every block except of last is full
+        size_t i_sample = 0;
+        for (size_t i_blk = 0; i_sample * c_select_sample < num_bits; ++i_blk) {
+            const size_t next_rank = i_blk + 1 < num_blk ? GetBlkRank<BitV>(i_blk + 1) : num_bits;
+            for (; i_sample * c_select_sample < next_rank; ++i_sample) {
+                samples[i_sample] = i_blk;
+            }
+        }
+    }
+
+    template <bool BitV>
+    size_t Select(size_t rank) const noexcept {
+        const size_t* samples = GetSelectSamples<BitV>();
+        const size_t i_sample = rank / c_select_sample;
+
+        // Last block with rank before it not greater then rank
+        size_t i_blk_l = samples[i_sample];
+        size_t i_blk_r = i_sample + 1 < CalcNumSample(GetNumBits<BitV>()) ? samples[i_sample + 1]
+                                                                           : CalcNumBlk(m_size) - 1;
+        while (i_blk_l < i_blk_r) {
+            const size_t i_blk_mid = (i_blk_l + i_blk_r + 1) / 2;
+            if (GetBlkRank<BitV>(i_blk_mid) <= rank) {
+                i_blk_l = i_blk_mid;
+            } else {
+                i_blk_r = i_blk_mid - 1;
+            }
+        }
+
+        const Block& blk = Blks()[i_blk_l];
+        rank -= GetBlkRank<BitV>(i_blk_l);
+
+        size_t i_word = 0;
+        for (size_t i = 2; i < c_blk_num_word && GetInBlkRank<BitV>(blk, i) <= rank; i += 2) {
+            i_word = i;
+        }
+        rank -= GetInBlkRank<BitV>(blk, i_word);
+
+        uint64_t word = GetWord<BitV>(blk, i_word);
+        if (const size_t word_rank = std::popcount(word); word_rank <= rank) {
+            rank -= word_rank;
+            word = GetWord<BitV>(blk, ++i_word);
+        }
+
+        return i_blk_l * c_blk_bit_size + 64 * i_word + SelectInWord(word, rank);
+    }
+
+    template <bool BitV>
+    size_t GetNumBits() const noexcept {
+        return BitV ? m_num_ones : m_size - m_num_ones;
+    }
+
+    // Number of ones (zeros) before block
+    template <bool BitV>
+    size_t GetBlkRank(size_t i_blk) const noexcept {
+        const size_t rank = (uint32_t)Blks()[i_blk].header;
+        return BitV ? rank : i_blk * c_blk_bit_size - rank;
+    }
+
+    // Number of ones (zeros) in block before even word
+    template <bool BitV>
+    static size_t GetInBlkRank(const Block& blk, size_t i_word) noexcept {
+        const size_t rank = i_word ? (blk.header >> GetHeaderShift(i_word)) & 0x1FFu : 0;
+        return BitV ? rank : 64 * i_word - rank;
+    }
+
+    template <bool BitV>
+    static uint64_t GetWord(const Block& blk, size_t i_word) noexcept {
+        return BitV ? blk.words[i_word] : ~blk.words[i_word];
+    }
+
+    Block* Blks() noexcept {
+        return (Block*)(this + 1);
+    }
+    const Block* Blks() const noexcept {
+        return (const Block*)(this + 1);
+    }
+
+    template <bool BitV>
+    size_t* GetSelectSamples() noexcept {
+        size_t* samples = (size_t*)(Blks() + CalcNumBlk(m_size));
+        return BitV ? samples : samples + CalcNumSample(m_num_ones);
+    }
+    template <bool BitV>
+    const size_t* GetSelectSamples() const noexcept {
+        const size_t* samples = (const size_t*)(Blks() + CalcNumBlk(m_size));
+        return BitV ? samples : samples + CalcNumSample(m_num_ones);
+    }
+
+private:
+    size_t m_size;
+    size_t m_num_ones;
+    u8 m_reserved[56];
+};
+static_assert(sizeof(BitVectorInterleaved) == 64);
+
+// Bit vector is made from summary of its bits (constructor and CalcOccupiedSize): size for plain
+// bit vectors, Summary of words for compressed ones
+template <typename BitVectorT>
+struct BitVectorSummary {
+    using type = typename BitVectorT::size_t;
+};
+
+template <typename BitVectorT>
+    requires requires { typename BitVectorT::Summary; }
+struct BitVectorSummary<BitVectorT> {
+    using type = typename BitVectorT::Summary;
+};
+
+template <typename BitVectorT = BitVector>
 class BitVectorBuffer {
 public:
     BitVectorBuffer(std::size_t size)
-        : m_buf(BitVector::CalcOccupiedSize(size))
+        : m_buf(BitVectorT::CalcOccupiedSize(size))
         , m_size{size} {}
 
     u8* Data() noexcept {
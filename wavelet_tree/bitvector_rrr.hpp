@@ -0,0 +1,426 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstring>
+
+#include "../common/common_type.h"
+#include "../common/help_func.h"
+#include "bitvector.hpp"
+
+// Coding of 15-bit blocks of RRR bit vector: block of class k (number of ones) is coded by its
+// index (offset) among blocks of class k in increasing order
+struct RRRTables {
+    std::array<u8, 16> offset_bit_len;
+    std::array<uint16_t, 16> class_begin;
+    std::array<uint16_t, 1u << 15> offsets;  // By block
+    std::array<uint16_t, 1u << 15> blocks;   // By class_begin[k] + offset
+};
+
+inline constexpr RRRTables g_rrr_tables = [] {
+    RRRTables tables{};
+
+    std::array<uint, 16> class_size{};
+    for (uint block = 0; block < (1u << 15); ++block) {
+        ++class_size[std::popcount(block)];
+    }
+    for (uint k = 0, begin = 0; k < 16; ++k) {
+        tables.class_begin[k] = begin;
+        tables.offset_bit_len[k] = std::bit_width(class_size[k] - 1);
+        begin += class_size[k];
+    }
+
+    std::array<uint, 16> class_ctr{};
+    for (uint block = 0; block < (1u << 15); ++block) {
+        const uint k = std::popcount(block);
+        const uint offset = class_ctr[k]++;
+        tables.offsets[block] = offset;
+        tables.blocks[tables.class_begin[k] + offset] = block;
+    }
+
+    return tables;
+}();
+
+/*
+    RRR bit vector: bits are split in blocks of 15 bits, block is kept as class (4 bits) and
+    offset (up to 13 bits, no bits for blocks of zeros or ones), so runs take 4 bits per block.
+    Super block of 32 blocks keeps rank and offset position before it. Rank sums classes of
+    super block before block and decodes block by table, select binary searches super blocks.
+
+    Size depends on bits, so bit vector is made from Summary of its words. Words are written
+    by SetWord in order, Reinit finishes writing.
+*/
+class alignas(8) BitVectorRRR {
+public:
+    using size_t = uint32_t;
+
+    // Splits words of bit vector to blocks, last block is padded by zeros
+    class BlockSplitter {
+    public:
+        BlockSplitter(size_t size)
+            : m_size{size} {}
+
+        size_t NumPushedBits() const noexcept {
+            return m_num_pushed;
+        }
+
+        template <typename BlockFuncT>
+        void Push(uint64_t word, BlockFuncT&& func) {
+            size_t num_bits = std::min<size_t>(64, m_size - m_num_pushed);
+            m_num_pushed += num_bits;
+
+            while (num_bits) {
+                const size_t len = std::min(num_bits, c_blk_bit_size - m_tail_len);
+                m_tail |= (word & ((uint64_t{1} << len) - 1)) << m_tail_len;
+                m_tail_len += len;
+                word >>= len;
+                num_bits -= len;
+
+                if (m_tail_len == c_blk_bit_size || (!num_bits && m_num_pushed == m_size)) {
+                    func(m_tail);
+                    m_tail = 0;
+                    m_tail_len = 0;
+                }
+            }
+        }
+
+    private:
+        size_t m_size;
+        size_t m_num_pushed = 0;
+        uint64_t m_tail = 0;
+        size_t m_tail_len = 0;
+    };
+
+    // Size and number of offset bits, words are added in order
+    class Summary {
+    public:
+        Summary(size_t size = 0)
+            : m_splitter{size}
+            , m_size{size} {}
+
+        void AddWord(uint64_t word) {
+            m_splitter.Push(word, [&](uint64_t blk) {
+                m_num_offset_bits += g_rrr_tables.offset_bit_len[std::popcount(blk)];
+            });
+        }
+
+        size_t Size() const noexcept {
+            return m_size;
+        }
+
+        size_t NumOffsetBits() const noexcept {
+            return m_num_offset_bits;
+        }
+
+    private:
+        BlockSplitter m_splitter;
+        size_t m_size;
+        size_t m_num_offset_bits = 0;
+    };
+
+    BitVectorRRR(const Summary& summary)
+        : m_size{summary.Size()}
+        , m_num_blk{DivUp(m_size, c_blk_bit_size)}
+        , m_classes_pos{CalcClassesPos(m_num_blk)}
+        , m_offsets_pos{m_classes_pos + CalcClassesSize(m_num_blk)}
+        , m_splitter{m_size} {
+        // Classes and offsets are written by or
+        std::memset(reinterpret_cast<u8*>(this) + sizeof(BitVectorRRR), 0,
+                    CalcOccupiedSize(summary) - sizeof(BitVectorRRR));
+    }
+
+    static size_t CalcOccupiedSize(const Summary& summary) noexcept {
+        const size_t num_blk = DivUp(summary.Size(), c_blk_bit_size);
+        const size_t offsets_pos = CalcClassesPos(num_blk) + CalcClassesSize(num_blk);
+        return AlignPos(offsets_pos + DivUp(summary.NumOffsetBits(), 8) + sizeof(uint64_t));
+    }
+
+    size_t Size() const noexcept {
+        return m_size;
+    }
+
+    // Bits [64 * i_word, 64 * i_word + 64) from low bit of word, bits after size must be zero.
+    // Words must be set in order
+    void SetWord([[maybe_unused]] size_t i_word, uint64_t word) noexcept {
+        assert(64 * i_word == m_splitter.NumPushedBits());
+        m_splitter.Push(word, [&](uint64_t blk) {
+            AppendBlock(blk);
+        });
+    }
+
+    void Reinit() noexcept {
+        assert(m_num_written_blk == m_num_blk);
+
+        // Super block after last block for rank of size and select
+        if (m_num_blk % c_sblk_num_blk == 0) {
+            Sblks()[m_num_blk / c_sblk_num_blk] = {m_num_ones, m_offset_write_pos};
+        }
+    }
+
+    bool Get(size_t pos) const noexcept {
+        const size_t i_blk = pos / c_blk_bit_size;
+        const size_t offset_pos = GetBlkRank(i_blk).second;
+        return (GetBlock(i_blk, offset_pos) >> (pos % c_blk_bit_size)) & 1u;
+    }
+
+    // Loads super block and classes of GetRank(pos) to cache
+    void Prefetch(size_t pos) const noexcept {
+        const size_t i_blk = pos / c_blk_bit_size;
+        __builtin_prefetch(&Sblks()[i_blk / c_sblk_num_blk]);
+        __builtin_prefetch(&Classes()[i_blk / c_word_num_class]);
+    }
+
+    // Number of ones in [0, pos)
+    size_t GetRank(size_t pos) const noexcept {
+        const size_t i_blk = pos / c_blk_bit_size;
+        auto [rank, offset_pos] = GetBlkRank(i_blk);
+
+        if (const size_t in_blk_pos = pos % c_blk_bit_size) {
+            const uint64_t mask = (uint64_t{1} << in_blk_pos) - 1;
+            rank += std::popcount(GetBlock(i_blk, offset_pos) & mask);
+        }
+
+        return rank;
+    }
+
+    // Position of rank-th one (zero), rank from 0, must be less then number of ones (zeros)
+    size_t Select1(size_t rank) const noexcept {
+        return Select<true>(rank);
+    }
+    size_t Select0(size_t rank) const noexcept {
+        return Select<false>(rank);
+    }
+
+private:
+    constexpr static size_t c_blk_bit_size = 15;
+    constexpr static size_t c_sblk_num_blk = 32;
+    constexpr static size_t c_sblk_bit_size = c_sblk_num_blk * c_blk_bit_size;
+    constexpr static size_t c_word_num_class = 16;
+
+    struct SuperBlock {
+        size_t rank;
+        size_t offset_pos;
+    };
+
+    // Extra super block for rank of size
+    static size_t CalcNumSblk(size_t num_blk) noexcept {
+        return num_blk / c_sblk_num_blk + 1;
+    }
+
+    static size_t CalcClassesPos(size_t num_blk) noexcept {
+        return AlignPos(sizeof(BitVectorRRR) + CalcNumSblk(num_blk) * sizeof(SuperBlock));
+    }
+
+    static size_t CalcClassesSize(size_t num_blk) noexcept {
+        return DivUp(num_blk, c_word_num_class) * sizeof(uint64_t);
+    }
+
+    void AppendBlock(uint64_t blk) noexcept {
+        const size_t i_blk = m_num_written_blk++;
+        if (i_blk % c_sblk_num_blk == 0) {
+            Sblks()[i_blk / c_sblk_num_blk] = {m_num_ones, m_offset_write_pos};
+        }
+
+        const size_t k = std::popcount(blk);
+        Classes()[i_blk / c_word_num_class] |= uint64_t(k) << (4 * (i_blk % c_word_num_class));
+
+        u8* offset_ptr = Offsets() + m_offset_write_pos / 8;
+        uint64_t offset_word = misalign_load<uint64_t>(offset_ptr);
+        offset_word |= uint64_t(g_rrr_tables.offsets[blk]) << (m_offset_write_pos % 8);
+        misalign_store<uint64_t>(offset_ptr, offset_word);
+
+        m_num_ones += k;
+        m_offset_write_pos += g_rrr_tables.offset_bit_len[k];
+    }
+
+    size_t GetClass(size_t i_blk) const noexcept {
+        return (Classes()[i_blk / c_word_num_class] >> (4 * (i_blk % c_word_num_class))) & 0xFu;
+    }
+
+    // {number of ones before block, offset position of block}
+    std::pair<size_t, size_t> GetBlkRank(size_t i_blk) const noexcept {
+        const size_t i_sblk = i_blk / c_sblk_num_blk;
+        const SuperBlock& sblk = Sblks()[i_sblk];
+
+        size_t rank = sblk.rank;
+        size_t offset_pos = sblk.offset_pos;
+        for (size_t j_blk = i_sblk * c_sblk_num_blk; j_blk < i_blk; ++j_blk) {
+            const size_t k = GetClass(j_blk);
+            rank += k;
+            offset_pos += g_rrr_tables.offset_bit_len[k];
+        }
+
+        return {rank, offset_pos};
+    }
+
+    uint64_t GetBlock(size_t i_blk, size_t offset_pos) const noexcept {
+        const size_t k = GetClass(i_blk);
+        const uint64_t mask = (uint64_t{1} << g_rrr_tables.offset_bit_len[k]) - 1;
+        const size_t offset = (misalign_load<uint64_t>(Offsets() + offset_pos / 8) >>
+                               (offset_pos % 8)) &
+                              mask;
+        return g_rrr_tables.blocks[g_rrr_tables.class_begin[k] + offset];
+    }
+
+    // Number of ones (zeros) before super block
+    template <bool BitV>
+    size_t GetSblkRank(size_t i_sblk) const noexcept {
+        const size_t rank = Sblks()[i_sblk].rank;
+        return BitV ? rank : i_sblk * c_sblk_bit_size - rank;
+    }
+
+    template <bool BitV>
+    size_t Select(size_t rank) const noexcept {
+        // Last super block with rank before it not greater then rank
+        size_t i_sblk_l = 0;
+        size_t i_sblk_r = CalcNumSblk(m_num_blk) - 1;
+        while (i_sblk_l < i_sblk_r) {
+            const size_t i_sblk_mid = (i_sblk_l + i_sblk_r + 1) / 2;
+            if (GetSblkRank<BitV>(i_sblk_mid) <= rank) {
+                i_sblk_l = i_sblk_mid;
+            } else {
+                i_sblk_r = i_sblk_mid - 1;
+            }
+        }
+        rank -= GetSblkRank<BitV>(i_sblk_l);
+
+        size_t i_blk = i_sblk_l * c_sblk_num_blk;
+        size_t offset_pos = Sblks()[i_sblk_l].offset_pos;
+        for (;; ++i_blk) {
+            const size_t k = GetClass(i_blk);
+            const size_t blk_rank = BitV ? k : c_blk_bit_size - k;
+            if (rank < blk_rank) {
+                break;
+            }
+            rank -= blk_rank;
+            offset_pos += g_rrr_tables.offset_bit_len[k];
+        }
+
+        const uint64_t blk = GetBlock(i_blk, offset_pos);
+        return i_blk * c_blk_bit_size + SelectInWord(BitV ? blk : ~blk, rank);
+    }
+
+    SuperBlock* Sblks() noexcept {
+        return (SuperBlock*)(this + 1);
+    }
+    const SuperBlock* Sblks() const noexcept {
+        return (const SuperBlock*)(this + 1);
+    }
+
+    uint64_t* Classes() noexcept {
+        return (uint64_t*)((u8*)this + m_classes_pos);
+    }
+    const uint64_t* Classes() const noexcept {
+        return (const uint64_t*)((const u8*)this + m_classes_pos);
+    }
+
+    u8* Offsets() noexcept {
+        return (u8*)this + m_offsets_pos;
+    }
+    const u8* Offsets() const noexcept {
+        return (const u8*)this + m_offsets_pos;
+    }
+
+private:
+    size_t m_size;
+    size_t m_num_blk;
+    size_t m_classes_pos;
+    size_t m_offsets_pos;
+    size_t m_num_ones = 0;
+
+    // State of SetWord
+    size_t m_num_written_blk = 0;
+    size_t m_offset_write_pos = 0;
+    BlockSplitter m_splitter;
+};
+
+/*
+    Bit vector of wavelet tree node, its kind is chosen by bits: RRR if it is at least
+    c_min_rrr_gain times smaller then BitVectorInterleaved (low entropy, long runs), else
+    BitVectorInterleaved. Chosen bit vector is after header, header takes cache line.
+*/
+class alignas(8) BitVectorHybrid {
+public:
+    using size_t = uint32_t;
+    using Summary = BitVectorRRR::Summary;
+
+    BitVectorHybrid(const Summary& summary)
+        : m_is_rrr{IsRRR(summary)} {
+        if (m_is_rrr) {
+            new (this + 1) BitVectorRRR{summary};
+        } else {
+            new (this + 1) BitVectorInterleaved{summary.Size()};
+        }
+    }
+
+    static size_t CalcOccupiedSize(const Summary& summary) noexcept {
+        const size_t bv_size = IsRRR(summary)
+                                   ? BitVectorRRR::CalcOccupiedSize(summary)
+                                   : BitVectorInterleaved::CalcOccupiedSize(summary.Size());
+        return AlignPos(sizeof(BitVectorHybrid) + bv_size, 64);
+    }
+
+    bool IsRRR() const noexcept {
+        return m_is_rrr;
+    }
+
+    size_t Size() const noexcept {
+        return m_is_rrr ? RRR().Size() : Plain().Size();
+    }
+
+    void SetWord(size_t i_word, uint64_t word) noexcept {
+        m_is_rrr ? RRR().SetWord(i_word, word) : Plain().SetWord(i_word, word);
+    }
+
+    void Reinit() noexcept {
+        m_is_rrr ? RRR().Reinit() : Plain().Reinit();
+    }
+
+    bool Get(size_t pos) const noexcept {
+        return m_is_rrr ? RRR().Get(pos) : Plain().Get(pos);
+    }
+
+    void Prefetch(size_t pos) const noexcept {
+        m_is_rrr ? RRR().Prefetch(pos) : Plain().Prefetch(pos);
+    }
+
+    size_t GetRank(size_t pos) const noexcept {
+        return m_is_rrr ? RRR().GetRank(pos) : Plain().GetRank(pos);
+    }
+
+    size_t Select1(size_t rank) const noexcept {
+        return m_is_rrr ? RRR().Select1(rank) : Plain().Select1(rank);
+    }
+    size_t Select0(size_t rank) const noexcept {
+        return m_is_rrr ? RRR().Select0(rank) : Plain().Select0(rank);
+    }
+
+private:
+    constexpr static size_t c_min_rrr_gain = 2;
+
+    static bool IsRRR(const Summary& summary) noexcept {
+        return c_min_rrr_gain * BitVectorRRR::CalcOccupiedSize(summary) <=
+               BitVectorInterleaved::CalcOccupiedSize(summary.Size());
+    }
+
+    BitVectorRRR& RRR() noexcept {
+        return *(BitVectorRRR*)(this + 1);
+    }
+    const BitVectorRRR& RRR() const noexcept {
+        return *(const BitVectorRRR*)(this + 1);
+    }
+
+    BitVectorInterleaved& Plain() noexcept {
+        return *(BitVectorInterleaved*)(this + 1);
+    }
+    const BitVectorInterleaved& Plain() const noexcept {
+        return *(const BitVectorInterleaved*)(this + 1);
+    }
+
+private:
+    bool m_is_rrr;
+    u8 m_reserved[63];
+};
+static_assert(sizeof(BitVectorHybrid) == 64);
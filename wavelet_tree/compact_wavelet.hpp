@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "wavelet_matrix.hpp"
+#include "wavelet_tree.hpp"
+
+/*
+    Wavelet matrix or tree over dense codes of observed symbols: symbols of text are sorted and
+    numbered, so number of levels depends on number of distinct symbols instead of alphabet size.
+    Order of symbols is kept, so prefix of symbol is range of codes. Sorted symbols are kept before
+    wavelet structure.
+*/
+template <typename WaveletT>
+class alignas(8) BasicCompactWavelet {
+public:
+    using size_t = uint32_t;
+
+    // Queries of one GetFirstRanks
+    constexpr static std::size_t c_max_fused_queries = 16;
+
+    class BuildInfo {
+    public:
+        BuildInfo(std::vector<size_t> symbs, size_t wavelet_pos,
+                  typename WaveletT::BuildInfo wavelet_build_info)
+            : m_symbs{std::move(symbs)}
+            , m_wavelet_pos{wavelet_pos}
+            , m_wavelet_build_info{std::move(wavelet_build_info)} {}
+
+        size_t CalcOccupiedSize() const noexcept {
+            return m_wavelet_pos + m_wavelet_build_info.CalcOccupiedSize();
+        }
+
+        const std::vector<size_t>& GetSymbs() const noexcept {
+            return m_symbs;
+        }
+
+        size_t GetWaveletPos() const noexcept {
+            return m_wavelet_pos;
+        }
+
+        const typename WaveletT::BuildInfo& GetWaveletBuildInfo() const noexcept {
+            return m_wavelet_build_info;
+        }
+
+    private:
+        std::vector<size_t> m_symbs;
+        size_t m_wavelet_pos;
+        typename WaveletT::BuildInfo m_wavelet_build_info;
+    };
+
+    template <typename NumberAccessorT>
+    static BuildInfo PrepareBuild(const NumberAccessorT& text, size_t alph_size) {
+        std::vector<bool> is_observed(alph_size);
+        for (std::size_t i = 0; i < text.Size(); ++i) {
+            assert(text[i] < alph_size);
+            is_observed[text[i]] = true;
+        }
+
+        std::vector<size_t> symbs;
+        for (size_t symb = 0; symb < alph_size; ++symb) {
+            if (is_observed[symb]) {
+                symbs.push_back(symb);
+            }
+        }
+
+        const size_t wavelet_pos =
+            AlignPos(sizeof(BasicCompactWavelet) + symbs.size() * sizeof(size_t), 64);
+        auto wavelet_build_info =
+            WaveletT::PrepareBuild(CodeAccessor{text, CalcCodes(symbs, alph_size)},
+                                   CalcCodeAlphSize(symbs.size()));
+
+        return {std::move(symbs), wavelet_pos, std::move(wavelet_build_info)};
+    }
+
+    template <typename NumberAccessorT>
+    BasicCompactWavelet(const NumberAccessorT& text, size_t alph_size, const BuildInfo& build_info)
+        : m_num_levels{Log2Up(alph_size - 1)}
+        , m_num_symbs{(size_t)build_info.GetSymbs().size()}
+        , m_wavelet_pos{build_info.GetWaveletPos()} {
+        const auto& symbs = build_info.GetSymbs();
+        std::copy(symbs.begin(), symbs.end(), GetSymbs());
+
+        new (&GetWavelet()) WaveletT{CodeAccessor{text, CalcCodes(symbs, alph_size)},
+                                     CalcCodeAlphSize(m_num_symbs),
+                                     build_info.GetWaveletBuildInfo()};
+    }
+
+    size_t GetRank(size_t val, size_t pos) const {
+        const auto [code, is_finded] = GetCode(val);
+        return is_finded ? GetWavelet().GetRank(code, pos) : 0;
+    }
+
+    // The same as WaveletTree::GetFirstRank, prefix is translated to range of codes
+    // Res: {pos, is_finded}
+    std::pair<size_t, bool> GetFirstRank(size_t val, u8 signif_bit_len, size_t l_pos,
+                                         size_t r_pos) const {
+        const auto [code_begin, code_end] = GetCodeRange(val, signif_bit_len);
+        return GetWavelet().GetFirstRankInRange(code_begin, code_end, l_pos, r_pos);
+    }
+
+    // Arguments of GetFirstRank
+    struct FirstRankQuery {
+        size_t val;
+        u8 signif_bit_len;
+        size_t l_pos;
+        size_t r_pos;
+    };
+
+    // GetFirstRank of several queries (up to c_max_fused_queries), in one fused pass of wavelet
+    // tree, if it has one
+    // Res: {pos, is_finded} of every query
+    void GetFirstRanks(const FirstRankQuery* queries, std::size_t num_queries,
+                       std::pair<size_t, bool>* res) const {
+        assert(num_queries <= c_max_fused_queries);
+
+        if constexpr (requires { typename WaveletT::FirstRankInRangeQuery; }) {
+            typename WaveletT::FirstRankInRangeQuery range_queries[c_max_fused_queries];
+            for (std::size_t i = 0; i < num_queries; ++i) {
+                const auto [code_begin, code_end] =
+                    GetCodeRange(queries[i].val, queries[i].signif_bit_len);
+                range_queries[i] = {code_begin, code_end, queries[i].l_pos, queries[i].r_pos};
+            }
+            GetWavelet().GetFirstRanksInRange(range_queries, num_queries, res);
+        } else {
+            for (std::size_t i = 0; i < num_queries; ++i) {
+                res[i] = GetFirstRank(queries[i].val, queries[i].signif_bit_len, queries[i].l_pos,
+                                      queries[i].r_pos);
+            }
+        }
+    }
+
+    // Position of pos-th val, pos from 0
+    // val - must exist, else UB
+    size_t Select(size_t val, size_t pos) const {
+        return GetWavelet().Select(GetCode(val).first, pos);
+    }
+
+    // Number of distinct symbols of text
+    size_t GetNumSymbs() const noexcept {
+        return m_num_symbs;
+    }
+
+    const WaveletT& GetWavelet() const noexcept {
+        return *(const WaveletT*)((const u8*)this + m_wavelet_pos);
+    }
+
+private:
+    template <typename NumberAccessorT>
+    class CodeAccessor {
+    public:
+        CodeAccessor(const NumberAccessorT& text, const std::vector<size_t>& codes)
+            : m_text{text}
+            , m_codes{codes} {}
+
+        std::size_t Size() const noexcept {
+            return m_text.Size();
+        }
+
+        size_t operator[](std::size_t pos) const {
+            return m_codes[m_text[pos]];
+        }
+
+    private:
+        const NumberAccessorT& m_text;
+        const std::vector<size_t>& m_codes;
+    };
+
+    // Code of every symbol of alphabet, that is observed
+    static std::vector<size_t> CalcCodes(const std::vector<size_t>& symbs, size_t alph_size) {
+        std::vector<size_t> codes(alph_size);
+        for (size_t code = 0; code < symbs.size(); ++code) {
+            codes[symbs[code]] = code;
+        }
+        return codes;
+    }
+
+    // At least one level
+    static size_t CalcCodeAlphSize(size_t num_symbs) noexcept {
+        return std::max<size_t>(num_symbs, 2);
+    }
+
+    // Res: {code, is_finded}
+    std::pair<size_t, bool> GetCode(size_t val) const noexcept {
+        const size_t* symbs = GetSymbs();
+        const size_t* it = std::lower_bound(symbs, symbs + m_num_symbs, val);
+        return {it - symbs, it != symbs + m_num_symbs && *it == val};
+    }
+
+    // Symbols with prefix val of signif_bit_len bits
+    // Res: {code_begin, code_end}
+    std::pair<size_t, size_t> GetCodeRange(size_t val, u8 signif_bit_len) const noexcept {
+        assert(signif_bit_len <= m_num_levels);
+
+        const size_t shift = m_num_levels - signif_bit_len;
+        const uint64_t val_begin = uint64_t(val >> shift) << shift;
+        const uint64_t val_end = val_begin + (uint64_t{1} << shift);
+
+        const size_t* symbs = GetSymbs();
+        return {std::lower_bound(symbs, symbs + m_num_symbs, val_begin) - symbs,
+                std::lower_bound(symbs, symbs + m_num_symbs, val_end) - symbs};
+    }
+
+    size_t* GetSymbs() noexcept {
+        return (size_t*)(this + 1);
+    }
+    const size_t* GetSymbs() const noexcept {
+        return (const size_t*)(this + 1);
+    }
+
+    WaveletT& GetWavelet() noexcept {
+        return *(WaveletT*)((u8*)this + m_wavelet_pos);
+    }
+
+private:
+    size_t m_num_levels;  // Of original alphabet
+    size_t m_num_symbs;
+    size_t m_wavelet_pos;
+};
+
+using CompactWaveletMatrix = BasicCompactWavelet<WaveletMatrix>;
+using CompactWaveletTree = BasicCompactWavelet<WaveletTree>;
@@ -2,6 +2,11 @@
 
 #include <cstdio>
 #include <stdexcept>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 #include "../common/common_type.h"
 #include "../common/help_func.h"
@@ -27,11 +32,31 @@ public:
         chank_t word = misalign_load<chank_t>(Data() + byte_pos);
         word = Revert(word);
 
-        auto l_shift = bit_pos % 8;
-        auto r_shift = 8 * sizeof(chank_t) - l_shift - m_bit_len;
-        word <<= l_shift;
-        word >>= (l_shift + r_shift);
-        return word;
+        auto r_shift = 8 * sizeof(chank_t) - bit_pos % 8 - m_bit_len;
+        return ExtractLow(word >> r_shift, m_bit_len);
+    }
+
+    // Get of [pos_begin, pos_end) to res by sequential scan: bits are read by 32 to 64-bit
+    // window, number is taken from its high bits
+    void DecodeRange(std::size_t pos_begin, std::size_t pos_end, chank_t* res) const noexcept {
+        const std::size_t bit_pos = m_bit_len * pos_begin;
+        const u8* data = Data() + bit_pos / 8;
+
+        uint64_t window = Revert(misalign_load<uint64_t>(data)) << (bit_pos % 8);
+        std::size_t num_bits = 64 - bit_pos % 8;
+        data += sizeof(uint64_t);
+
+        for (std::size_t pos = pos_begin; pos < pos_end; ++pos) {
+            if (num_bits < m_bit_len) {
+                window |= uint64_t(Revert(misalign_load<chank_t>(data))) << (32 - num_bits);
+                num_bits += 32;
+                data += sizeof(chank_t);
+            }
+
+            *res++ = window >> (64 - m_bit_len);
+            window <<= m_bit_len;
+            num_bits -= m_bit_len;
+        }
     }
 
     void Set(std::size_t pos, chank_t value) noexcept {
@@ -53,14 +78,11 @@ public:
         misalign_store<chank_t>(Data() + byte_pos, word);
     }
 
-    void Dump() const noexcept {
-        for (std::size_t i = 0; i < m_size * m_bit_len; ++i) {
-            u8 byte = Data()[i / 8];
-            u8 bit = !!(byte & (0b1000'0000 >> (i % 8)));
-            if (i && !(i % m_bit_len)) {
-                putchar('\'');
-            }
-            printf("%hhu", bit);
+    void Dump() const {
+        std::vector<chank_t> nums(m_size);
+        DecodeRange(0, m_size, nums.data());
+        for (std::size_t i = 0; i < m_size; ++i) {
+            printf(i ? " %u" : "%u", nums[i]);
         }
         putchar('\n');
     }
@@ -72,16 +94,25 @@ public:
 
 private:
     static chank_t Revert(chank_t word) noexcept {
-        u8* bytes = (u8*)&word;
-        for (u8 i = 0; i < sizeof(word) / 2; ++i) {
-            std::swap(bytes[i], bytes[sizeof(word) - 1 - i]);
-        }
-        return word;
+        return __builtin_bswap32(word);
+    }
+    static uint64_t Revert(uint64_t word) noexcept {
+        return __builtin_bswap64(word);
+    }
+
+    // Low bit_len bits of word
+    static chank_t ExtractLow(chank_t word, u8 bit_len) noexcept {
+#if defined(__BMI2__)
+        return _bzhi_u32(word, bit_len);
+#else
+        return word & ((chank_t{1} << bit_len) - 1);
+#endif
     }
 
+    // Number is read by one chank_t load from byte with number begin
     static u8 GetAlignedNumberBitLen(u8 number_bit_len) {
         constexpr u8 min_size = 9;
-        constexpr u8 max_size = 15;
+        constexpr u8 max_size = 8 * sizeof(chank_t) - 7;
 
         if (number_bit_len > max_size) {
             throw std::invalid_argument{"number_bit_len is too large!"};
@@ -90,8 +121,9 @@ private:
         return std::max(min_size, number_bit_len);
     }
 
+    // Padding for loads of the last number and of DecodeRange
     static std::size_t CalcBufSize(u8 aligned_number_bit_len, std::size_t size) {
-        return sizeof(chank_t) + DivUp(aligned_number_bit_len * size, 8);
+        return sizeof(uint64_t) + sizeof(chank_t) + DivUp(aligned_number_bit_len * size, 8);
     }
 
     const u8* Data() const noexcept {
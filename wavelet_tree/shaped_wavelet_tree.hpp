@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "wavelet_tree.hpp"
+
+/*
+    Wavelet tree shaped by frequencies of symbols: range of symbols of node is split in two ranges
+    of nearly equal weight, so symbol of frequency f is at depth about log(n / f) + 1 (weight
+    balanced alphabetic tree, near to Hu-Tucker). Order of symbols is kept, so prefix of symbol is
+    range of leaves. Only symbols of text are in tree.
+
+    Node keeps the least symbol of right child, its bit vector and children. Leaf is reference
+    with c_leaf_flag and symbol.
+*/
+template <typename BitVectorT>
+class alignas(8) BasicShapedWaveletTree {
+public:
+    using size_t = uint32_t;
+
+    PACKED_STRUCT Node {
+        size_t bv_pos;
+        size_t split_val;
+        size_t childs[2];
+    };
+
+    class BuildInfo {
+    public:
+        BuildInfo(std::vector<Node> nodes, size_t root, size_t occup_size, double mean_depth)
+            : m_nodes{std::move(nodes)}
+            , m_root{root}
+            , m_occup_size{occup_size}
+            , m_mean_depth{mean_depth} {}
+
+        size_t CalcOccupiedSize() const noexcept {
+            return m_occup_size;
+        }
+
+        const std::vector<Node>& GetNodes() const noexcept {
+            return m_nodes;
+        }
+
+        size_t GetRoot() const noexcept {
+            return m_root;
+        }
+
+        // Mean number of bit vectors of rank, weighted by frequencies
+        double GetMeanDepth() const noexcept {
+            return m_mean_depth;
+        }
+
+    private:
+        std::vector<Node> m_nodes;
+        size_t m_root;
+        size_t m_occup_size;
+        double m_mean_depth;
+    };
+
+    template <typename NumberAccessorT>
+    static BuildInfo PrepareBuild(const NumberAccessorT& text, size_t alph_size) {
+        const auto symb_freq = CalcSymbFreq(text, alph_size);
+
+        std::vector<size_t> symbs;
+        std::vector<uint64_t> freq_prefix_sums{0};
+        for (size_t symb = 0; symb < symb_freq.size(); ++symb) {
+            if (symb_freq[symb]) {
+                symbs.push_back(symb);
+                freq_prefix_sums.push_back(freq_prefix_sums.back() + symb_freq[symb]);
+            }
+        }
+        if (symbs.empty()) {
+            symbs.push_back(0);
+            freq_prefix_sums.push_back(0);
+        }
+
+        // Nodes in preorder, bit vector sizes are in place of positions
+        std::vector<Node> nodes;
+        uint64_t sum_depth = 0;
+        auto build = [&](auto& self, size_t i_begin, size_t i_end, size_t depth) -> size_t {
+            if (i_end - i_begin == 1) {
+                sum_depth += depth * (freq_prefix_sums[i_end] - freq_prefix_sums[i_begin]);
+                return c_leaf_flag | symbs[i_begin];
+            }
+
+            // Split with the most equal weights, both parts are not empty
+            const uint64_t weight_sum = freq_prefix_sums[i_begin] + freq_prefix_sums[i_end];
+            auto calc_imbalance = [&](size_t i_split) {
+                return std::abs(int64_t(2 * freq_prefix_sums[i_split]) - int64_t(weight_sum));
+            };
+            size_t i_split = std::lower_bound(freq_prefix_sums.begin() + i_begin + 1,
+                                              freq_prefix_sums.begin() + i_end - 1,
+                                              (weight_sum + 1) / 2) -
+                             freq_prefix_sums.begin();
+            if (i_split > i_begin + 1 && calc_imbalance(i_split - 1) < calc_imbalance(i_split)) {
+                --i_split;
+            }
+
+            // Children are set after their subtrees
+            const size_t i_node = nodes.size();
+            nodes.push_back({size_t(freq_prefix_sums[i_end] - freq_prefix_sums[i_begin]),
+                             symbs[i_split],
+                             {0, 0}});
+
+            const size_t left = self(self, i_begin, i_split, depth + 1);
+            const size_t right = self(self, i_split, i_end, depth + 1);
+            nodes[i_node].childs[0] = left;
+            nodes[i_node].childs[1] = right;
+
+            return i_node;
+        };
+        const size_t root = build(build, 0, symbs.size(), 0);
+
+        // Bit vectors are aligned by cache line
+        size_t bv_pos = sizeof(BasicShapedWaveletTree) + nodes.size() * sizeof(Node);
+        bv_pos = AlignPos(bv_pos, 64);
+        for (auto& node : nodes) {
+            const size_t bv_size = node.bv_pos;
+            node.bv_pos = bv_pos;
+            bv_pos += BitVectorT::CalcOccupiedSize(bv_size);
+        }
+        const size_t occup_size = AlignPos(bv_pos);
+
+        const double mean_depth = text.Size() ? double(sum_depth) / text.Size() : 0;
+
+        std::cout << "num nodes: " << nodes.size() << ", "
+                  << "mean depth: " << mean_depth << ", "
+                  << "occ size: " << occup_size / 1000'000 << std::endl;
+
+        return {std::move(nodes), root, occup_size, mean_depth};
+    }
+
+    template <typename NumberAccessorT>
+    BasicShapedWaveletTree(const NumberAccessorT& text, size_t alph_size,
+                           const BuildInfo& build_info)
+        : m_num_bits{Log2Up(alph_size - 1)}
+        , m_root{build_info.GetRoot()} {
+        const auto& nodes = build_info.GetNodes();
+        std::copy(nodes.begin(), nodes.end(), GetNodes());
+
+        // Bit vector size of node is number of symbols of its subtree
+        const auto text_size = text.Size();
+        std::vector<size_t> bv_sizes(nodes.size());
+        for (size_t i = 0; i < text_size; ++i) {
+            for (size_t ref = m_root; !IsLeaf(ref);) {
+                const bool bit = text[i] >= nodes[ref].split_val;
+                ++bv_sizes[ref];
+                ref = nodes[ref].childs[bit];
+            }
+        }
+        for (size_t i_node = 0; i_node < nodes.size(); ++i_node) {
+            new (GetBitVectorPtr(i_node)) BitVectorT{bv_sizes[i_node]};
+        }
+
+        std::vector<size_t> in_bv_pos(nodes.size());
+        for (size_t i = 0; i < text_size; ++i) {
+            const auto val = text[i];
+            for (size_t ref = m_root; !IsLeaf(ref);) {
+                const bool bit = val >= nodes[ref].split_val;
+                GetBitVector(ref).Set(in_bv_pos[ref]++, bit);
+                ref = nodes[ref].childs[bit];
+            }
+        }
+
+        for (size_t i_node = 0; i_node < nodes.size(); ++i_node) {
+            GetBitVector(i_node).Reinit();
+        }
+    }
+
+    size_t GetRank(size_t val, size_t pos) const {
+        size_t ref = m_root;
+        for (; !IsLeaf(ref) && pos;) {
+            const Node& node = GetNodes()[ref];
+            const bool bit = val >= node.split_val;
+
+            const size_t one_rank = GetBitVector(ref).GetRank(pos);
+            pos = bit ? one_rank : pos - one_rank;
+
+            ref = node.childs[bit];
+        }
+
+        return !pos || GetLeafSymb(ref) == val ? pos : 0;
+    }
+
+    // The same as WaveletTree::GetFirstRank: first position in [l_pos, r_pos) of the least symbol
+    // with first signif_bit_len bits of val
+    // Res: {pos, is_finded}
+    std::pair<size_t, bool> GetFirstRank(size_t val, u8 signif_bit_len, size_t l_pos,
+                                         size_t r_pos) const {
+        assert(signif_bit_len <= m_num_bits);
+
+        const size_t shift = m_num_bits - signif_bit_len;
+        const uint64_t val_begin = uint64_t(val >> shift) << shift;
+        return GetFirstRankInRange(val_begin, val_begin + (uint64_t{1} << shift), l_pos, r_pos);
+    }
+
+    // First position in [l_pos, r_pos) of the least symbol of [val_begin, val_end)
+    // Res: {pos, is_finded}
+    std::pair<size_t, bool> GetFirstRankInRange(uint64_t val_begin, uint64_t val_end, size_t l_pos,
+                                                size_t r_pos) const {
+        return FindLeast(m_root, 0, uint64_t{1} << 32, val_begin, val_end, l_pos, r_pos);
+    }
+
+    // Position of pos-th val, pos from 0
+    // val - must exist, else UB
+    size_t Select(size_t val, size_t pos) const {
+        size_t path[c_max_depth];
+        size_t depth = 0;
+        for (size_t ref = m_root; !IsLeaf(ref); ++depth) {
+            assert(depth < c_max_depth);
+            path[depth] = ref;
+            ref = GetNodes()[ref].childs[val >= GetNodes()[ref].split_val];
+        }
+
+        while (depth--) {
+            const size_t ref = path[depth];
+            const auto& bv = GetBitVector(ref);
+            pos = val >= GetNodes()[ref].split_val ? bv.Select1(pos) : bv.Select0(pos);
+        }
+
+        return pos;
+    }
+
+private:
+    constexpr static size_t c_leaf_flag = size_t{1} << 31;
+
+    // Depth of weight balanced tree is less then log(n) + 2
+    constexpr static size_t c_max_depth = 8 * sizeof(size_t) + 2;
+
+    static bool IsLeaf(size_t ref) noexcept {
+        return ref & c_leaf_flag;
+    }
+
+    static size_t GetLeafSymb(size_t ref) noexcept {
+        return ref & ~c_leaf_flag;
+    }
+
+    // Symbols of ref are in [val_lo, val_hi), [l_pos, r_pos) - range of sequence of ref.
+    // Res: {pos in sequence of ref, is_finded}
+    std::pair<size_t, bool> FindLeast(size_t ref, uint64_t val_lo, uint64_t val_hi,
+                                      uint64_t val_begin, uint64_t val_end, size_t l_pos,
+                                      size_t r_pos) const {
+        if (l_pos == r_pos || val_hi <= val_begin || val_end <= val_lo) {
+            return {};
+        }
+
+        if (IsLeaf(ref)) {
+            const size_t symb = GetLeafSymb(ref);
+            return {l_pos, val_begin <= symb && symb < val_end};
+        }
+
+        const Node& node = GetNodes()[ref];
+        const auto& bv = GetBitVector(ref);
+        const size_t l_one_rank = bv.GetRank(l_pos);
+        const size_t r_one_rank = bv.GetRank(r_pos);
+
+        auto res = FindLeast(node.childs[0], val_lo, node.split_val, val_begin, val_end,
+                             l_pos - l_one_rank, r_pos - r_one_rank);
+        if (res.second) {
+            return {bv.Select0(res.first), true};
+        }
+
+        res = FindLeast(node.childs[1], node.split_val, val_hi, val_begin, val_end, l_one_rank,
+                        r_one_rank);
+        if (res.second) {
+            return {bv.Select1(res.first), true};
+        }
+
+        return {};
+    }
+
+    Node* GetNodes() noexcept {
+        return (Node*)(this + 1);
+    }
+    const Node* GetNodes() const noexcept {
+        return (const Node*)(this + 1);
+    }
+
+    BitVectorT* GetBitVectorPtr(size_t i_node) noexcept {
+        return (BitVectorT*)((u8*)this + GetNodes()[i_node].bv_pos);
+    }
+
+    BitVectorT& GetBitVector(size_t i_node) noexcept {
+        return *GetBitVectorPtr(i_node);
+    }
+    const BitVectorT& GetBitVector(size_t i_node) const noexcept {
+        return *(const BitVectorT*)((const u8*)this + GetNodes()[i_node].bv_pos);
+    }
+
+private:
+    size_t m_num_bits;  // Of original alphabet
+    size_t m_root;
+};
+
+using ShapedWaveletTree = BasicShapedWaveletTree<BitVectorInterleaved>;
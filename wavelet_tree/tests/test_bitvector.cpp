@@ -40,14 +40,18 @@ TEST(BV, MANUAL) {
     BitVectorBuffer bv_buf{bv_size};
     auto& bv = *new (bv_buf.Data()) BitVector{bv_size};
     test(bv);
+
+    BitVectorBuffer<BitVectorInterleaved> bv_inter_buf{bv_size};
+    auto& bv_inter = *new (bv_inter_buf.Data()) BitVectorInterleaved{bv_size};
+    test(bv_inter);
 }
 
-TEST(BV, RANDOM) {
+template <typename BitVectorT>
+void TestRandom(BitVector::size_t bv_size_max) {
     const unsigned seed = 0xEDA + 0xDED * 32;
     std::mt19937_64 gen{seed};
 
     const std::size_t bv_size_min = 1;
-    const std::size_t bv_size_max = 2000;
     std::size_t num_repeats = 100;
 
     std::uniform_int_distribution<BitVector::size_t> bv_size_distrib{bv_size_min, bv_size_max};
@@ -60,8 +64,8 @@ TEST(BV, RANDOM) {
 
         BitVectorNaive bv_naive{bv_size};
 
-        BitVectorBuffer bv_buf{bv_size};
-        auto& bv = *new (bv_buf.Data()) BitVector{bv_size};
+        BitVectorBuffer<BitVectorT> bv_buf{bv_size};
+        auto& bv = *new (bv_buf.Data()) BitVectorT{bv_size};
         auto num_set = num_set_distrib(gen);
         while (num_set--) {
             const auto pos = pos_distrib(gen);
@@ -81,6 +85,86 @@ TEST(BV, RANDOM) {
     }
 }
 
+TEST(BV, RANDOM) {
+    TestRandom<BitVector>(2000);
+}
+
+TEST(BV, INTERLEAVED_RANDOM) {
+    TestRandom<BitVectorInterleaved>(5000);
+}
+
+TEST(BV, SELECT_RANDOM) {
+    std::mt19937_64 gen{0xDED};
+
+    for (BitVector::size_t bv_size : {1u, 63u, 448u, 449u, 4096u, 100'000u}) {
+        // Sparse, even and dense bit vectors
+        for (unsigned one_prob : {1u, 50u, 99u}) {
+            BitVectorBuffer<BitVectorInterleaved> bv_buf{bv_size};
+            auto& bv = *new (bv_buf.Data()) BitVectorInterleaved{bv_size};
+
+            std::vector<std::size_t> ones, zeros;
+            for (std::size_t i = 0; i < bv_size; ++i) {
+                const bool value = gen() % 100 < one_prob;
+                bv.Set(i, value);
+                (value ? ones : zeros).push_back(i);
+            }
+            bv.Reinit();
+
+            for (std::size_t rank = 0; rank < ones.size(); ++rank) {
+                ASSERT_EQ(bv.Select1(rank), ones[rank]) << "rank: " << rank;
+            }
+            for (std::size_t rank = 0; rank < zeros.size(); ++rank) {
+                ASSERT_EQ(bv.Select0(rank), zeros[rank]) << "rank: " << rank;
+            }
+        }
+    }
+}
+
+TEST(BV, SET_WORD) {
+    auto test = [](auto& bv, std::mt19937_64& gen) {
+        std::vector<bool> bits(bv.Size());
+        for (std::size_t i_word = 0; 64 * i_word < bv.Size(); ++i_word) {
+            uint64_t word = gen();
+            if (bv.Size() - 64 * i_word < 64) {
+                word &= (uint64_t{1} << (bv.Size() - 64 * i_word)) - 1;
+            }
+            bv.SetWord(i_word, word);
+
+            const std::size_t i_end = std::min<std::size_t>(bv.Size(), 64 * i_word + 64);
+            for (std::size_t i = 64 * i_word; i < i_end; ++i) {
+                bits[i] = (word >> (i % 64)) & 1u;
+            }
+        }
+        bv.Reinit();
+
+        std::size_t rank = 0;
+        for (std::size_t i = 0; i < bv.Size(); ++i) {
+            ASSERT_EQ(bv.Get(i), bits[i]) << i;
+            ASSERT_EQ(bv.GetRank(i), rank) << i;
+            rank += bits[i];
+        }
+    };
+
+    std::mt19937_64 gen{0x5E7};
+    for (BitVector::size_t bv_size : {1u, 64u, 100u, 448u, 1000u}) {
+        BitVectorBuffer bv_buf{bv_size};
+        auto& bv = *new (bv_buf.Data()) BitVector{bv_size};
+        test(bv, gen);
+
+        BitVectorBuffer<BitVectorInterleaved> bv_inter_buf{bv_size};
+        auto& bv_inter = *new (bv_inter_buf.Data()) BitVectorInterleaved{bv_size};
+        test(bv_inter, gen);
+    }
+}
+
+TEST(BV, SELECT_IN_WORD) {
+    ASSERT_EQ(SelectInWord(1, 0), 0);
+    ASSERT_EQ(SelectInWord(0b1010, 1), 3);
+    ASSERT_EQ(SelectInWord(~uint64_t{0}, 63), 63);
+    ASSERT_EQ(SelectInWord(uint64_t{1} << 63 | 1, 1), 63);
+    ASSERT_EQ(SelectInWord(0xF0F0'0000'0000'0000, 4), 60);
+}
+
 TEST(BV, GET_RANK_SPEED) {
     auto now = [] {
         return std::chrono::high_resolution_clock::now();
@@ -104,6 +188,9 @@ TEST(BV, GET_RANK_SPEED) {
     BitVectorBuffer bv_buf{bv_size};
     auto& bv = *new (bv_buf.Data()) BitVector{bv_size};
 
+    BitVectorBuffer<BitVectorInterleaved> bv_inter_buf{bv_size};
+    auto& bv_inter = *new (bv_inter_buf.Data()) BitVectorInterleaved{bv_size};
+
     const std::size_t seed = 0xDED;
     std::mt19937_64 gen{seed};
     std::uniform_int_distribution<std::size_t> pos_distrib{0, bv_size - 1};
@@ -112,10 +199,12 @@ TEST(BV, GET_RANK_SPEED) {
         const auto pos = pos_distrib(gen);
         bv_naive.Set(pos, true);
         bv.Set(pos, true);
+        bv_inter.Set(pos, true);
     }
 
     bv_naive.Reinit();
     bv.Reinit();
+    bv_inter.Reinit();
 
     auto rank_linear = [](auto& bv) {
         auto size = bv.Size();
@@ -128,19 +217,23 @@ TEST(BV, GET_RANK_SPEED) {
         return sum_rank;
     };
 
-    std::size_t bv_naive_time_us = 0, bv_time_us = 0;
+    std::size_t bv_naive_time_us = 0, bv_time_us = 0, bv_inter_time_us = 0;
     std::size_t num_repeats = 2;
     for (int i = 0; i < num_repeats; ++i) {
-        std::size_t res_naive = 0, res = 0;
+        std::size_t res_naive = 0, res = 0, res_inter = 0;
         bv_naive_time_us += exec_time(res_naive, rank_linear, bv_naive);
         bv_time_us += exec_time(res, rank_linear, bv);
+        bv_inter_time_us += exec_time(res_inter, rank_linear, bv_inter);
 
         ASSERT_EQ(res, res_naive);
+        ASSERT_EQ(res_inter, res_naive);
     }
     bv_naive_time_us /= num_repeats;
     bv_time_us /= num_repeats;
+    bv_inter_time_us /= num_repeats;
 
     ASSERT_LT(100 * bv_time_us, bv_naive_time_us);
+    ASSERT_LT(100 * bv_inter_time_us, bv_naive_time_us);
 
     // std::cout << "bv_naive_time_us: " << bv_naive_time_us << std::endl;
     // std::cout << "bv_time_us: " << bv_time_us << std::endl;
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "bitvector_rrr.hpp"
+
+namespace {
+
+// Bits in words, as in wavelet tree build
+std::vector<uint64_t> ToWords(const std::vector<bool>& bits) {
+    std::vector<uint64_t> words(DivUp(bits.size(), 64));
+    for (std::size_t i = 0; i < bits.size(); ++i) {
+        words[i / 64] |= uint64_t(bits[i]) << (i % 64);
+    }
+    return words;
+}
+
+template <typename BitVectorT>
+void TestBits(const std::vector<bool>& bits) {
+    const auto words = ToWords(bits);
+
+    typename BitVectorT::Summary summary{BitVectorRRR::size_t(bits.size())};
+    for (auto word : words) {
+        summary.AddWord(word);
+    }
+
+    std::vector<u8> buf(BitVectorT::CalcOccupiedSize(summary));
+    auto& bv = *new (buf.data()) BitVectorT{summary};
+    for (std::size_t i_word = 0; i_word < words.size(); ++i_word) {
+        bv.SetWord(i_word, words[i_word]);
+    }
+    bv.Reinit();
+
+    ASSERT_EQ(bv.Size(), bits.size());
+
+    std::size_t rank = 0;
+    std::vector<std::size_t> ones, zeros;
+    for (std::size_t i = 0; i < bits.size(); ++i) {
+        ASSERT_EQ(bv.Get(i), bits[i]) << i;
+        ASSERT_EQ(bv.GetRank(i), rank) << i;
+        rank += bits[i];
+        (bits[i] ? ones : zeros).push_back(i);
+    }
+    ASSERT_EQ(bv.GetRank(bits.size()), rank);
+
+    for (std::size_t i = 0; i < ones.size(); ++i) {
+        ASSERT_EQ(bv.Select1(i), ones[i]) << i;
+    }
+    for (std::size_t i = 0; i < zeros.size(); ++i) {
+        ASSERT_EQ(bv.Select0(i), zeros[i]) << i;
+    }
+}
+
+}  // namespace
+
+TEST(BV_RRR, TABLES) {
+    ASSERT_EQ(g_rrr_tables.offset_bit_len[0], 0);
+    ASSERT_EQ(g_rrr_tables.offset_bit_len[1], 4);
+    ASSERT_EQ(g_rrr_tables.offset_bit_len[7], 13);
+    ASSERT_EQ(g_rrr_tables.offset_bit_len[15], 0);
+
+    for (uint block = 0; block < (1u << 15); ++block) {
+        const uint k = std::popcount(block);
+        ASSERT_EQ(g_rrr_tables.blocks[g_rrr_tables.class_begin[k] + g_rrr_tables.offsets[block]],
+                  block);
+    }
+}
+
+TEST(BV_RRR, RANDOM) {
+    std::mt19937_64 gen{0x4442};
+
+    for (std::size_t size : {0u, 1u, 15u, 64u, 480u, 481u, 5000u, 100'000u}) {
+        // Sparse, even, dense bits and runs
+        for (unsigned one_prob : {1u, 50u, 99u}) {
+            std::vector<bool> bits(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                bits[i] = gen() % 100 < one_prob;
+            }
+            TestBits<BitVectorRRR>(bits);
+            TestBits<BitVectorHybrid>(bits);
+        }
+
+        std::vector<bool> runs(size);
+        for (std::size_t i = 0; i < size;) {
+            const std::size_t run_len = 1 + gen() % 200;
+            const bool bit = gen() % 2;
+            for (std::size_t j = 0; j < run_len && i < size; ++j) {
+                runs[i++] = bit;
+            }
+        }
+        TestBits<BitVectorRRR>(runs);
+        TestBits<BitVectorHybrid>(runs);
+    }
+}
+
+TEST(BV_RRR, HYBRID_KIND) {
+    auto make_summary = [](const std::vector<bool>& bits) {
+        BitVectorHybrid::Summary summary{BitVectorHybrid::size_t(bits.size())};
+        for (auto word : ToWords(bits)) {
+            summary.AddWord(word);
+        }
+        return summary;
+    };
+
+    std::mt19937_64 gen{0x4B1D};
+    std::vector<bool> random(100'000), runs(100'000);
+    for (std::size_t i = 0; i < random.size(); ++i) {
+        random[i] = gen() % 2;
+        runs[i] = i / 1000 % 2;
+    }
+
+    for (const auto* bits : {&random, &runs}) {
+        const auto summary = make_summary(*bits);
+        std::vector<u8> buf(BitVectorHybrid::CalcOccupiedSize(summary));
+        const auto& bv = *new (buf.data()) BitVectorHybrid{summary};
+        ASSERT_EQ(bv.IsRRR(), bits == &runs);
+    }
+}
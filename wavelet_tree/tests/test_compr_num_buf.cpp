@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <random>
+#include <vector>
+
 #include "../compr_num_buf.hpp"
 
 TEST(COMPR_NUM_BUF, MANUAL) {
@@ -34,4 +37,38 @@ TEST(COMPR_NUM_BUF, MANUAL) {
             ASSERT_EQ(buf.Get(j), j <= i ? j : 0) << i << " " << j;
         }
     }
-}
\ No newline at end of file
+}
+
+TEST(COMPR_NUM_BUF, RANDOM) {
+    std::mt19937_64 gen{0xC0DE};
+
+    for (u8 bit_len = 9; bit_len <= 25; ++bit_len) {
+        const std::size_t size = 1 + gen() % 1000;
+
+        const auto occup_size = CompressedNumberBuf::CalcOccupiedSize(bit_len, size);
+        std::vector<u8> place(occup_size);
+        auto& buf = *new (place.data()) CompressedNumberBuf{bit_len, size};
+
+        std::vector<CompressedNumberBuf::chank_t> nums(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            nums[i] = gen() & ((1u << bit_len) - 1);
+            buf.Set(i, nums[i]);
+        }
+
+        for (std::size_t i = 0; i < size; ++i) {
+            ASSERT_EQ(buf.Get(i), nums[i]) << int(bit_len) << " " << i;
+        }
+
+        // Ranges from any bit offset
+        for (std::size_t pos_begin : {std::size_t{0}, size / 3, size - 1}) {
+            std::vector<CompressedNumberBuf::chank_t> decoded(size - pos_begin);
+            buf.DecodeRange(pos_begin, size, decoded.data());
+            for (std::size_t i = pos_begin; i < size; ++i) {
+                ASSERT_EQ(decoded[i - pos_begin], nums[i]) << int(bit_len) << " " << i;
+            }
+        }
+    }
+
+    std::vector<u8> place(CompressedNumberBuf::CalcOccupiedSize(25, 1));
+    ASSERT_THROW(new (place.data()) CompressedNumberBuf(26, 1), std::invalid_argument);
+}
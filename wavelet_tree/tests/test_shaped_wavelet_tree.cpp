@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <random>
+
+#include "shaped_wavelet_tree.hpp"
+#include "wavelet_tree.hpp"
+
+namespace {
+
+class TestText : public std::vector<unsigned> {
+public:
+    std::size_t Size() const noexcept {
+        return size();
+    }
+};
+
+}  // namespace
+
+TEST(SHAPED_WAVELET_TREE, MANUAL) {
+    //             0  1   2   3  4   5   6  7   8   9
+    TestText text{{1, 2, 10, 10, 4, 10, 10, 2, 10, 10}};
+
+    auto build_info = ShapedWaveletTree::PrepareBuild(text, 16);
+    std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+    auto& wt = *new (mapped_buf.data()) ShapedWaveletTree{text, 16, build_info};
+
+    // 10 is at depth 1, others at depth 2 or 3
+    ASSERT_LT(build_info.GetMeanDepth(), 2.0);
+
+    ASSERT_EQ(wt.GetRank(0, 1), 0);
+    ASSERT_EQ(wt.GetRank(1, 2), 1);
+    ASSERT_EQ(wt.GetRank(2, 7), 1);
+    ASSERT_EQ(wt.GetRank(2, 8), 2);
+    ASSERT_EQ(wt.GetRank(10, 10), 6);
+    ASSERT_EQ(wt.GetRank(4, 5), 1);
+    ASSERT_EQ(wt.GetRank(12, 10), 0);
+
+    ASSERT_EQ(wt.Select(2, 1), 7);
+    ASSERT_EQ(wt.Select(10, 4), 8);
+    ASSERT_EQ(wt.Select(4, 0), 4);
+
+    using Res = std::pair<ShapedWaveletTree::size_t, bool>;
+    ASSERT_EQ(wt.GetFirstRank(2, 4, 2, 8), Res(7, true));
+    ASSERT_EQ(wt.GetFirstRank(2, 4, 2, 7), Res());
+    ASSERT_EQ(wt.GetFirstRank(0b0010, 2, 3, 10), Res(7, true));
+    ASSERT_EQ(wt.GetFirstRank(0b1000, 1, 0, 10), Res(2, true));
+    ASSERT_EQ(wt.GetFirstRank(0, 0, 2, 7), Res(4, true));
+}
+
+TEST(SHAPED_WAVELET_TREE, RANDOM_AS_WAVELET_TREE) {
+    using size_t = ShapedWaveletTree::size_t;
+
+    std::mt19937_64 gen{0x5EA};
+
+    for (size_t alph_size : {2u, 7u, 64u, 4096u}) {
+        // Skewed frequencies: symbol is less with probability 1/2 at every bit
+        TestText text;
+        text.resize(1 + gen() % 20000);
+        for (auto& symb : text) {
+            symb = std::min<size_t>(std::countr_zero(gen() | (uint64_t{1} << 40)) *
+                                        (gen() % 16 ? 1 : gen() % alph_size),
+                                    alph_size - 1);
+        }
+
+        auto wt_build_info = WaveletTree::PrepareBuild(text, alph_size);
+        std::vector<u8> wt_buf(wt_build_info.CalcOccupiedSize());
+        auto& wt = *new (wt_buf.data()) WaveletTree{text, alph_size, wt_build_info};
+
+        auto build_info = ShapedWaveletTree::PrepareBuild(text, alph_size);
+        std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+        auto& swt = *new (mapped_buf.data()) ShapedWaveletTree{text, alph_size, build_info};
+
+        if (alph_size > 8) {
+            ASSERT_LT(build_info.GetMeanDepth(), Log2Up(alph_size - 1) / 2.0);
+            ASSERT_LT(build_info.CalcOccupiedSize(), wt_build_info.CalcOccupiedSize());
+        }
+
+        std::vector<size_t> symb_ctr(alph_size);
+        for (size_t i = 0; i < text.size(); ++i) {
+            ASSERT_EQ(swt.Select(text[i], symb_ctr[text[i]]++), i);
+        }
+
+        const size_t num_bits = Log2Up(alph_size - 1);
+        for (unsigned i_query = 0; i_query < 2000; ++i_query) {
+            const size_t symb = i_query % 2 ? text[gen() % text.size()] : gen() % alph_size;
+            const size_t l_pos = gen() % (text.size() + 1);
+            const size_t r_pos = l_pos + gen() % (text.size() + 1 - l_pos);
+            const u8 signif_bit_len = gen() % (num_bits + 1);
+
+            ASSERT_EQ(swt.GetRank(symb, r_pos), wt.GetRank(symb, r_pos));
+            ASSERT_EQ(swt.GetFirstRank(symb, signif_bit_len, l_pos, r_pos),
+                      wt.GetFirstRank(symb, signif_bit_len, l_pos, r_pos));
+        }
+    }
+}
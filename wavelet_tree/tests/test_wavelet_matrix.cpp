@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include <random>
+
+#include "compact_wavelet.hpp"
+#include "wavelet_matrix.hpp"
+#include "wavelet_tree.hpp"
+
+namespace {
+
+class TestText : public std::vector<unsigned> {
+public:
+    std::size_t Size() const noexcept {
+        return size();
+    }
+};
+
+}  // namespace
+
+TEST(WAVELET_MATRIX, MANUAL) {
+    //             0  1  2  3   4  5  6  7
+    TestText text{{1, 2, 4, 4, 10, 3, 3, 2}};
+
+    auto build_info = WaveletMatrix::PrepareBuild(text, 16);
+    std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+    ASSERT_THROW(new (mapped_buf.data()) WaveletMatrix(text, 64, build_info),
+                 std::invalid_argument);
+    auto& wm = *new (mapped_buf.data()) WaveletMatrix{text, 16, build_info};
+
+    ASSERT_EQ(wm.GetRank(0, 1), 0);
+    ASSERT_EQ(wm.GetRank(1, 2), 1);
+    ASSERT_EQ(wm.GetRank(2, 7), 1);
+    ASSERT_EQ(wm.GetRank(2, 8), 2);
+    ASSERT_EQ(wm.GetRank(10, 5), 1);
+    ASSERT_EQ(wm.GetRank(12, 8), 0);
+
+    ASSERT_EQ(wm.Select(2, 1), 7);
+    ASSERT_EQ(wm.Select(3, 0), 5);
+    ASSERT_EQ(wm.Select(10, 0), 4);
+
+    using Res = std::pair<WaveletMatrix::size_t, bool>;
+    ASSERT_EQ(wm.GetFirstRank(2, 4, 2, 8), Res(7, true));
+    ASSERT_EQ(wm.GetFirstRank(2, 4, 2, 7), Res());
+    ASSERT_EQ(wm.GetFirstRank(0b0010, 3, 2, 7), Res(5, true));
+}
+
+TEST(WAVELET_MATRIX, RANDOM_AS_WAVELET_TREE) {
+    using size_t = WaveletMatrix::size_t;
+
+    std::mt19937_64 gen{0xEDA + 0xDED};
+
+    for (size_t alph_size : {2u, 7u, 64u, 1000u}) {
+        TestText text;
+        text.resize(1 + gen() % 3000);
+        for (auto& symb : text) {
+            symb = gen() % alph_size;
+        }
+
+        auto wt_build_info = WaveletTree::PrepareBuild(text, alph_size);
+        std::vector<u8> wt_buf(wt_build_info.CalcOccupiedSize());
+        auto& wt = *new (wt_buf.data()) WaveletTree{text, alph_size, wt_build_info};
+
+        auto wm_build_info = WaveletMatrix::PrepareBuild(text, alph_size);
+        std::vector<u8> wm_buf(wm_build_info.CalcOccupiedSize());
+        auto& wm = *new (wm_buf.data()) WaveletMatrix{text, alph_size, wm_build_info};
+
+        std::vector<size_t> symb_ctr(alph_size);
+        for (size_t i = 0; i < text.size(); ++i) {
+            ASSERT_EQ(wm.Select(text[i], symb_ctr[text[i]]++), i);
+        }
+
+        const size_t num_levels = Log2Up(alph_size - 1);
+        for (unsigned i_query = 0; i_query < 1000; ++i_query) {
+            const size_t symb = gen() % alph_size;
+            const size_t l_pos = gen() % (text.size() + 1);
+            const size_t r_pos = l_pos + gen() % (text.size() + 1 - l_pos);
+            const u8 signif_bit_len = gen() % (num_levels + 1);
+
+            ASSERT_EQ(wm.GetRank(symb, r_pos), wt.GetRank(symb, r_pos));
+            ASSERT_EQ(wm.GetFirstRank(symb, signif_bit_len, l_pos, r_pos),
+                      wt.GetFirstRank(symb, signif_bit_len, l_pos, r_pos))
+                << symb << " " << (int)signif_bit_len << " " << l_pos << " " << r_pos;
+        }
+    }
+}
+
+TEST(WAVELET_MATRIX, FIRST_RANK_IN_RANGE) {
+    using size_t = WaveletMatrix::size_t;
+
+    std::mt19937_64 gen{0xDED};
+
+    const size_t alph_size = 100;
+    TestText text;
+    text.resize(2000);
+    for (auto& symb : text) {
+        symb = gen() % alph_size;
+    }
+
+    auto build_info = WaveletMatrix::PrepareBuild(text, alph_size);
+    std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+    auto& wm = *new (mapped_buf.data()) WaveletMatrix{text, alph_size, build_info};
+
+    for (unsigned i_query = 0; i_query < 1000; ++i_query) {
+        const size_t val_begin = gen() % alph_size;
+        const size_t val_end = val_begin + gen() % 20;
+        const size_t l_pos = gen() % text.size();
+        const size_t r_pos = l_pos + gen() % (text.size() - l_pos);
+
+        // The least symbol and its first position
+        std::pair<size_t, bool> ref{};
+        for (size_t i = l_pos; i < r_pos; ++i) {
+            if (val_begin <= text[i] && text[i] < val_end &&
+                (!ref.second || text[i] < text[ref.first])) {
+                ref = {i, true};
+            }
+        }
+
+        ASSERT_EQ(wm.GetFirstRankInRange(val_begin, val_end, l_pos, r_pos), ref);
+    }
+}
+
+TEST(WAVELET_MATRIX, COMPACT_ALPHABET) {
+    using size_t = CompactWaveletMatrix::size_t;
+
+    std::mt19937_64 gen{0xEDA};
+
+    // 4-mers of A, C, T, G with 3-bit codes 1..4, rare TERM
+    const size_t d = 4;
+    const size_t alph_size = 1u << (3 * d);
+    TestText text;
+    text.resize(20000);
+    for (auto& symb : text) {
+        symb = 0;
+        for (size_t i = 0; i < d; ++i) {
+            symb = 8 * symb + (gen() % 1000 ? 1 + gen() % 4 : 0);
+        }
+    }
+
+    auto wm_build_info = WaveletMatrix::PrepareBuild(text, alph_size);
+    std::vector<u8> wm_buf(wm_build_info.CalcOccupiedSize());
+    auto& wm = *new (wm_buf.data()) WaveletMatrix{text, alph_size, wm_build_info};
+
+    auto build_info = CompactWaveletMatrix::PrepareBuild(text, alph_size);
+    std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+    auto& cwm = *new (mapped_buf.data()) CompactWaveletMatrix{text, alph_size, build_info};
+
+    // 12 -> 9 levels
+    ASSERT_LT(5 * build_info.CalcOccupiedSize(), 4 * wm_build_info.CalcOccupiedSize());
+
+    std::vector<size_t> symb_ctr(alph_size);
+    for (size_t i = 0; i < text.size(); ++i) {
+        ASSERT_EQ(cwm.Select(text[i], symb_ctr[text[i]]++), i);
+    }
+
+    for (unsigned i_query = 0; i_query < 2000; ++i_query) {
+        const size_t symb = i_query % 2 ? text[gen() % text.size()] : gen() % alph_size;
+        const size_t l_pos = gen() % (text.size() + 1);
+        const size_t r_pos = l_pos + gen() % (text.size() + 1 - l_pos);
+        const u8 signif_bit_len = 3 * (gen() % (d + 1));
+
+        ASSERT_EQ(cwm.GetRank(symb, r_pos), wm.GetRank(symb, r_pos));
+        ASSERT_EQ(cwm.GetFirstRank(symb, signif_bit_len, l_pos, r_pos),
+                  wm.GetFirstRank(symb, signif_bit_len, l_pos, r_pos));
+    }
+}
+
+TEST(WAVELET_MATRIX, COMPACT_WAVELET_TREE) {
+    using size_t = CompactWaveletTree::size_t;
+    using Res = std::pair<size_t, bool>;
+
+    std::mt19937_64 gen{0xEDB};
+
+    // 6-mers of A, C, T, G with 3-bit codes 1..4, rare TERM: about 4^6 of 8^6 symbols occur
+    const size_t d = 6;
+    const size_t alph_size = 1u << (3 * d);
+    TestText text;
+    text.resize(50000);
+    for (auto& symb : text) {
+        symb = 0;
+        for (size_t i = 0; i < d; ++i) {
+            symb = 8 * symb + (gen() % 1000 ? 1 + gen() % 4 : 0);
+        }
+    }
+
+    auto wm_build_info = WaveletMatrix::PrepareBuild(text, alph_size);
+    std::vector<u8> wm_buf(wm_build_info.CalcOccupiedSize());
+    auto& wm = *new (wm_buf.data()) WaveletMatrix{text, alph_size, wm_build_info};
+
+    auto wt_build_info = WaveletTree::PrepareBuild(text, alph_size);
+    auto build_info = CompactWaveletTree::PrepareBuild(text, alph_size);
+    std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+    auto& cwt = *new (mapped_buf.data()) CompactWaveletTree{text, alph_size, build_info};
+
+    // Bit vectors of all 2^18 nodes -> of 2^13 nodes
+    ASSERT_LT(2 * build_info.CalcOccupiedSize(), wt_build_info.CalcOccupiedSize());
+
+    std::vector<size_t> symb_ctr(alph_size);
+    for (size_t i = 0; i < text.size(); ++i) {
+        ASSERT_EQ(cwt.GetRank(text[i], i), symb_ctr[text[i]]);
+        ASSERT_EQ(cwt.Select(text[i], symb_ctr[text[i]]++), i);
+    }
+
+    for (unsigned i_query = 0; i_query < 1000; ++i_query) {
+        // Queries of offsets k have prefixes of 3 * k bits, as in blocked index
+        CompactWaveletTree::FirstRankQuery queries[d];
+        for (size_t k = 0; k < d; ++k) {
+            const size_t l_pos = gen() % (text.size() + 1);
+            const size_t r_pos = l_pos + std::min<size_t>(text.size() - l_pos, gen() % 100);
+            const size_t val =
+                l_pos != r_pos && k % 2 ? text[l_pos + gen() % (r_pos - l_pos)] : gen() % alph_size;
+            queries[k] = {val, u8(3 * k), l_pos, r_pos};
+        }
+
+        Res res[d];
+        cwt.GetFirstRanks(queries, d, res);
+        for (size_t k = 0; k < d; ++k) {
+            const auto& query = queries[k];
+            const auto ref =
+                wm.GetFirstRank(query.val, query.signif_bit_len, query.l_pos, query.r_pos);
+            ASSERT_EQ(res[k], ref);
+            ASSERT_EQ(cwt.GetFirstRank(query.val, query.signif_bit_len, query.l_pos, query.r_pos),
+                      ref);
+        }
+    }
+}
@@ -44,8 +44,9 @@ TEST(WAVELET_TREE, RANK_MANUAL) {
     test(wt);
 }
 
-TEST(WAVELET_TREE, RANK_RANDOM) {
-    using size_t = WaveletTree::size_t;
+template <typename WaveletTreeT>
+void TestRankRandom() {
+    using size_t = typename WaveletTreeT::size_t;
 
     const unsigned seed = 0xEDA + 0xDED * 64;
     std::mt19937_64 gen{seed};
@@ -74,9 +75,9 @@ TEST(WAVELET_TREE, RANK_RANDOM) {
             text[i] = symb_distrib(gen);
         }
 
-        auto build_info = WaveletTree::PrepareBuild(text, alph_size);
+        auto build_info = WaveletTreeT::PrepareBuild(text, alph_size);
         std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
-        auto& wt = *new (mapped_buf.data()) WaveletTree{text, alph_size, build_info};
+        auto& wt = *new (mapped_buf.data()) WaveletTreeT{text, alph_size, build_info};
 
         WaveletTreeNaive wt_naive{text};
 
@@ -92,20 +93,283 @@ TEST(WAVELET_TREE, RANK_RANDOM) {
     }
 }
 
+TEST(WAVELET_TREE, RANK_RANDOM) {
+    TestRankRandom<WaveletTree>();
+    TestRankRandom<BasicWaveletTree<BitVector>>();
+    TestRankRandom<HybridWaveletTree>();
+}
+
 TEST(WAVELET_TREE, SELECT_MANUAL) {
     //             0  1  2  3   4  5  6  7
     TestText text{{1, 2, 4, 4, 10, 3, 3, 2}};
 
+    for (bool with_select_table : {false, true}) {
+        auto build_info = WaveletTree::PrepareBuild(text, 16, with_select_table);
+        std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+        auto& wt = *new (mapped_buf.data()) WaveletTree{text, 10, build_info};
+
+        ASSERT_EQ(wt.Select(1, 0), 0);
+        ASSERT_EQ(wt.Select(2, 0), 1);
+        ASSERT_EQ(wt.Select(2, 1), 7);
+        ASSERT_EQ(wt.Select(3, 0), 5);
+        ASSERT_EQ(wt.Select(3, 1), 6);
+        ASSERT_EQ(wt.Select(4, 0), 2);
+        ASSERT_EQ(wt.Select(4, 1), 3);
+        ASSERT_EQ(wt.Select(10, 0), 4);
+    }
+}
+
+TEST(WAVELET_TREE, SELECT_RANDOM) {
+    using size_t = WaveletTree::size_t;
+
+    std::mt19937_64 gen{0xEDA};
+
+    for (size_t alph_size : {2u, 5u, 64u, 300u}) {
+        TestText text;
+        text.resize(5000);
+        for (auto& symb : text) {
+            symb = gen() % alph_size;
+        }
+
+        auto build_info = WaveletTree::PrepareBuild(text, alph_size);
+        std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+        auto& wt = *new (mapped_buf.data()) WaveletTree{text, alph_size, build_info};
+
+        auto build_info_table = WaveletTree::PrepareBuild(text, alph_size, true);
+        ASSERT_LT(build_info.CalcOccupiedSize(), build_info_table.CalcOccupiedSize());
+
+        std::vector<size_t> symb_ctr(alph_size);
+        for (size_t i = 0; i < text.size(); ++i) {
+            ASSERT_EQ(wt.Select(text[i], symb_ctr[text[i]]++), i);
+        }
+    }
+}
+
+TEST(WAVELET_TREE, HYBRID_RUNS) {
+    using size_t = WaveletTree::size_t;
+
+    std::mt19937_64 gen{0x11B};
+
+    // Runs of symbols as in BWT of repetitive text
+    const size_t alph_size = 16;
+    TestText text;
+    while (text.size() < 100'000) {
+        text.resize(text.size() + 1 + gen() % 300, gen() % alph_size);
+    }
+
+    auto build_info = WaveletTree::PrepareBuild(text, alph_size);
+    auto hybrid_build_info = HybridWaveletTree::PrepareBuild(text, alph_size);
+    ASSERT_LT(2 * hybrid_build_info.CalcOccupiedSize(), build_info.CalcOccupiedSize());
+
+    std::vector<u8> mapped_buf(hybrid_build_info.CalcOccupiedSize());
+    auto& wt = *new (mapped_buf.data()) HybridWaveletTree{text, alph_size, hybrid_build_info};
+
+    std::vector<size_t> symb_ctr(alph_size);
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (i % 100 == 0) {
+            const size_t symb = gen() % alph_size;
+            ASSERT_EQ(wt.GetRank(symb, i), symb_ctr[symb]) << i;
+        }
+        ASSERT_EQ(wt.Select(text[i], symb_ctr[text[i]]++), i);
+    }
+}
+
+TEST(WAVELET_TREE, FIRST_RANK_MANUAL) {
+    //             0  1  2  3   4  5  6  7
+    TestText text{{1, 2, 4, 4, 10, 3, 3, 2}};
+
     auto build_info = WaveletTree::PrepareBuild(text, 16);
     std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
     auto& wt = *new (mapped_buf.data()) WaveletTree{text, 10, build_info};
 
-    ASSERT_EQ(wt.Select(1, 0), 0);
-    ASSERT_EQ(wt.Select(2, 0), 1);
-    ASSERT_EQ(wt.Select(2, 1), 7);
-    ASSERT_EQ(wt.Select(3, 0), 5);
-    ASSERT_EQ(wt.Select(3, 1), 6);
-    ASSERT_EQ(wt.Select(4, 0), 2);
-    ASSERT_EQ(wt.Select(4, 1), 3);
-    ASSERT_EQ(wt.Select(10, 0), 4);
+    using Res = std::pair<WaveletTree::size_t, bool>;
+    ASSERT_EQ(wt.GetFirstRank(2, 4, 0, 8), Res(1, true));
+    ASSERT_EQ(wt.GetFirstRank(2, 4, 2, 8), Res(7, true));
+    ASSERT_EQ(wt.GetFirstRank(2, 4, 2, 7), Res());
+    ASSERT_EQ(wt.GetFirstRank(10, 4, 0, 8), Res(4, true));
+
+    // Prefix 0b001* - symbols 2 and 3, the least symbol is found
+    ASSERT_EQ(wt.GetFirstRank(0b0010, 3, 2, 8), Res(7, true));
+    ASSERT_EQ(wt.GetFirstRank(0b0010, 3, 2, 7), Res(5, true));
+}
+
+TEST(WAVELET_TREE, FIRST_RANKS_FUSED) {
+    using size_t = WaveletTree::size_t;
+    using Res = std::pair<size_t, bool>;
+
+    std::mt19937_64 gen{0xF05};
+
+    // 6-mers with 3-bit symbols, queries of offsets k have prefixes of 3 * k bits
+    const size_t d = 6;
+    const size_t alph_size = 1u << (3 * d);
+    TestText text;
+    text.resize(20000);
+    for (auto& symb : text) {
+        symb = gen() % alph_size;
+    }
+
+    for (bool with_select_table : {false, true}) {
+        auto build_info = WaveletTree::PrepareBuild(text, alph_size, with_select_table);
+        std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+        auto& wt = *new (mapped_buf.data()) WaveletTree{text, alph_size, build_info};
+
+        for (unsigned i_query = 0; i_query < 1000; ++i_query) {
+            WaveletTree::FirstRankQuery queries[d];
+            for (size_t k = 0; k < d; ++k) {
+                // Short ranges, like SA intervals of long patterns
+                const size_t l_pos = gen() % (text.size() + 1);
+                const size_t range_size = std::min<size_t>(text.size() - l_pos, gen() % 100);
+                const size_t val =
+                    range_size && k % 2 ? text[l_pos + gen() % range_size] : gen() % alph_size;
+                queries[k] = {val, u8(3 * k), l_pos, l_pos + range_size};
+            }
+
+            Res res[d];
+            wt.GetFirstRanks(queries, d, res);
+            for (size_t k = 0; k < d; ++k) {
+                const auto& query = queries[k];
+                ASSERT_EQ(res[k], wt.GetFirstRank(query.val, query.signif_bit_len, query.l_pos,
+                                                  query.r_pos));
+            }
+        }
+    }
+}
+
+TEST(WAVELET_TREE, FIRST_RANK_IN_RANGE) {
+    using size_t = WaveletTree::size_t;
+    using Res = std::pair<size_t, bool>;
+
+    std::mt19937_64 gen{0xF06};
+
+    // Alphabet is not power of 2, ends of ranges may be after it
+    const size_t alph_size = 100;
+    TestText text;
+    text.resize(5000);
+    for (auto& symb : text) {
+        symb = gen() % 3 ? gen() % 20 : gen() % alph_size;
+    }
+
+    for (bool with_select_table : {false, true}) {
+        auto build_info = WaveletTree::PrepareBuild(text, alph_size, with_select_table);
+        std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+        auto& wt = *new (mapped_buf.data()) WaveletTree{text, alph_size, build_info};
+
+        for (unsigned i_query = 0; i_query < 300; ++i_query) {
+            constexpr std::size_t num_queries = WaveletTree::c_max_fused_queries;
+            WaveletTree::FirstRankInRangeQuery queries[num_queries];
+            Res refs[num_queries];
+            for (std::size_t i = 0; i < num_queries; ++i) {
+                const uint64_t val_begin = gen() % (alph_size + 10);
+                const uint64_t val_end = val_begin + gen() % 40;
+                const size_t l_pos = gen() % (text.size() + 1);
+                const size_t r_pos = l_pos + std::min<size_t>(text.size() - l_pos, gen() % 200);
+                queries[i] = {val_begin, val_end, l_pos, r_pos};
+
+                // The least symbol and its first position
+                refs[i] = {};
+                for (size_t pos = l_pos; pos < r_pos; ++pos) {
+                    if (val_begin <= text[pos] && text[pos] < val_end &&
+                        (!refs[i].second || text[pos] < text[refs[i].first])) {
+                        refs[i] = {pos, true};
+                    }
+                }
+
+                ASSERT_EQ(wt.GetFirstRankInRange(val_begin, val_end, l_pos, r_pos), refs[i]);
+            }
+
+            Res res[num_queries];
+            wt.GetFirstRanksInRange(queries, num_queries, res);
+            for (std::size_t i = 0; i < num_queries; ++i) {
+                ASSERT_EQ(res[i], refs[i]) << i;
+            }
+        }
+    }
+}
+
+TEST(WAVELET_TREE, RANGE_QUERIES) {
+    using size_t = WaveletTree::size_t;
+    using Res = std::vector<std::pair<size_t, size_t>>;
+
+    std::mt19937_64 gen{0xD15};
+
+    for (size_t alph_size : {2u, 7u, 64u, 1000u}) {
+        TestText text;
+        text.resize(3000);
+        for (auto& symb : text) {
+            symb = gen() % 4 ? gen() % std::min(alph_size, 5u) : gen() % alph_size;
+        }
+
+        auto build_info = WaveletTree::PrepareBuild(text, alph_size);
+        std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+        auto& wt = *new (mapped_buf.data()) WaveletTree{text, alph_size, build_info};
+
+        for (unsigned i_query = 0; i_query < 300; ++i_query) {
+            const size_t l_pos = gen() % (text.size() + 1);
+            const size_t r_pos = l_pos + gen() % (text.size() + 1 - l_pos);
+
+            std::vector<size_t> symbs(text.begin() + l_pos, text.begin() + r_pos);
+            std::sort(symbs.begin(), symbs.end());
+
+            Res distinct;
+            for (auto symb : symbs) {
+                if (distinct.empty() || distinct.back().first != symb) {
+                    distinct.emplace_back(symb, 0);
+                }
+                ++distinct.back().second;
+            }
+            ASSERT_EQ(wt.RangeDistinct(l_pos, r_pos), distinct);
+
+            if (l_pos < r_pos) {
+                const size_t k = gen() % (r_pos - l_pos);
+                ASSERT_EQ(wt.RangeQuantile(l_pos, r_pos, k), symbs[k]);
+            }
+
+            // Symbols with equal frequencies are in any order
+            const size_t k = gen() % 5;
+            auto top = wt.RangeTopK(l_pos, r_pos, k);
+            ASSERT_EQ(top.size(), std::min<std::size_t>(k, distinct.size()));
+            std::stable_sort(distinct.begin(), distinct.end(),
+                             [](auto lhs, auto rhs) { return lhs.second > rhs.second; });
+            for (size_t i = 0; i < top.size(); ++i) {
+                ASSERT_EQ(top[i].second, distinct[i].second);
+                ASSERT_EQ(std::count(text.begin() + l_pos, text.begin() + r_pos, top[i].first),
+                          top[i].second);
+            }
+        }
+    }
+}
+
+template <typename WaveletTreeT>
+void TestParallelBuild() {
+    std::mt19937_64 gen{0xB11D};
+
+    // Several chunks, levels split between threads and not split
+    for (unsigned alph_size : {6u, 3000u}) {
+        TestText text;
+        text.resize(1'200'000);
+        for (auto& symb : text) {
+            symb = gen() % 3 ? gen() % 4 : gen() % alph_size;
+        }
+
+        for (bool with_select_table : {false, true}) {
+            auto build_info = WaveletTreeT::PrepareBuild(text, alph_size, with_select_table, 1);
+            std::vector<u8> mapped_buf(build_info.CalcOccupiedSize());
+            new (mapped_buf.data()) WaveletTreeT{text, alph_size, build_info};
+
+            for (unsigned num_threads : {3u, 7u}) {
+                auto par_build_info =
+                    WaveletTreeT::PrepareBuild(text, alph_size, with_select_table, num_threads);
+                std::vector<u8> par_mapped_buf(par_build_info.CalcOccupiedSize());
+                new (par_mapped_buf.data()) WaveletTreeT{text, alph_size, par_build_info};
+
+                ASSERT_EQ(par_mapped_buf, mapped_buf) << alph_size << ' ' << num_threads;
+            }
+        }
+    }
+}
+
+TEST(WAVELET_TREE, PARALLEL_BUILD) {
+    TestParallelBuild<WaveletTree>();
+    TestParallelBuild<BasicWaveletTree<BitVector>>();
+    TestParallelBuild<HybridWaveletTree>();
 }
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "bitvector.hpp"
+
+/*
+    Wavelet matrix: level i keeps i-th bit (from high) of symbols, symbols of level i + 1 are
+    symbols of level i stable partitioned by this bit (zeros first). Every level is one bit vector
+    and number of zeros, so query reads one region of memory per level.
+*/
+template <typename BitVectorT>
+class alignas(8) BasicWaveletMatrix {
+public:
+    using size_t = uint32_t;
+
+    class BuildInfo {
+    public:
+        BuildInfo(size_t num_levels, size_t bv_pos_begin, size_t occup_size)
+            : m_num_levels{num_levels}
+            , m_bv_pos_begin{bv_pos_begin}
+            , m_occup_size{occup_size} {}
+
+        size_t CalcOccupiedSize() const noexcept {
+            return m_occup_size;
+        }
+
+        size_t GetNumLevels() const noexcept {
+            return m_num_levels;
+        }
+
+        size_t GetBitVectorPosBegin() const noexcept {
+            return m_bv_pos_begin;
+        }
+
+    private:
+        size_t m_num_levels;
+        size_t m_bv_pos_begin;
+        size_t m_occup_size;
+    };
+
+    template <typename NumberAccessorT>
+    static BuildInfo PrepareBuild(const NumberAccessorT& text, size_t alph_size) {
+        const size_t num_levels = Log2Up(alph_size - 1);
+
+        // Bit vectors are aligned by cache line
+        size_t bv_pos_begin = sizeof(BasicWaveletMatrix) + num_levels * sizeof(size_t);
+        bv_pos_begin = AlignPos(bv_pos_begin, 64);
+
+        const size_t occup_size =
+            bv_pos_begin + num_levels * BitVectorT::CalcOccupiedSize(text.Size());
+
+        std::cout << "num lvl: " << num_levels << ", "
+                  << "occ size: " << occup_size / 1000'000 << std::endl;
+
+        return {num_levels, bv_pos_begin, occup_size};
+    }
+
+    template <typename NumberAccessorT>
+    BasicWaveletMatrix(const NumberAccessorT& text, size_t alph_size, const BuildInfo& build_info)
+        : m_num_levels{build_info.GetNumLevels()}
+        , m_size{(size_t)text.Size()}
+        , m_bv_pos_begin{build_info.GetBitVectorPosBegin()}
+        , m_bv_occup_size{BitVectorT::CalcOccupiedSize(m_size)} {
+        // Levels are counted by PrepareBuild, alphabet of constructor must be the same
+        if (m_num_levels != Log2Up(alph_size - 1)) {
+            throw std::invalid_argument{"WM: alph_size differs from alph_size of PrepareBuild"};
+        }
+
+        // Symbols in order of level
+        std::vector<size_t> symbs(m_size), next_symbs(m_size);
+        for (size_t i = 0; i < m_size; ++i) {
+            symbs[i] = text[i];
+        }
+
+        size_t* zero_nums = GetZeroNums();
+        for (size_t i_lvl = 0; i_lvl < m_num_levels; ++i_lvl) {
+            auto& bv = *new (GetBitVectorPtr(i_lvl)) BitVectorT{m_size};
+
+            size_t num_zeros = 0;
+            for (size_t i = 0; i < m_size; ++i) {
+                const bool bit = GetBit(symbs[i], i_lvl);
+                bv.Set(i, bit);
+                num_zeros += !bit;
+            }
+            bv.Reinit();
+            zero_nums[i_lvl] = num_zeros;
+
+            size_t zero_pos = 0, one_pos = num_zeros;
+            for (auto symb : symbs) {
+                next_symbs[GetBit(symb, i_lvl) ? one_pos++ : zero_pos++] = symb;
+            }
+            symbs.swap(next_symbs);
+        }
+    }
+
+    size_t GetRank(size_t val, size_t pos) const {
+        size_t begin = 0;
+        for (size_t i_lvl = 0; i_lvl < m_num_levels && begin != pos; ++i_lvl) {
+            const bool bit = GetBit(val, i_lvl);
+            begin = GetNextPos(i_lvl, begin, bit);
+            pos = GetNextPos(i_lvl, pos, bit);
+        }
+
+        return pos - begin;
+    }
+
+    // The same as WaveletTree::GetFirstRank: first position in [l_pos, r_pos) of the least symbol
+    // with first signif_bit_len bits of val
+    // Res: {pos, is_finded}
+    std::pair<size_t, bool> GetFirstRank(size_t val, u8 signif_bit_len, size_t l_pos,
+                                         size_t r_pos) const {
+        assert(signif_bit_len <= m_num_levels);
+
+        const size_t shift = m_num_levels - signif_bit_len;
+        const uint64_t val_begin = uint64_t(val >> shift) << shift;
+        return GetFirstRankInRange(val_begin, val_begin + (uint64_t{1} << shift), l_pos, r_pos);
+    }
+
+    // First position in [l_pos, r_pos) of the least symbol of [val_begin, val_end)
+    // Res: {pos, is_finded}
+    std::pair<size_t, bool> GetFirstRankInRange(uint64_t val_begin, uint64_t val_end, size_t l_pos,
+                                                size_t r_pos) const {
+        if (val_begin >= val_end) {
+            return {};
+        }
+        return FindLeast(0, 0, val_begin, val_end, l_pos, r_pos);
+    }
+
+    // Position of pos-th val, pos from 0
+    // val - must exist, else UB
+    size_t Select(size_t val, size_t pos) const {
+        size_t begin = 0;
+        for (size_t i_lvl = 0; i_lvl < m_num_levels; ++i_lvl) {
+            begin = GetNextPos(i_lvl, begin, GetBit(val, i_lvl));
+        }
+
+        return GetTextPos(begin + pos);
+    }
+
+    void Dump() const {
+        for (size_t i_lvl = 0; i_lvl < m_num_levels; ++i_lvl) {
+            const auto& bv = GetBitVector(i_lvl);
+            for (size_t i_bit = 0; i_bit < bv.Size(); ++i_bit) {
+                putchar(bv.Get(i_bit) ? '1' : '0');
+
+                if (i_bit + 1 < bv.Size()) {
+                    putchar(i_bit + 1 == GetZeroNums()[i_lvl] ? '\'' : ' ');
+                }
+            }
+            putchar('\n');
+        }
+    }
+
+private:
+    bool GetBit(size_t val, size_t i_lvl) const noexcept {
+        return (val >> (m_num_levels - 1 - i_lvl)) & 1u;
+    }
+
+    // Position on next level of symbol, that is at pos of level, if bit is its bit
+    size_t GetNextPos(size_t i_lvl, size_t pos, bool bit) const noexcept {
+        const size_t one_rank = GetBitVector(i_lvl).GetRank(pos);
+        return bit ? GetZeroNums()[i_lvl] + one_rank : pos - one_rank;
+    }
+
+    // Node of level i_lvl - symbols with prefix val_prefix, [l_pos, r_pos) - range of level
+    std::pair<size_t, bool> FindLeast(size_t i_lvl, uint64_t val_prefix, uint64_t val_begin,
+                                      uint64_t val_end, size_t l_pos, size_t r_pos) const {
+        const size_t shift = m_num_levels - i_lvl;
+        if (l_pos == r_pos || (val_prefix + 1) << shift <= val_begin ||
+            val_end <= val_prefix << shift) {
+            return {};
+        }
+
+        if (i_lvl == m_num_levels) {
+            return {GetTextPos(l_pos), true};
+        }
+
+        const auto& bv = GetBitVector(i_lvl);
+        const size_t l_one_rank = bv.GetRank(l_pos);
+        const size_t r_one_rank = bv.GetRank(r_pos);
+
+        auto res = FindLeast(i_lvl + 1, 2 * val_prefix, val_begin, val_end, l_pos - l_one_rank,
+                             r_pos - r_one_rank);
+        if (!res.second) {
+            const size_t num_zeros = GetZeroNums()[i_lvl];
+            res = FindLeast(i_lvl + 1, 2 * val_prefix + 1, val_begin, val_end,
+                            num_zeros + l_one_rank, num_zeros + r_one_rank);
+        }
+        return res;
+    }
+
+    // Position in text of symbol, that is at pos of last level
+    size_t GetTextPos(size_t pos) const noexcept {
+        for (size_t i_lvl = m_num_levels; i_lvl-- > 0;) {
+            const size_t num_zeros = GetZeroNums()[i_lvl];
+            const auto& bv = GetBitVector(i_lvl);
+            pos = pos < num_zeros ? bv.Select0(pos) : bv.Select1(pos - num_zeros);
+        }
+        return pos;
+    }
+
+    size_t* GetZeroNums() noexcept {
+        return (size_t*)(this + 1);
+    }
+    const size_t* GetZeroNums() const noexcept {
+        return (const size_t*)(this + 1);
+    }
+
+    BitVectorT* GetBitVectorPtr(size_t i_lvl) noexcept {
+        return (BitVectorT*)((u8*)this + m_bv_pos_begin + i_lvl * m_bv_occup_size);
+    }
+    const BitVectorT& GetBitVector(size_t i_lvl) const noexcept {
+        return *(const BitVectorT*)((const u8*)this + m_bv_pos_begin + i_lvl * m_bv_occup_size);
+    }
+
+private:
+    size_t m_num_levels;
+    size_t m_size;
+    size_t m_bv_pos_begin;
+    size_t m_bv_occup_size;
+};
+
+using WaveletMatrix = BasicWaveletMatrix<BitVectorInterleaved>;
@@ -1,7 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <execution>
+#include <iostream>
+#include <numeric>
+#include <queue>
+#include <thread>
+#include <vector>
 #include "bitvector.hpp"
+#include "bitvector_rrr.hpp"
 
 // 110 -> 011
 template <typename U>
@@ -15,6 +23,20 @@ U reverse(U val, std::size_t bit_len) {
     return rev;
 }
 
+// Number of every symbol of text, alph_size is rounded up to power of 2
+template <typename NumberAccessorT>
+std::vector<uint32_t> CalcSymbFreq(const NumberAccessorT& text, uint32_t alph_size) {
+    std::vector<uint32_t> symb_freq(1u << Log2Up(alph_size - 1));
+    const auto size = text.Size();
+    for (std::size_t i = 0; i < size; ++i) {
+        auto value = text[i];
+        assert(value < symb_freq.size());
+
+        ++symb_freq[value];
+    }
+    return symb_freq;
+}
+
 class WaveletTreeNaive {
 public:
     using size_t = uint32_t;
@@ -44,20 +66,30 @@ private:
     std::vector<size_t> m_buf;
 };
 
-class alignas(8) WaveletTree {
+template <typename BitVectorT>
+class alignas(8) BasicWaveletTree {
 public:
     using size_t = uint32_t;
 
+    using BitVectorSummaryT = typename BitVectorSummary<BitVectorT>::type;
+
+    // Queries of one GetFirstRanks, d is up to 8
+    constexpr static std::size_t c_max_fused_queries = 16;
+
     class BuildInfo {
     public:
-        BuildInfo(std::vector<size_t> symb_freq, std::vector<size_t> bv_sizes, size_t bv_pos_begin,
-                  size_t select_alph_pos_begin, size_t select_table_pos_begin, size_t occup_size)
+        BuildInfo(std::vector<size_t> symb_freq, std::vector<size_t> bv_sizes,
+                  std::vector<BitVectorSummaryT> bv_summaries, size_t bv_pos_begin,
+                  size_t select_alph_pos_begin, size_t select_table_pos_begin, size_t occup_size,
+                  unsigned num_threads)
             : m_symb_freq{std::move(symb_freq)}
             , m_bv_sizes{std::move(bv_sizes)}
+            , m_bv_summaries{std::move(bv_summaries)}
             , m_bv_pos_begin{bv_pos_begin}
             , m_select_alph_pos_begin{select_alph_pos_begin}
             , m_select_table_pos_begin{select_table_pos_begin}
-            , m_occup_size{occup_size} {}
+            , m_occup_size{occup_size}
+            , m_num_threads{num_threads} {}
 
         size_t CalcOccupiedSize() const noexcept {
             return m_occup_size;
@@ -71,6 +103,10 @@ public:
             return m_bv_sizes;
         }
 
+        const std::vector<BitVectorSummaryT>& GetBitVectorSummaries() const noexcept {
+            return m_bv_summaries;
+        }
+
         size_t GetBitVectorPosBegin() const noexcept {
             return m_bv_pos_begin;
         }
@@ -83,28 +119,36 @@ public:
             return m_select_table_pos_begin;
         }
 
+        bool HasSelectTable() const noexcept {
+            return m_select_alph_pos_begin;
+        }
+
+        unsigned GetNumThreads() const noexcept {
+            return m_num_threads;
+        }
+
     private:
         std::vector<size_t> m_symb_freq;
         std::vector<size_t> m_bv_sizes;
+        std::vector<BitVectorSummaryT> m_bv_summaries;
         size_t m_bv_pos_begin;
         size_t m_select_alph_pos_begin;
         size_t m_select_table_pos_begin;
         size_t m_occup_size;
+        unsigned m_num_threads;
     };
 
+    // Select table (4 bytes per symbol) accelerates Select, without it Select walks bit vectors.
+    // num_threads is used by bit vectors passes of PrepareBuild and constructor
     template <typename NumberAccessorT>
-    static BuildInfo PrepareBuild(const NumberAccessorT& text, size_t alph_size) {
+    static BuildInfo PrepareBuild(const NumberAccessorT& text, size_t alph_size,
+                                  bool with_select_table = false,
+                                  unsigned num_threads = std::thread::hardware_concurrency()) {
         const auto size = text.Size();
 
         const auto num_levels = Log2Up(alph_size - 1);
-        alph_size = 1u << num_levels;
-        std::vector<size_t> symb_freq(alph_size);
-        for (size_t i = 0; i < size; ++i) {
-            auto value = text[i];
-            assert(value < alph_size);
-
-            ++symb_freq[value];
-        }
+        std::vector<size_t> symb_freq = CalcSymbFreq(text, alph_size);
+        alph_size = symb_freq.size();
 
         std::vector<size_t> bv_sizes((1u << num_levels) - 1);
         size_t i_begin_last_lvl = (1u << (num_levels - 1)) - 1;
@@ -118,33 +162,53 @@ public:
             bv_sizes[i] = bv_sizes[left_child_pos] + bv_sizes[left_child_pos + 1];
         }
 
-        size_t bv_pos_begin = sizeof(WaveletTree) + bv_sizes.size() * sizeof(bv_sizes[0]);
-        bv_pos_begin = AlignPos(bv_pos_begin);
+        // Size of compressed bit vector depends on bits, they are read by extra pass over text
+        std::vector<BitVectorSummaryT> bv_summaries(bv_sizes.begin(), bv_sizes.end());
+        if constexpr (requires(BitVectorSummaryT summary) { summary.AddWord(uint64_t{}); }) {
+            ForEachBitVectorWord(
+                text, num_levels, bv_sizes.size(), num_threads,
+                [](std::size_t, const size_t*, std::size_t) {},
+                [&](size_t i_bv, size_t, uint64_t word) {
+                    bv_summaries[i_bv].AddWord(word);
+                });
+        }
+
+        // Bit vectors are aligned by cache line
+        size_t bv_pos_begin = sizeof(BasicWaveletTree) + bv_sizes.size() * sizeof(bv_sizes[0]);
+        bv_pos_begin = AlignPos(bv_pos_begin, 64);
 
-        size_t select_alph_pos_begin = bv_pos_begin;
-        for (auto bv_size : bv_sizes) {
-            select_alph_pos_begin += BitVector::CalcOccupiedSize(bv_size);
+        size_t bv_pos_end = bv_pos_begin;
+        for (const auto& bv_summary : bv_summaries) {
+            bv_pos_end += BitVectorT::CalcOccupiedSize(bv_summary);
         }
-        select_alph_pos_begin = AlignPos(select_alph_pos_begin);
+        bv_pos_end = AlignPos(bv_pos_end);
 
-        size_t select_table_pos_begin = select_alph_pos_begin + alph_size * sizeof(size_t);
-        select_table_pos_begin = AlignPos(select_table_pos_begin);
+        size_t select_alph_pos_begin = 0;
+        size_t select_table_pos_begin = 0;
+        size_t occup_size = bv_pos_end;
+        if (with_select_table) {
+            select_alph_pos_begin = bv_pos_end;
 
-        size_t occup_size = select_table_pos_begin + sizeof(size_t) * size;
+            select_table_pos_begin = select_alph_pos_begin + alph_size * sizeof(size_t);
+            select_table_pos_begin = AlignPos(select_table_pos_begin);
+
+            occup_size = select_table_pos_begin + sizeof(size_t) * size;
+        }
 
         std::cout << "num lvl: " << num_levels << ", "
-                  << "bitvectors: " << (select_alph_pos_begin - bv_pos_begin) / 1000'000 << ", "
-                  << "alph pos: " << (select_table_pos_begin - select_alph_pos_begin)  / 1000'000 << ", "
+                  << "bitvectors: " << (bv_pos_end - bv_pos_begin) / 1000'000 << ", "
+                  << "select: " << (occup_size - bv_pos_end) / 1000'000 << ", "
                   << "occ size: " << occup_size / 1000'000 << std::endl;
 
-        return {std::move(symb_freq),  std::move(bv_sizes),    bv_pos_begin,
-                select_alph_pos_begin, select_table_pos_begin, occup_size};
+        return {std::move(symb_freq),  std::move(bv_sizes),    std::move(bv_summaries),
+                bv_pos_begin,          select_alph_pos_begin,  select_table_pos_begin,
+                occup_size,            num_threads};
     }
 
     template <typename NumberAccessorT>
-    WaveletTree(const NumberAccessorT& text, size_t alph_size, const BuildInfo& build_info) {
-        const auto& bv_sizes = build_info.GetBitVectorSizes();
-        const auto num_bv = bv_sizes.size();
+    BasicWaveletTree(const NumberAccessorT& text, size_t alph_size, const BuildInfo& build_info) {
+        const auto& bv_summaries = build_info.GetBitVectorSummaries();
+        const auto num_bv = bv_summaries.size();
 
         m_select_alph_pos_begin = build_info.GetSelectAlphPosBegin();
         m_select_table_pos_begin = build_info.GetSelectTablePosBegin();
@@ -153,58 +217,51 @@ public:
         size_t* bv_poss = GetBitVectorPoss();
         bv_poss[0] = build_info.GetBitVectorPosBegin();
         for (size_t i = 1; i < num_bv; ++i) {
-            auto prev_bv_size = BitVector::CalcOccupiedSize(bv_sizes[i - 1]);
+            auto prev_bv_size = BitVectorT::CalcOccupiedSize(bv_summaries[i - 1]);
             bv_poss[i] = bv_poss[i - 1] + prev_bv_size;
         }
 
         // Construct bit vectors
         for (size_t i = 0; i < num_bv; ++i) {
             assert(!((uint64_t)GetBitVectorPtr(i) & 0b111u));
-            new (GetBitVectorPtr(i)) BitVector{bv_sizes[i]};
+            new (GetBitVectorPtr(i)) BitVectorT{bv_summaries[i]};
         }
 
         // Fill setect alph
-        size_t* select_alph = GetSelectAlph();
+        const bool has_select_table = build_info.HasSelectTable();
         const auto& freq_table = build_info.GetSymbFreq();
-        select_alph[0] = m_select_table_pos_begin;
-        for (size_t i = 1; i < freq_table.size(); ++i) {
-            select_alph[i] = select_alph[i - 1] + freq_table[i - 1] * sizeof(size_t);
+        if (has_select_table) {
+            size_t* select_alph = GetSelectAlph();
+            select_alph[0] = m_select_table_pos_begin;
+            for (size_t i = 1; i < freq_table.size(); ++i) {
+                select_alph[i] = select_alph[i - 1] + freq_table[i - 1] * sizeof(size_t);
+            }
         }
 
-        std::vector<size_t> in_sel_pos(freq_table.size());
-
-        // Fill bit vectors and select
-        std::vector<size_t> in_bv_pos(num_bv);
+        std::vector<size_t> in_sel_pos(has_select_table ? freq_table.size() : 0);
 
         const auto num_levels = Log2Up(alph_size - 1);
         m_num_levels = num_levels;
-        const auto text_size = text.Size();
-        for (size_t i = 0; i < text_size; ++i) {
-            const auto val = text[i];
-
-            size_t bit_pos = 1u << (m_num_levels - 1);
-            size_t i_bv = 0;
-            for (size_t i_lvl = 0; i_lvl < num_levels; ++i_lvl) {
-                const bool bit = !!(val & bit_pos);
-                bit_pos >>= 1;
-
-                auto& bv = GetBitVector(i_bv);
-                bv.Set(in_bv_pos[i_bv]++, bit);
-
-                i_bv = GetChildPos(i_bv, bit);
-            }
 
-            GetSelectTable(val)[in_sel_pos[val]++] = i;
-        }
-
-        for (size_t i = 0; i < num_bv; ++i) {
-            assert(in_bv_pos[i] == bv_sizes[i]);
-        }
-
-        for (size_t i_bv = 0; i_bv < num_bv; ++i_bv) {
-            auto& bv = GetBitVector(i_bv);
-            bv.Reinit();
-        }
+        // Fill bit vectors and select
+        ForEachBitVectorWord(
+            text, num_levels, num_bv, build_info.GetNumThreads(),
+            [&](std::size_t chunk_begin, const size_t* chunk, std::size_t chunk_size) {
+                if (has_select_table) {
+                    for (size_t i = 0; i < chunk_size; ++i) {
+                        GetSelectTable(chunk[i])[in_sel_pos[chunk[i]]++] = chunk_begin + i;
+                    }
+                }
+            },
+            [&](size_t i_bv, size_t i_word, uint64_t word) {
+                GetBitVector(i_bv).SetWord(i_word, word);
+            });
+
+        std::vector<size_t> bv_idxs(num_bv);
+        std::iota(bv_idxs.begin(), bv_idxs.end(), 0);
+        std::for_each(std::execution::par, bv_idxs.begin(), bv_idxs.end(), [&](size_t i_bv) {
+            GetBitVector(i_bv).Reinit();
+        });
     }
 
     size_t GetRank(size_t val, size_t pos) const {
@@ -233,6 +290,23 @@ public:
         return rank;
     }
 
+    // Symbol at pos and number of this symbol before pos (LF step of FM-index)
+    // Res: {symb, rank}
+    std::pair<size_t, size_t> GetSymbRank(size_t pos) const {
+        size_t i_bv = 0, symb = 0;
+        for (size_t i_lvl = 0; i_lvl < m_num_levels; ++i_lvl) {
+            const auto& bv = GetBitVector(i_bv);
+            const bool bit = bv.Get(pos);
+            const size_t one_rank = bv.GetRank(pos);
+
+            pos = bit ? one_rank : pos - one_rank;
+            symb = (symb << 1) | bit;
+            i_bv = GetChildPos(i_bv, bit);
+        }
+
+        return {symb, pos};
+    }
+
     // m_num_levels = 4
     // input: val = C***, signif_bit_len = 1
     // input: val = CA**, signif_bit_len = 2
@@ -298,13 +372,323 @@ public:
             return {};
         }
 
-        size_t res_pos = Select(val_path, l_rank + 1);
+        size_t res_pos = Select(val_path, l_rank);
         return {res_pos, res_pos < r_pos};
     }
 
+    // Arguments of GetFirstRank
+    struct FirstRankQuery {
+        size_t val;
+        u8 signif_bit_len;
+        size_t l_pos;
+        size_t r_pos;
+    };
+
+    // GetFirstRank of several queries (up to c_max_fused_queries) in one pass over levels: on
+    // every level blocks of all queries are prefetched before ranks, so their cache misses overlap
+    // Res: {pos, is_finded} of every query
+    void GetFirstRanks(const FirstRankQuery* queries, std::size_t num_queries,
+                       std::pair<size_t, bool>* res) const {
+        assert(num_queries <= c_max_fused_queries);
+
+        size_t i_bvs[c_max_fused_queries];
+        size_t l_ranks[c_max_fused_queries];
+        size_t r_ranks[c_max_fused_queries];
+        size_t val_paths[c_max_fused_queries];
+        for (std::size_t i = 0; i < num_queries; ++i) {
+            assert(queries[i].signif_bit_len <= m_num_levels);
+
+            i_bvs[i] = 0;
+            l_ranks[i] = queries[i].l_pos;
+            r_ranks[i] = queries[i].r_pos;
+            val_paths[i] = 0;
+        }
+
+        // Empty range of rank - query without answer
+        for (size_t i_lvl = 0; i_lvl < m_num_levels; ++i_lvl) {
+            for (std::size_t i = 0; i < num_queries; ++i) {
+                if (l_ranks[i] != r_ranks[i]) {
+                    const auto& bv = GetBitVector(i_bvs[i]);
+                    bv.Prefetch(l_ranks[i]);
+                    bv.Prefetch(r_ranks[i]);
+                }
+            }
+
+            for (std::size_t i = 0; i < num_queries; ++i) {
+                if (l_ranks[i] == r_ranks[i]) {
+                    continue;
+                }
+
+                const auto& bv = GetBitVector(i_bvs[i]);
+                const size_t l_one_rank = bv.GetRank(l_ranks[i]);
+                const size_t r_one_rank = bv.GetRank(r_ranks[i]);
+
+                // Bit of prefix, then the least bit with symbols in range
+                bool bit = false;
+                if (i_lvl < queries[i].signif_bit_len) {
+                    bit = (queries[i].val >> (m_num_levels - 1 - i_lvl)) & 1u;
+                } else {
+                    bit = r_ranks[i] - r_one_rank == l_ranks[i] - l_one_rank;
+                }
+
+                l_ranks[i] = bit ? l_one_rank : l_ranks[i] - l_one_rank;
+                r_ranks[i] = bit ? r_one_rank : r_ranks[i] - r_one_rank;
+                val_paths[i] = (val_paths[i] << 1) | bit;
+                i_bvs[i] = GetChildPos(i_bvs[i], bit);
+            }
+        }
+
+        bool is_finded[c_max_fused_queries];
+        for (std::size_t i = 0; i < num_queries; ++i) {
+            is_finded[i] = l_ranks[i] != r_ranks[i];
+        }
+
+        size_t poss[c_max_fused_queries];
+        std::copy(l_ranks, l_ranks + num_queries, poss);
+        SelectFused(val_paths, is_finded, num_queries, poss);
+
+        for (std::size_t i = 0; i < num_queries; ++i) {
+            res[i] = {};
+            if (is_finded[i]) {
+                res[i] = {poss[i], poss[i] < queries[i].r_pos};
+            }
+        }
+    }
+
+    // Arguments of GetFirstRankInRange
+    struct FirstRankInRangeQuery {
+        uint64_t val_begin;
+        uint64_t val_end;
+        size_t l_pos;
+        size_t r_pos;
+    };
+
+    // First position in [l_pos, r_pos) of the least symbol of [val_begin, val_end)
+    // Res: {pos, is_finded}
+    std::pair<size_t, bool> GetFirstRankInRange(uint64_t val_begin, uint64_t val_end, size_t l_pos,
+                                                size_t r_pos) const {
+        const FirstRankInRangeQuery query{val_begin, val_end, l_pos, r_pos};
+        std::pair<size_t, bool> res;
+        GetFirstRanksInRange(&query, 1, &res);
+        return res;
+    }
+
+    // GetFirstRankInRange of several queries (up to c_max_fused_queries): every round makes one
+    // level step of every query, blocks of round are prefetched as in GetFirstRanks. Query follows
+    // path of val_begin and keeps the deepest nonempty right sibling of path; if path becomes
+    // empty, query goes on from this sibling by the least symbols, so up to 2 * levels steps.
+    // From node, that begins by val_begin, query goes by the least symbols at once
+    // Res: {pos, is_finded} of every query
+    void GetFirstRanksInRange(const FirstRankInRangeQuery* queries, std::size_t num_queries,
+                              std::pair<size_t, bool>* res) const {
+        assert(num_queries <= c_max_fused_queries);
+
+        struct Node {
+            size_t i_lvl;
+            size_t i_bv;
+            size_t l_rank;
+            size_t r_rank;
+            size_t val_path;
+        };
+
+        // Node is on path of val_begin, while query is tight
+        Node nodes[c_max_fused_queries];
+        Node siblings[c_max_fused_queries];
+        bool is_tights[c_max_fused_queries];
+        bool has_siblings[c_max_fused_queries];
+        uint64_t val_ends[c_max_fused_queries];
+        for (std::size_t i = 0; i < num_queries; ++i) {
+            val_ends[i] = std::min(queries[i].val_end, uint64_t{1} << m_num_levels);
+
+            // Empty range of rank - query without answer
+            const bool is_empty = queries[i].val_begin >= val_ends[i];
+            nodes[i] = {0, 0, queries[i].l_pos, is_empty ? queries[i].l_pos : queries[i].r_pos, 0};
+            is_tights[i] = true;
+            has_siblings[i] = false;
+        }
+
+        auto is_active = [&](const Node& node) {
+            return node.l_rank != node.r_rank && node.i_lvl < m_num_levels;
+        };
+
+        for (bool has_active = true; has_active;) {
+            for (std::size_t i = 0; i < num_queries; ++i) {
+                if (is_active(nodes[i])) {
+                    const auto& bv = GetBitVector(nodes[i].i_bv);
+                    bv.Prefetch(nodes[i].l_rank);
+                    bv.Prefetch(nodes[i].r_rank);
+                }
+            }
+
+            has_active = false;
+            for (std::size_t i = 0; i < num_queries; ++i) {
+                auto& node = nodes[i];
+                if (!is_active(node)) {
+                    continue;
+                }
+
+                const auto& bv = GetBitVector(node.i_bv);
+                const size_t l_one_rank = bv.GetRank(node.l_rank);
+                const size_t r_one_rank = bv.GetRank(node.r_rank);
+                const size_t l_zero_rank = node.l_rank - l_one_rank;
+                const size_t r_zero_rank = node.r_rank - r_one_rank;
+
+                // Node begins by val_begin, so its least symbol is the least of range
+                const size_t shift = m_num_levels - 1 - node.i_lvl;
+                if (is_tights[i] && !(queries[i].val_begin & ((uint64_t{2} << shift) - 1))) {
+                    is_tights[i] = false;
+                    has_siblings[i] = false;
+                }
+
+                // Bit of val_begin, then the least bit with symbols in range
+                bool bit = false;
+                if (is_tights[i]) {
+                    bit = (queries[i].val_begin >> shift) & 1u;
+
+                    // Symbols of right sibling are greater than val_begin
+                    const size_t sibling_path = (node.val_path << 1) | 1u;
+                    if (!bit && l_one_rank != r_one_rank &&
+                        (uint64_t(sibling_path) << shift) < val_ends[i]) {
+                        siblings[i] = {node.i_lvl + 1, GetChildPos(node.i_bv, true), l_one_rank,
+                                       r_one_rank, sibling_path};
+                        has_siblings[i] = true;
+                    }
+                } else {
+                    bit = r_zero_rank == l_zero_rank;
+                }
+
+                node = {node.i_lvl + 1, GetChildPos(node.i_bv, bit),
+                        bit ? l_one_rank : l_zero_rank, bit ? r_one_rank : r_zero_rank,
+                        (node.val_path << 1) | bit};
+                if (node.l_rank == node.r_rank && has_siblings[i]) {
+                    node = siblings[i];
+                    is_tights[i] = false;
+                    has_siblings[i] = false;
+                }
+
+                has_active |= is_active(node);
+            }
+        }
+
+        bool is_finded[c_max_fused_queries];
+        size_t val_paths[c_max_fused_queries];
+        size_t poss[c_max_fused_queries];
+        for (std::size_t i = 0; i < num_queries; ++i) {
+            is_finded[i] = nodes[i].l_rank != nodes[i].r_rank && nodes[i].val_path < val_ends[i];
+            val_paths[i] = nodes[i].val_path;
+            poss[i] = nodes[i].l_rank;
+        }
+        SelectFused(val_paths, is_finded, num_queries, poss);
+
+        for (std::size_t i = 0; i < num_queries; ++i) {
+            res[i] = {};
+            if (is_finded[i]) {
+                res[i] = {poss[i], poss[i] < queries[i].r_pos};
+            }
+        }
+    }
+
+    // Every distinct symbol of [l_pos, r_pos) with its number, by increasing symbol
+    // Res: {symbol, frequency}
+    std::vector<std::pair<size_t, size_t>> RangeDistinct(size_t l_pos, size_t r_pos) const {
+        std::vector<std::pair<size_t, size_t>> res;
+        CollectDistinct(0, 0, 0, l_pos, r_pos, res);
+        return res;
+    }
+
+    // k-th least symbol of [l_pos, r_pos), k from 0, must be less then r_pos - l_pos
+    size_t RangeQuantile(size_t l_pos, size_t r_pos, size_t k) const {
+        assert(k < r_pos - l_pos);
+
+        size_t i_bv = 0, val_path = 0;
+        for (size_t i_lvl = 0; i_lvl < m_num_levels; ++i_lvl) {
+            const auto& bv = GetBitVector(i_bv);
+            const size_t l_one_rank = bv.GetRank(l_pos);
+            const size_t r_one_rank = bv.GetRank(r_pos);
+
+            const size_t num_zeros = (r_pos - r_one_rank) - (l_pos - l_one_rank);
+            const bool bit = k >= num_zeros;
+            if (bit) {
+                k -= num_zeros;
+                l_pos = l_one_rank;
+                r_pos = r_one_rank;
+            } else {
+                l_pos -= l_one_rank;
+                r_pos -= r_one_rank;
+            }
+
+            val_path = (val_path << 1) | bit;
+            i_bv = GetChildPos(i_bv, bit);
+        }
+
+        return val_path;
+    }
+
+    // Up to k the most frequent symbols of [l_pos, r_pos) by decreasing frequency. Nodes are
+    // visited by decreasing size of range, so leaf is reached only for symbol of answer
+    // Res: {symbol, frequency}
+    std::vector<std::pair<size_t, size_t>> RangeTopK(size_t l_pos, size_t r_pos, size_t k) const {
+        struct Node {
+            size_t i_bv;
+            size_t i_lvl;
+            size_t val_path;
+            size_t l_pos;
+            size_t r_pos;
+
+            bool operator<(const Node& other) const noexcept {
+                return r_pos - l_pos < other.r_pos - other.l_pos;
+            }
+        };
+
+        std::vector<std::pair<size_t, size_t>> res;
+        std::priority_queue<Node> nodes;
+        if (l_pos < r_pos) {
+            nodes.push({0, 0, 0, l_pos, r_pos});
+        }
+
+        while (!nodes.empty() && res.size() < k) {
+            const Node node = nodes.top();
+            nodes.pop();
+
+            if (node.i_lvl == m_num_levels) {
+                res.emplace_back(node.val_path, node.r_pos - node.l_pos);
+                continue;
+            }
+
+            const auto& bv = GetBitVector(node.i_bv);
+            const size_t l_one_rank = bv.GetRank(node.l_pos);
+            const size_t r_one_rank = bv.GetRank(node.r_pos);
+
+            if (node.l_pos - l_one_rank < node.r_pos - r_one_rank) {
+                nodes.push({GetChildPos(node.i_bv, false), node.i_lvl + 1, node.val_path << 1,
+                            node.l_pos - l_one_rank, node.r_pos - r_one_rank});
+            }
+            if (l_one_rank < r_one_rank) {
+                nodes.push({GetChildPos(node.i_bv, true), node.i_lvl + 1,
+                            (node.val_path << 1) | 1u, l_one_rank, r_one_rank});
+            }
+        }
+
+        return res;
+    }
+
+    // Position of pos-th val, pos from 0
     // val - must exist, else UB
     size_t Select(size_t val, size_t pos) const {
-        return GetSelectTable(val)[pos];
+        if (m_select_alph_pos_begin) {
+            return GetSelectTable(val)[pos];
+        }
+
+        // From leaf to root, node of level is prefix of val
+        for (size_t i_lvl = m_num_levels; i_lvl-- > 0;) {
+            const size_t i_bv = (1u << i_lvl) - 1 + (val >> (m_num_levels - i_lvl));
+            const bool bit = (val >> (m_num_levels - 1 - i_lvl)) & 1u;
+
+            const auto& bv = GetBitVector(i_bv);
+            pos = bit ? bv.Select1(pos) : bv.Select0(pos);
+        }
+
+        return pos;
     }
 
     void Dump() const {
@@ -331,10 +715,209 @@ public:
     }
 
 private:
+    // Symbols of text in memory during build
+    constexpr static size_t c_build_chunk_size = 1u << 20;
+    // Minimal symbols of chunk, that are passed by one thread of level
+    constexpr static size_t c_min_build_part_size = 1u << 14;
+    // Levels up to so many bit vectors are split between threads
+    constexpr static size_t c_max_split_lvl_bv = 1u << 10;
+
     static size_t GetChildPos(size_t parent_pos, bool is_right_child) noexcept {
         return 2 * parent_pos + is_right_child + 1;
     }
 
+    // Positions in text of poss[i]-th symbols val_paths[i] of finded queries, from leaves to root
+    void SelectFused(const size_t* val_paths, const bool* is_finded, std::size_t num_queries,
+                     size_t* poss) const {
+        if (m_select_alph_pos_begin) {
+            for (std::size_t i = 0; i < num_queries; ++i) {
+                if (is_finded[i]) {
+                    poss[i] = GetSelectTable(val_paths[i])[poss[i]];
+                }
+            }
+            return;
+        }
+
+        for (size_t i_lvl = m_num_levels; i_lvl-- > 0;) {
+            for (std::size_t i = 0; i < num_queries; ++i) {
+                if (!is_finded[i]) {
+                    continue;
+                }
+
+                const size_t val = val_paths[i];
+                const size_t i_bv = (1u << i_lvl) - 1 + (val >> (m_num_levels - i_lvl));
+                const bool bit = (val >> (m_num_levels - 1 - i_lvl)) & 1u;
+
+                const auto& bv = GetBitVector(i_bv);
+                poss[i] = bit ? bv.Select1(poss[i]) : bv.Select0(poss[i]);
+            }
+        }
+    }
+
+    // Bits of parts of chunk for one level: bits of part i_part for bit vector j of level are
+    // in words from word_begins[i_part * num_lvl_bv + j]
+    struct LevelParts {
+        std::vector<size_t> bv_sizes;
+        std::vector<size_t> word_begins;
+        std::vector<uint64_t> words;
+    };
+
+    // Bits of bit vectors by 64-bit words: word_func(i_bv, i_word, word) is called for words of
+    // bit vector in order, last word is padded by zeros. Text is read once by chunks,
+    // chunk_func(chunk_begin, chunk, chunk_size) is called before words of chunk. Chunk is
+    // passed level by level, so writes of level are sequential and memory does not depend on
+    // text size. Levels have distinct bit vectors and are passed in parallel. Upper levels (up
+    // to c_max_split_lvl_bv bit vectors) are also split between num_threads: parts of chunk
+    // are counted and filled in parallel, then bits of parts are appended to bit vectors in
+    // parallel by bit vectors. Lower levels are passed by one thread each
+    template <typename NumberAccessorT, typename ChunkFuncT, typename WordFuncT>
+    static void ForEachBitVectorWord(const NumberAccessorT& text, size_t num_levels, size_t num_bv,
+                                     unsigned num_threads, ChunkFuncT&& chunk_func,
+                                     WordFuncT&& word_func) {
+        std::vector<size_t> in_bv_pos(num_bv);
+        std::vector<uint64_t> bv_words(num_bv);
+
+        std::vector<size_t> levels(num_levels);
+        std::iota(levels.begin(), levels.end(), 0);
+
+        const auto text_size = text.Size();
+        std::vector<size_t> chunk(std::min<std::size_t>(text_size, c_build_chunk_size));
+
+        const std::size_t num_parts = std::clamp<std::size_t>(
+            num_threads, 1, std::max<std::size_t>(chunk.size() / c_min_build_part_size, 1));
+        std::vector<size_t> parts(num_parts);
+        std::iota(parts.begin(), parts.end(), 0);
+
+        size_t num_split_levels = 0;
+        while (num_parts > 1 && num_split_levels < num_levels &&
+               (1u << num_split_levels) <= c_max_split_lvl_bv) {
+            ++num_split_levels;
+        }
+        std::vector<LevelParts> levels_parts(num_split_levels);
+
+        // Appends num_bits low bits of word to bit vector i_bv
+        auto append_bits = [&](size_t i_bv, uint64_t word, size_t num_bits) {
+            const size_t pos = in_bv_pos[i_bv];
+            const size_t in_word_pos = pos % 64;
+            bv_words[i_bv] |= word << in_word_pos;
+            if (in_word_pos + num_bits >= 64) {
+                word_func(i_bv, pos / 64, bv_words[i_bv]);
+                bv_words[i_bv] = in_word_pos ? word >> (64 - in_word_pos) : 0;
+            }
+            in_bv_pos[i_bv] += num_bits;
+        };
+
+        auto pass_level = [&](size_t i_lvl, std::size_t chunk_size) {
+            const size_t i_bv_begin = (1u << i_lvl) - 1;
+            const size_t shift = num_levels - 1 - i_lvl;
+            for (size_t i = 0; i < chunk_size; ++i) {
+                const size_t i_bv = i_bv_begin + (uint64_t(chunk[i]) >> (shift + 1));
+                append_bits(i_bv, (chunk[i] >> shift) & 1u, 1);
+            }
+        };
+
+        auto pass_level_by_parts = [&](size_t i_lvl, std::size_t chunk_size) {
+            const size_t num_lvl_bv = 1u << i_lvl;
+            const size_t i_bv_begin = num_lvl_bv - 1;
+            const size_t shift = num_levels - 1 - i_lvl;
+            const std::size_t part_size = (chunk_size + num_parts - 1) / num_parts;
+
+            auto& lvl_parts = levels_parts[i_lvl];
+            lvl_parts.bv_sizes.assign(num_parts * num_lvl_bv, 0);
+            lvl_parts.word_begins.resize(num_parts * num_lvl_bv + 1);
+
+            auto for_each_part_symb = [&](size_t i_part, auto&& func) {
+                const std::size_t end = std::min(chunk_size, (i_part + 1) * part_size);
+                for (std::size_t i = std::min(chunk_size, i_part * part_size); i < end; ++i) {
+                    func(uint64_t(chunk[i]) >> (shift + 1), (chunk[i] >> shift) & 1u);
+                }
+            };
+
+            std::for_each(std::execution::par, parts.begin(), parts.end(), [&](size_t i_part) {
+                size_t* part_bv_sizes = &lvl_parts.bv_sizes[i_part * num_lvl_bv];
+                for_each_part_symb(i_part, [&](size_t j, uint64_t) { ++part_bv_sizes[j]; });
+            });
+
+            lvl_parts.word_begins[0] = 0;
+            for (size_t i = 0; i < num_parts * num_lvl_bv; ++i) {
+                lvl_parts.word_begins[i + 1] =
+                    lvl_parts.word_begins[i] + (lvl_parts.bv_sizes[i] + 63) / 64;
+            }
+            lvl_parts.words.resize(lvl_parts.word_begins.back());
+
+            std::for_each(std::execution::par, parts.begin(), parts.end(), [&](size_t i_part) {
+                const size_t* word_begins = &lvl_parts.word_begins[i_part * num_lvl_bv];
+                std::fill(lvl_parts.words.begin() + word_begins[0],
+                          lvl_parts.words.begin() + word_begins[num_lvl_bv], 0);
+
+                std::vector<size_t> in_part_pos(num_lvl_bv);
+                for_each_part_symb(i_part, [&](size_t j, uint64_t bit) {
+                    const size_t pos = in_part_pos[j]++;
+                    lvl_parts.words[word_begins[j] + pos / 64] |= bit << (pos % 64);
+                });
+            });
+
+            std::vector<size_t> lvl_bvs(num_lvl_bv);
+            std::iota(lvl_bvs.begin(), lvl_bvs.end(), 0);
+            std::for_each(std::execution::par, lvl_bvs.begin(), lvl_bvs.end(), [&](size_t j) {
+                for (size_t i_part = 0; i_part < num_parts; ++i_part) {
+                    size_t num_bits = lvl_parts.bv_sizes[i_part * num_lvl_bv + j];
+                    const uint64_t* words =
+                        &lvl_parts.words[lvl_parts.word_begins[i_part * num_lvl_bv + j]];
+                    for (; num_bits > 0; num_bits -= std::min<size_t>(num_bits, 64)) {
+                        append_bits(i_bv_begin + j, *words++, std::min<size_t>(num_bits, 64));
+                    }
+                }
+            });
+        };
+
+        for (std::size_t chunk_begin = 0; chunk_begin < text_size; chunk_begin += chunk.size()) {
+            const std::size_t chunk_size = std::min(chunk.size(), text_size - chunk_begin);
+            for (size_t i = 0; i < chunk_size; ++i) {
+                chunk[i] = text[chunk_begin + i];
+            }
+            chunk_func(chunk_begin, chunk.data(), chunk_size);
+
+            std::for_each(std::execution::par, levels.begin(), levels.end(), [&](size_t i_lvl) {
+                if (i_lvl < num_split_levels) {
+                    pass_level_by_parts(i_lvl, chunk_size);
+                } else {
+                    pass_level(i_lvl, chunk_size);
+                }
+            });
+        }
+
+        std::vector<size_t> bv_idxs(num_bv);
+        std::iota(bv_idxs.begin(), bv_idxs.end(), 0);
+        std::for_each(std::execution::par, bv_idxs.begin(), bv_idxs.end(), [&](size_t i_bv) {
+            if (in_bv_pos[i_bv] % 64) {
+                word_func(i_bv, in_bv_pos[i_bv] / 64, bv_words[i_bv]);
+            }
+        });
+    }
+
+    // Symbols of not empty ranges of subtree of node i_bv, [l_pos, r_pos) - range of node
+    void CollectDistinct(size_t i_bv, size_t i_lvl, size_t val_path, size_t l_pos, size_t r_pos,
+                         std::vector<std::pair<size_t, size_t>>& res) const {
+        if (l_pos == r_pos) {
+            return;
+        }
+
+        if (i_lvl == m_num_levels) {
+            res.emplace_back(val_path, r_pos - l_pos);
+            return;
+        }
+
+        const auto& bv = GetBitVector(i_bv);
+        const size_t l_one_rank = bv.GetRank(l_pos);
+        const size_t r_one_rank = bv.GetRank(r_pos);
+
+        CollectDistinct(GetChildPos(i_bv, false), i_lvl + 1, val_path << 1, l_pos - l_one_rank,
+                        r_pos - r_one_rank, res);
+        CollectDistinct(GetChildPos(i_bv, true), i_lvl + 1, (val_path << 1) | 1u, l_one_rank,
+                        r_one_rank, res);
+    }
+
     size_t* GetBitVectorPoss() noexcept {
         return (size_t*)(this + 1);
     }
@@ -342,17 +925,17 @@ private:
         return (size_t*)(this + 1);
     }
 
-    BitVector* GetBitVectorPtr(size_t node_pos) noexcept {
-        return (BitVector*)((u8*)this + GetBitVectorPoss()[node_pos]);
+    BitVectorT* GetBitVectorPtr(size_t node_pos) noexcept {
+        return (BitVectorT*)((u8*)this + GetBitVectorPoss()[node_pos]);
     }
-    const BitVector* GetBitVectorPtr(size_t node_pos) const noexcept {
-        return (BitVector*)((u8*)this + GetBitVectorPoss()[node_pos]);
+    const BitVectorT* GetBitVectorPtr(size_t node_pos) const noexcept {
+        return (BitVectorT*)((u8*)this + GetBitVectorPoss()[node_pos]);
     }
 
-    BitVector& GetBitVector(size_t node_pos) noexcept {
+    BitVectorT& GetBitVector(size_t node_pos) noexcept {
         return *GetBitVectorPtr(node_pos);
     }
-    const BitVector& GetBitVector(size_t node_pos) const noexcept {
+    const BitVectorT& GetBitVector(size_t node_pos) const noexcept {
         return *GetBitVectorPtr(node_pos);
     }
 
@@ -375,3 +958,6 @@ private:
     size_t m_select_alph_pos_begin;
     size_t m_select_table_pos_begin;
 };
+
+using WaveletTree = BasicWaveletTree<BitVectorInterleaved>;
+using HybridWaveletTree = BasicWaveletTree<BitVectorHybrid>;